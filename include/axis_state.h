@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ethercat.h"
+#include "pdo_manager.h"
+#include <cstdint>
+#include <vector>
+
+// Aligned structure-of-arrays copy of every drive's cyclic data. unpack()
+// gathers the wire fields of all axes from the process image right after
+// receive. pack() scatters the setpoints back right before send. In between,
+// control code works on 64 byte aligned int32 arrays, one per object, instead
+// of the unaligned packed wire structs. Narrow objects are sign or zero
+// extended to 32 bits.
+class AxisState {
+public:
+    enum TxField { STATUSWORD, ACTUAL_POSITION, ACTUAL_VELOCITY, ACTUAL_TORQUE, MODE_DISPLAY, TX_FIELDS };
+    enum RxField { CONTROLWORD, TARGET_POSITION, TARGET_VELOCITY, TARGET_TORQUE, MODE, RX_FIELDS };
+
+    // One drive: its slave, where its outputs/inputs start relative to the
+    // output and input base and what it maps
+    struct Binding {
+        int slave;
+        int outputs;
+        int inputs;
+        const PDOManager::SlaveMapping* mapping;
+    };
+
+    AxisState() = default;
+    ~AxisState();
+
+    AxisState(const AxisState&) = delete;
+    AxisState& operator=(const AxisState&) = delete;
+
+    // Every slave of the line with a controlword in its outputs becomes an axis.
+    // Outputs are addressed from the image. Inputs are addressed from the
+    // lowest drive input, which may be in a frozen frame's receive buffer.
+    bool bind(ecx_contextt* context, uint8_t* image);
+    bool bind(const std::vector<Binding>& axes, const uint8_t* inputs, uint8_t* outputs);
+
+    void unpack();
+    void pack() const;
+    // Reference kernels, also used when the CPU has no AVX2
+    void unpackScalar();
+    void packScalar() const;
+
+    int count() const { return axes; }
+    int slave(int axis) const { return slaves[axis]; }
+    int32_t* tx(TxField field) { return txValues[field]; }
+    const int32_t* tx(TxField field) const { return txValues[field]; }
+    int32_t* rx(RxField field) { return rxValues[field]; }
+    const int32_t* rx(RxField field) const { return rxValues[field]; }
+
+    // Same setpoint for every axis, or each axis' own feedback as its setpoint
+    void fill(RxField field, int32_t value);
+    void copy(RxField to, TxField from);
+
+    // One axis as wire structs, the UI mirrors them
+    void toTx(int axis, PDOManager::TxPDO& tx) const;
+    void toRx(int axis, PDOManager::RxPDO& rx) const;
+
+    static const char* kernelName();
+    // Time unpack + pack over synthetic lines of 1..200 full layout drives
+    static void benchmark();
+
+private:
+    static const int LANES = 16;  // int32 per AVX-512 register, the arrays are padded to it
+
+    struct FieldMap {
+        uint16_t object;
+        uint8_t size;
+        bool isSigned;
+    };
+    static const FieldMap TX_MAP[TX_FIELDS];
+    static const FieldMap RX_MAP[RX_FIELDS];
+
+    void release();
+
+    int axes = 0;
+    int padded = 0;
+    const uint8_t* inputBase = nullptr;
+    uint8_t* outputBase = nullptr;
+    int32_t* block = nullptr;
+    std::vector<int> slaves;
+    // Per field: values, byte offset of the field in the image and a lane mask
+    // (-1 where the axis maps the field). Axes that do not map a field keep their value.
+    int32_t* txValues[TX_FIELDS] = {};
+    int32_t* txOffsets[TX_FIELDS] = {};
+    int32_t* txMasks[TX_FIELDS] = {};
+    int32_t* rxValues[RX_FIELDS] = {};
+    int32_t* rxOffsets[RX_FIELDS] = {};
+    int32_t* rxMasks[RX_FIELDS] = {};
+};
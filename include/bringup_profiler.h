@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Records timing spans of the EtherCAT bring-up phases and per-slave operations,
+// exported as Chrome trace JSON (chrome://tracing, Perfetto) plus a summary table
+class BringupProfiler {
+public:
+    static BringupProfiler& getInstance() {
+        static BringupProfiler instance;
+        return instance;
+    }
+
+    BringupProfiler(const BringupProfiler&) = delete;
+    BringupProfiler& operator=(const BringupProfiler&) = delete;
+
+    struct Span {
+        std::string name;
+        std::string category;
+        int slave;            // -1 if the span is not slave specific
+        int thread;           // small sequential thread id
+        int64_t startUs;      // relative to reset()
+        int64_t durationUs;
+    };
+
+    // RAII span, recorded when it goes out of scope or end() is called
+    class Scope {
+    public:
+        Scope(const std::string& name, const char* category, int slave = -1);
+        ~Scope() { end(); }
+        void end();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        std::string name;
+        const char* category;
+        int slave;
+        int64_t startUs;
+        bool open;
+    };
+
+    void reset();
+    int64_t nowUs() const;
+    void record(const std::string& name, const char* category, int slave,
+                int64_t startUs, int64_t durationUs);
+
+    bool writeChromeTrace(const std::string& path) const;
+    void printSummary() const;
+
+private:
+    BringupProfiler();
+
+    static int currentThreadId();
+
+    int64_t originUs;
+    std::vector<Span> spans;
+    mutable std::mutex mutex;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// CiA402 drive state machine of every axis, driven by tables. step() reads
+// the statuswords from the axis state, decodes each one into a drive state
+// and looks up the controlword from the command of the axis and that state.
+// It also handles the fault reset edge and the PP new-setpoint handshake.
+// State changes are queued as events for another thread to report, so the
+// cyclic code does no I/O and allocates nothing. Everything except poll()
+// and dropped() belongs to the RT thread.
+class Cia402Fsm {
+public:
+    enum State : uint8_t {
+        NOT_READY,
+        SWITCH_ON_DISABLED,
+        READY_TO_SWITCH_ON,
+        SWITCHED_ON,
+        OPERATION_ENABLED,
+        QUICK_STOP_ACTIVE,
+        FAULT_REACTION_ACTIVE,
+        FAULT,
+        STATES
+    };
+
+    // Where the axis should go
+    enum Command : uint8_t {
+        DISABLE,     // step down to switch on disabled
+        READY,       // hold ready to switch on, e.g. while the mode changes
+        ENABLE,      // reset a fault and step up to operation enabled
+        HOLD,        // keep operation enabled, never step up or reset a fault
+        QUICK_STOP,  // quick stop ramp, then switch on disabled
+        COMMANDS
+    };
+
+    struct Event {
+        enum Type : uint8_t {
+            TRANSITION,
+            SETPOINT_ACKNOWLEDGED,
+            TARGET_REACHED,
+            ENABLE_REFUSED,  // enable requested before the mode was confirmed
+            ENABLE_LOST      // the axis left operation enabled while held there
+        };
+        Type type;
+        uint8_t from;
+        uint8_t to;
+        uint16_t axis;
+        uint16_t statusword;
+        uint16_t controlword;
+        uint32_t cycle;
+    };
+
+    Cia402Fsm() = default;
+    Cia402Fsm(const Cia402Fsm&) = delete;
+    Cia402Fsm& operator=(const Cia402Fsm&) = delete;
+
+    // Size the per-axis tables, outside the cyclic loop. Every axis starts disabled.
+    void resize(int axes);
+    int count() const { return axes; }
+
+    void command(int axis, Command command) { goals[axis] = command; }
+    void commandAll(Command command);
+    // PP: raise controlword bit 4 until the drive acknowledges (statusword bit 12)
+    void newSetpoint(int axis);
+    void newSetpointAll();
+    // Queue an event decided outside step(), with the axis' last state
+    void notify(Event::Type type, int axis);
+
+    // One pass over all axes: statuswords in, controlwords out. Returns the
+    // number of events queued in this pass.
+    int step(const int32_t* statuswords, int32_t* controlwords);
+
+    State state(int axis) const { return (State)states[axis]; }
+    // Aggregates of the last step
+    int countIn(State state) const { return counts[state]; }
+    bool allIn(State state) const { return axes > 0 && counts[state] == axes; }
+    // No axis between ready to switch on and quick stop, i.e. none holds torque
+    bool nonePowered() const { return powered == 0; }
+
+    // Consumer side, any one non-RT thread
+    bool poll(Event& event);
+    uint64_t dropped() const { return droppedEvents.load(); }
+
+    static State decode(uint16_t statusword) { return (State)DECODE[statusIndex(statusword)]; }
+    static const char* stateName(uint8_t state);
+    static const char* commandName(uint8_t command);
+    // Time step() per axis for 1..200 axes, steady and with a transition on every axis
+    static void benchmark();
+
+private:
+    static const int EVENT_CAPACITY = 256;  // power of two
+    static const uint8_t SETPOINT_PENDING = 0x01;
+    static const uint8_t MOVING = 0x02;  // setpoint acknowledged, target not reached yet
+    static const uint8_t SETPOINT_REPEAT = 0x04;  // target changed while bit 4 was up
+
+    // Statusword bits 0-3, 5 and 6 make the state, packed into 6 bits
+    static int statusIndex(uint16_t statusword) { return (statusword & 0x0F) | ((statusword & 0x60) >> 1); }
+
+    static const uint8_t* buildDecodeTable();
+    static const uint8_t* const DECODE;
+    static const uint16_t CONTROL[COMMANDS][STATES];
+    static const uint8_t POWERED[STATES];
+
+    void push(Event::Type type, int axis, uint8_t from, uint8_t to, uint16_t statusword, uint16_t controlword);
+
+    int axes = 0;
+    uint32_t cycle = 0;
+    std::vector<uint8_t> goals;
+    std::vector<uint8_t> states;
+    std::vector<uint8_t> flags;
+    std::vector<uint16_t> lastControl;
+    int counts[STATES] = {};
+    int powered = 0;
+
+    // Single producer (RT thread), single consumer
+    Event events[EVENT_CAPACITY];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint64_t> droppedEvents{0};
+};
@@ -16,7 +16,12 @@ public:
         return instance;
     }
 
+    // Context-less forms work on the default line with a 1 ms SYNC0
     bool configureDC();
+    bool configureDC(ecx_contextt* context, uint32_t cycleTime);
+    // Warm start: pick up the DC chain and SYNC0 settings the slaves are running with
+    bool attachDC();
+    bool attachDC(ecx_contextt* context);
     bool setupDCSync0(int slave, bool active, uint32_t cycleTime, int32_t shiftTime);
     void printDCStatus() const;
 }; 
\ No newline at end of file
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "ethercat.h"
+#include "process_image.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One EtherCAT segment on its own NIC with its own SOEM context, slave and
+// group tables, process image and RT thread. Lines share nothing on the cyclic path,
+// so a cell controller can run several of them on separate cores next to the
+// default line driven through the global ec_* API.
+class EtherCATLine {
+public:
+    struct Stats {
+        uint64_t cycles;
+        uint64_t wkcErrors;   // cycles whose working counter missed the expected value
+        uint64_t overruns;    // cycles that woke up after the next cycle was due
+        double avgLatencyUs;  // wakeup latency against the cycle start
+        int maxLatencyUs;
+        double avgExchangeUs; // send + receive of the process data frame
+        int maxExchangeUs;
+    };
+
+    // Called on the RT thread between receive and the next send
+    using CycleHook = std::function<void(EtherCATLine& line)>;
+
+    EtherCATLine(int id, const std::string& ifname, int cpu);
+    ~EtherCATLine();
+
+    EtherCATLine(const EtherCATLine&) = delete;
+    EtherCATLine& operator=(const EtherCATLine&) = delete;
+
+    // Open the NIC, scan, map PDOs, configure DC and bring the line to SAFE_OP
+    bool configure(int cycleUs);
+    // Start the RT thread on the line's core and request OP
+    bool start();
+    void stop();
+
+    void setCycleHook(CycleHook hook) { cycleHook = hook; }
+
+    int getId() const { return id; }
+    const std::string& getInterface() const { return ifname; }
+    int getCpu() const { return cpu; }
+    int getSlaveCount() const { return slaveCount; }
+    // Expected WKC with every group exchanged
+    int getExpectedWKC() const { return expectedWKC; }
+    ecx_contextt* context() { return &ctx; }
+    ec_slavet& slave(int index) { return slaves[index]; }
+    ProcessImage& image() { return processImage; }
+
+    Stats getStats() const;
+    void printStats() const;
+
+private:
+    void cycleLoop();
+
+    // SOEM keeps the SII prefetch and mapper thread tables in file scope
+    // statics, so bring-up of different lines must not overlap
+    static std::mutex configMutex;
+
+    int id;
+    std::string ifname;
+    int cpu;
+    int cycleUs = 1000;
+    bool opened = false;
+
+    // Storage behind the context, one set per line. The slave list holds only
+    // the master record until configure() has counted the line.
+    ecx_contextt ctx;
+    ecx_portt port;
+    std::vector<ec_slavet> slaves;
+    int slaveCount = 0;
+    ec_groupt groups[EC_MAXGROUP];
+    uint8 esibuf[EC_MAXEEPBUF];
+    uint32 esimap[EC_MAXEEPBITMAP];
+    ec_eringt elist;
+    ec_idxstackT idxstack;
+    boolean ecatError = FALSE;
+    int64 dcTime = 0;
+    ec_SMcommtypet smCommtype[EC_MAX_MAPT];
+    ec_PDOassignt pdoAssign[EC_MAX_MAPT];
+    ec_PDOdesct pdoDesc[EC_MAX_MAPT];
+    ec_eepromSMt eepSM;
+    ec_eepromFMMUt eepFMMU;
+    ProcessImage processImage;
+
+    int expectedWKC = 0;
+    CycleHook cycleHook;
+    std::thread rtThread;
+    std::atomic<bool> running{false};
+
+    std::atomic<uint64_t> cycleCount{0};
+    std::atomic<uint64_t> wkcErrorCount{0};
+    std::atomic<uint64_t> overrunCount{0};
+    std::atomic<uint64_t> latencySumUs{0};
+    std::atomic<int> maxLatencyUs{0};
+    std::atomic<uint64_t> exchangeSumUs{0};
+    std::atomic<int> maxExchangeUs{0};
+};
+
+// Owner of the additional lines of a cell controller
+class LineManager {
+public:
+    static LineManager& getInstance() {
+        static LineManager instance;
+        return instance;
+    }
+
+    LineManager(const LineManager&) = delete;
+    LineManager& operator=(const LineManager&) = delete;
+
+    // "ifname" or "ifname@cpu", lines without a core get the next free one
+    bool addLine(const std::string& spec);
+    // Bring every line to SAFE_OP one after the other, then start their RT threads
+    bool startAll(int cycleUs);
+    void stopAll();
+    // Hugepage backed process images for lines started afterwards
+    void setHugePages(bool enable) { hugePages = enable; }
+    void setLayout(TaskGroups::Layout value) { layout = value; }
+
+    size_t size() const { return lines.size(); }
+    EtherCATLine& line(size_t index) { return *lines[index]; }
+
+    // Per-line cycle statistics side by side, lines that scale independently
+    // show the same latency with one line running as with all of them
+    void printStats() const;
+
+private:
+    LineManager() = default;
+
+    // Core 1 runs the UI and core 3 the default line's RT thread
+    static const int FIRST_LINE_CPU = 4;
+
+    std::vector<std::unique_ptr<EtherCATLine>> lines;
+    bool hugePages = false;
+    TaskGroups::Layout layout = TaskGroups::LAYOUT_PACKED;
+};
@@ -3,8 +3,10 @@
 #include <memory>
 #include "ethercat.h"
 #include "pdo_manager.h"
+#include "ring_monitor.h"
 #include <string>
 #include <functional>
+#include <vector>
 
 class EtherCATManager {
 public:
@@ -20,7 +22,8 @@ public:
     // set destructor to public
     ~EtherCATManager() { cleanup(); }
     
-    bool initialize(const std::string& ifname);
+    // A secondary interface closes the line into a cable redundant ring
+    bool initialize(const std::string& ifname, const std::string& secondary = "");
     bool sendProcessData();
     int receiveProcessData(int timeout);
     void cleanup();
@@ -36,6 +39,12 @@ public:
     bool checkState();
     bool setState(uint16 state);
 
+    // Warm start: re-attach to slaves left in SAFE-OP/OP by a previous run without
+    // resetting them, when the line still matches the fingerprint saved at the last OP
+    bool isWarmStart() const { return warmStart; }
+    void endWarmStart();
+    void saveLineFingerprint();
+
     // new methods
     bool readObjectDictionary(int slave);
     bool readBasicInfo(int slave);
@@ -45,7 +54,11 @@ public:
     // communication related methods
     int getExpectedWKC() const { return expectedWKC; }
     int getWorkingCounter() const { return workingCounter; }
-    char* getIOmap() { return IOmap; }
+    uint8_t* getIOmap() { return PDOManager::processImage().data(); }
+
+    // Cable redundancy: return path of the process data per cycle
+    bool isRedundant() const { return !secondaryInterface.empty(); }
+    RingMonitor& getRingMonitor() { return ringMonitor; }
 
     // add DCinfo declaration
     bool DCinfo();
@@ -63,14 +76,33 @@ protected:
     
 private:
     bool initialized = false;
-    char IOmap[4096];
     int expectedWKC = 0;
     volatile int workingCounter = 0;
     std::string interface;
+    std::string secondaryInterface;
+    RingMonitor ringMonitor;
 
     bool checkInitState();
     bool checkPreOpState();
-    bool waitForState(int slave, uint16 state, int timeout = EC_TIMEOUTSTATE * 4);
+
+    static const char* WARM_START_FILE;
+    bool warmStart = false;
+    std::vector<std::string> warmIdentities;
+
+    bool probeWarmStart();
+    bool matchesWarmIdentities() const;
+    static uint32_t lineFingerprint(int slaveCount);
+    static std::string identityKey(int slave);
+
+    // State transition engine: request a state on many slaves at once, then poll AL status
+    // with exponential backoff and report each slave as it arrives or fails
+    static const int STATE_POLL_MIN_US = 50;
+    static const int STATE_POLL_MAX_US = 10000;
+    static const int STATE_ERROR_GRACE_US = 20000;  // time for an acknowledged error to clear
+
+    bool transitionSlaves(const std::vector<int>& slaves, uint16 state, int timeoutUs = EC_TIMEOUTSTATE * 4);
+    bool waitForStates(const std::vector<int>& slaves, uint16 state,
+                       const std::vector<bool>& hadError, int timeoutUs);
 
     LogCallback logCallback;
     void log(const std::string& msg) {
@@ -85,9 +85,6 @@ private:
     // add updateMotorStatus declaration
     void updateMotorStatus();
 
-    // add IOmap
-    uint8_t IOmap[4096];  // 通常 4KB 足够了
-
     // add error handling function declaration
     void handleCommunicationError(int& retry_count, const int MAX_RETRY, const int RETRY_DELAY_MS);
 
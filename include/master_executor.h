@@ -0,0 +1,110 @@
+#pragma once
+
+#include "ethercat.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Schedules acyclic EtherCAT work while the cyclic loop runs. Jobs that are
+// split into non-blocking mailbox steps (expedited SDO) are queued and the RT
+// thread steps them in the slack after its send, within a fixed budget per
+// cycle. Work that blocks on a slave (normal SDO, state checks, recovery)
+// never runs there: it runs on the calling thread next to the cycle, so the
+// port is shared and SOEM keeps the frames apart by index. Both paths hold
+// the mailbox of their slave for the whole conversation, so a slave's
+// mailbox never carries two of them at once.
+class MasterExecutor {
+public:
+    static MasterExecutor& getInstance() {
+        static MasterExecutor instance;
+        return instance;
+    }
+
+    MasterExecutor(const MasterExecutor&) = delete;
+    MasterExecutor& operator=(const MasterExecutor&) = delete;
+
+    enum class Step { Pending, Done, Failed };
+    // Called once per slice until it returns Done or Failed
+    using Job = std::function<Step()>;
+
+    struct Stats {
+        uint64_t jobs;
+        uint64_t failed;
+        uint64_t slices;
+        uint64_t overruns;  // slices that ended past the cycle budget
+        int maxSliceUs;
+    };
+
+    // RT thread takes over the port, budgetUs of each cycle go to queued jobs
+    void attach(int budgetUs);
+    // Fails everything still queued and hands the port back
+    void detach();
+    bool isAttached() const { return attached.load(); }
+
+    // Mailboxes of every slave, for work that may talk to any of them
+    static const uint16 ALL_SLAVES = 0;
+
+    // Queue a job, the future turns true when the job is Done. The job waits
+    // in the queue until it gets the slave's mailbox and holds it to the end.
+    std::future<bool> post(const char* name, uint16 slave, Job job, int timeoutMs = DEFAULT_TIMEOUT_MS);
+    // Run blocking work on the calling thread once the slave's mailbox is
+    // free; refused on the RT thread.
+    bool call(const char* name, uint16 slave, std::function<bool()> work);
+
+    // Expedited SDO split into mailbox steps, larger objects block the caller
+    // through call()
+    bool sdoWrite(uint16 slave, uint16 index, uint8 subindex, int size, const void* data);
+    bool sdoRead(uint16 slave, uint16 index, uint8 subindex, int* size, void* data);
+
+    // RT thread, after the cycle's send: step queued jobs until the budget is spent
+    void runSlack();
+
+    Stats getStats() const;
+
+private:
+    MasterExecutor() : attached(false), budgetUs(0) {}
+
+    struct Entry {
+        const char* name;
+        uint16 slave;
+        Job job;
+        std::promise<bool> result;
+        std::chrono::steady_clock::time_point deadline;
+        bool locked;  // holds the slave's mailbox
+    };
+
+    bool onOwnerThread() const;
+    bool wait(std::future<bool>& result, int timeoutMs);
+    void finish(Entry& entry, bool ok);
+
+    // Never blocks, the RT thread retries next cycle
+    bool tryLockMailbox(uint16 slave);
+    // Blocking callers wait up to timeoutMs
+    bool lockMailbox(uint16 slave, int timeoutMs);
+    void unlockMailbox(uint16 slave);
+
+    static const int DEFAULT_TIMEOUT_MS = 2000;
+
+    std::atomic<bool> attached;
+    std::thread::id owner;
+    int budgetUs;
+
+    // Producers append to incoming; only the RT thread touches active
+    std::mutex incomingMutex;
+    std::deque<std::unique_ptr<Entry>> incoming;
+    std::deque<std::unique_ptr<Entry>> active;
+
+    std::atomic<bool> mailboxBusy[EC_MAXSLAVE] = {};
+
+    std::atomic<uint64_t> jobCount{0};
+    std::atomic<uint64_t> failedCount{0};
+    std::atomic<uint64_t> sliceCount{0};
+    std::atomic<uint64_t> overrunCount{0};
+    std::atomic<int> maxSliceUs{0};
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Operation mode change of all axes as one transaction. The UI thread begins
+// it and polls for the outcome. The RT thread writes the mode every cycle and
+// checks each axis' 0x6061 display. The transaction completes in the cycle
+// where the last axis confirms, or times out with the per-axis results once
+// the deadline set by begin() has passed. At most one transaction is pending
+// at a time; its sequence and status share one word, so an outcome is only
+// ever stored for the transaction it was computed for.
+class ModeChange {
+public:
+    enum Status { IDLE, PENDING, COMPLETE, TIMED_OUT, CANCELLED, FAILED };
+
+    struct AxisResult {
+        int slave;
+        int8_t display;   // last 0x6061 seen
+        bool confirmed;
+        uint32_t cycles;  // cycles until the axis confirmed
+    };
+
+    // Before the RT thread starts: the slave of every axis
+    void resize(const std::vector<int>& slaves);
+
+    // UI thread. False if a transaction is still pending.
+    bool begin(uint8_t mode, int timeoutMs);
+    void cancel();
+    // Another thread could not prepare the line for the mode, e.g. its PDO remap failed
+    void fail();
+    Status status() const { return (Status)(word.load(std::memory_order_acquire) & STATUS_MASK); }
+    bool isPending() const { return status() == PENDING; }
+    uint8_t mode() const { return requested.load(std::memory_order_relaxed); }
+    // Per-axis outcome, valid once the transaction is no longer pending
+    const std::vector<AxisResult>& results() const { return axes; }
+    uint32_t cycles() const { return elapsed; }
+
+    // RT thread, every cycle with the mode display of every axis, or nullptr
+    // when the cycle brought no valid inputs (only the deadline is checked).
+    // Returns COMPLETE or TIMED_OUT in the cycle that ends the transaction.
+    Status step(const int32_t* modeDisplay);
+
+private:
+    using Clock = std::chrono::steady_clock;
+    // Low byte the status, the rest the sequence of the transaction
+    static const uint32_t STATUS_MASK = 0xFF;
+
+    bool finish(uint32_t current, Status outcome);
+    void abort(Status outcome);
+
+    std::vector<AxisResult> axes;  // written by the RT thread while pending
+    uint32_t elapsed = 0;
+    uint32_t active = 0;  // sequence the RT thread is working on
+
+    std::atomic<uint32_t> word{IDLE};
+    std::atomic<uint8_t> requested{0};
+    std::atomic<int64_t> deadline{0};  // steady clock, ns
+};
@@ -5,6 +5,7 @@
 #include <QDateTime>
 #include <atomic>
 #include "pdo_manager.h"
+#include "mode_change.h"
 #include "component_manager.h"
 #include "ethercat_thread.h"
 
@@ -59,8 +60,9 @@ namespace monitor {
         std::atomic<int16_t> targetTorque{0};  // Added target torque
         std::atomic<bool> enableRequested{false};  // Enable request flag
         std::atomic<uint8_t> operationMode{9};  // Default CSV mode
-        std::atomic<bool> modeChangeRequested{false};
+        ModeChange modeChange;  // Mode change of all axes, begun by the UI, confirmed by the RT thread
         std::atomic<bool> modeConfirmed{false};  // Mode confirmation flag
+        std::atomic<bool> lineStopped{false};  // Line left OP for a PDO remap and could not return
         
         // PP mode related fields
         PPParams ppParams;
@@ -80,6 +82,7 @@ namespace monitor {
         std::atomic<bool> cstParamsConfirmed{false};
         
         std::string selectedInterface;  // Selected network interface
+        std::string secondaryInterface;  // Redundant ring port, empty for a plain line
         std::atomic<bool> interfaceConfirmed{false};  // Interface confirmation flag
         std::atomic<bool> pvNewTarget{false};  // PV mode new target speed flag
         int32_t cspMaxVelocity = 10000; // 新增：CSP模式最大速度
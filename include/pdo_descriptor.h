@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Compile time PDO descriptors. A PDO is declared once, as the list of the
+// objects it maps. Its mapping entries, byte offsets and size are derived
+// from that list. Accessors for an object the PDO does not map fail to compile.
+
+// One mapped object: index, subindex and the C type of its value
+template <uint16_t Index, uint8_t Subindex, typename T>
+struct PdoObject {
+    using type = T;
+    static constexpr uint16_t index = Index;
+    static constexpr uint8_t subindex = Subindex;
+    static constexpr uint8_t bits = sizeof(T) * 8;
+    static constexpr uint32_t entry = (uint32_t)Index << 16 | (uint32_t)Subindex << 8 | bits;
+};
+
+// Where one object of a descriptor lives in its PDO
+struct PdoField {
+    uint16_t index;
+    uint8_t subindex;
+    uint8_t offset;
+    uint8_t size;
+};
+
+namespace pdo_detail {
+
+template <typename... Objects>
+struct SizeOf {
+    static constexpr size_t value = 0;
+};
+template <typename First, typename... Rest>
+struct SizeOf<First, Rest...> {
+    static constexpr size_t value = sizeof(typename First::type) + SizeOf<Rest...>::value;
+};
+
+// Left undefined for an object that is not in the list, so a lookup of it does not compile
+template <typename Object, typename... Objects>
+struct OffsetOf;
+template <typename Object, typename... Rest>
+struct OffsetOf<Object, Object, Rest...> {
+    static constexpr size_t value = 0;
+};
+template <typename Object, typename First, typename... Rest>
+struct OffsetOf<Object, First, Rest...> {
+    static constexpr size_t value = sizeof(typename First::type) + OffsetOf<Object, Rest...>::value;
+};
+
+}  // namespace pdo_detail
+
+template <uint16_t Pdo, typename... Objects>
+struct PdoDescriptor {
+    static constexpr uint16_t index = Pdo;
+    static constexpr size_t count = sizeof...(Objects);
+    static constexpr size_t size = pdo_detail::SizeOf<Objects...>::value;
+
+    // Mapping entries for the PDO object, index << 16 | subindex << 8 | bit length
+    static constexpr uint32_t entries[count] = {Objects::entry...};
+    static constexpr PdoField fields[count] = {
+        {Objects::index, Objects::subindex, (uint8_t)pdo_detail::OffsetOf<Objects, Objects...>::value,
+         (uint8_t)sizeof(typename Objects::type)}...};
+
+    static_assert(count > 0 && count < 255, "a PDO maps 1 to 254 objects");
+    static_assert(size < 256, "field offsets are kept in a byte");
+
+    template <typename Object>
+    static constexpr size_t offset() { return pdo_detail::OffsetOf<Object, Objects...>::value; }
+
+    // Inlined access to one object in a slave's outputs / inputs
+    template <typename Object>
+    static typename Object::type get(const uint8_t* data) {
+        typename Object::type value;
+        memcpy(&value, data + offset<Object>(), sizeof(value));
+        return value;
+    }
+    template <typename Object>
+    static void set(uint8_t* data, typename Object::type value) {
+        memcpy(data + offset<Object>(), &value, sizeof(value));
+    }
+
+    static std::vector<uint32_t> mapping() { return std::vector<uint32_t>(entries, entries + count); }
+};
+
+template <uint16_t Pdo, typename... Objects>
+constexpr uint32_t PdoDescriptor<Pdo, Objects...>::entries[];
+template <uint16_t Pdo, typename... Objects>
+constexpr PdoField PdoDescriptor<Pdo, Objects...>::fields[];
+
+namespace cia402 {
+
+using Controlword = PdoObject<0x6040, 0, uint16_t>;
+using Statusword = PdoObject<0x6041, 0, uint16_t>;
+using ModeOfOperation = PdoObject<0x6060, 0, uint8_t>;
+using ModeOfOperationDisplay = PdoObject<0x6061, 0, uint8_t>;
+using ActualPosition = PdoObject<0x6064, 0, int32_t>;
+using ActualVelocity = PdoObject<0x606C, 0, int32_t>;
+using TargetTorque = PdoObject<0x6071, 0, int16_t>;
+using ActualTorque = PdoObject<0x6077, 0, int16_t>;
+using TargetPosition = PdoObject<0x607A, 0, int32_t>;
+using TargetVelocity = PdoObject<0x60FF, 0, int32_t>;
+using Padding8 = PdoObject<0x0000, 0, uint8_t>;
+
+// Drive PDOs of our products. The mode byte stays in every set because modes
+// are switched and confirmed through it.
+using RxFull = PdoDescriptor<0x1600, Controlword, TargetPosition, TargetVelocity, TargetTorque,
+                             ModeOfOperation, Padding8>;
+using TxFull = PdoDescriptor<0x1A00, Statusword, ActualPosition, ActualVelocity, ActualTorque,
+                             ModeOfOperationDisplay, Padding8>;
+using RxCsp = PdoDescriptor<0x1601, Controlword, TargetPosition, ModeOfOperation, Padding8>;
+using TxCsp = PdoDescriptor<0x1A01, Statusword, ActualPosition, ModeOfOperationDisplay, Padding8>;
+using RxCsv = PdoDescriptor<0x1602, Controlword, TargetVelocity, ModeOfOperation, Padding8>;
+using TxCsv = PdoDescriptor<0x1A02, Statusword, ActualPosition, ActualVelocity, ModeOfOperationDisplay, Padding8>;
+using RxCst = PdoDescriptor<0x1603, Controlword, TargetTorque, ModeOfOperation, Padding8>;
+using TxCst = PdoDescriptor<0x1A03, Statusword, ActualPosition, ActualTorque, ModeOfOperationDisplay, Padding8>;
+
+}  // namespace cia402
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ethercat.h"
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// PDO layout for one kind of slave. It holds the mapping entries (index << 16 |
+// subindex << 8 | bit length) of the single RxPDO and TxPDO that are assigned
+// through 0x1C12/0x1C13. A layout without entries keeps the mapping the device
+// already has. That mapping is read back, not written.
+struct PdoLayout {
+    std::string name;
+    uint16_t rxPdo = 0;
+    std::vector<uint32_t> rx;
+    uint16_t txPdo = 0;
+    std::vector<uint32_t> tx;
+
+    bool keepsDeviceMapping() const { return rx.empty() && tx.empty(); }
+};
+
+// Where one mapped object sits in a slave's outputs or inputs. It is resolved
+// once after mapping, so the cyclic code reads or writes a field directly.
+struct PdoOffset {
+    int byte = -1;     // from slave.outputs / slave.inputs, -1 if the object is not mapped
+    uint8_t bit = 0;   // first bit in that byte, only non-zero for bit sized entries
+    uint8_t bits = 0;
+
+    bool valid() const { return byte >= 0; }
+
+    template <typename T> T read(const uint8_t* data) const {
+        T value;
+        memcpy(&value, data + byte, sizeof(T));
+        return value;
+    }
+    template <typename T> void write(uint8_t* data, T value) const {
+        memcpy(data + byte, &value, sizeof(T));
+    }
+    bool readBit(const uint8_t* data) const { return (data[byte] >> bit) & 1; }
+    void writeBit(uint8_t* data, bool value) const {
+        data[byte] = value ? (uint8_t)(data[byte] | (1 << bit)) : (uint8_t)(data[byte] & ~(1 << bit));
+    }
+};
+
+// The layouts a line can use. The drive profiles (full, csp, csv, cst) and
+// "device" are built in. pdo_layouts.txt adds more layouts and assigns them
+// to slaves:
+//   layout <name> rx <pdo> <entry>... tx <pdo> <entry>...
+//   slave <position> <layout>
+//   id <vendor> <product> <layout>
+// A slave with no rule gets the default layout. A slave without CoE cannot
+// be remapped, so it keeps its own mapping.
+class PdoLayouts {
+public:
+    static constexpr const char* LAYOUT_FILE = "pdo_layouts.txt";
+
+    // Load the built-ins and the layout file once at startup, before any line is
+    // brought up. Lines read the registry concurrently. A missing file is not an error.
+    static bool load(const std::string& path = LAYOUT_FILE);
+    static const PdoLayout* find(const std::string& name);
+    // Also switched at runtime when the default line is remapped for a mode
+    static bool setDefault(const std::string& name);
+    static const PdoLayout& getDefault();
+    // Layout for one slave of a line, chosen by position or SII identity
+    static const PdoLayout& select(ecx_contextt* context, int slave);
+
+    // Offset of an object in a list of entries that starts at startBit of the slave's data
+    static PdoOffset locate(const std::vector<uint32_t>& entries, uint16_t index, uint8_t subindex,
+                            uint8_t startBit = 0);
+    static int bytes(const std::vector<uint32_t>& entries);
+
+private:
+    static bool parseLayout(std::istream& fields, PdoLayout& layout);
+
+    static std::map<std::string, PdoLayout> layouts;
+    static std::map<int, std::string> byPosition;
+    static std::map<uint64_t, std::string> byIdentity;
+    static std::string defaultName;
+};
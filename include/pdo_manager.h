@@ -1,10 +1,16 @@
 #pragma once
 
 #include "ethercat.h"
+#include "pdo_layout.h"
+#include "process_image.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
 
 class PDOManager {
 public:
-    // PDO 数据结构定义
+    // PDO 数据结构定义, laid out like cia402::RxFull / TxFull (static_assert in pdo_manager.cpp)
     typedef struct {
         uint16_t controlword;       // 0x6040:0, 16 bits
         int32_t target_position;    // 0x607A:0, 32 bits
@@ -25,21 +31,142 @@ public:
 
     PDOManager();  // 构造函数
 
-    // 静态配置方法
+    // 静态配置方法, the context-less forms work on the default line and its process image
     static bool configureMapping();
-    static bool configureRxPDO(int slave);
-    static bool configureTxPDO(int slave);
+    static bool configureMapping(ecx_contextt* context, ProcessImage& image);
+    // Warm start: map the process image onto the PDO layout the slaves are already running
+    static bool attachMapping();
+    static bool attachMapping(ecx_contextt* context, ProcessImage& image);
+    // Runtime profile switch of the default line. The line has to be in PRE-OP
+    // and nothing may exchange process data: the slaves' FMMUs are cleared,
+    // the drives get the layout and the image is mapped anew.
+    static bool remapMapping(const std::string& layout);
+    // Built-in drive profile that carries the setpoint of an operation mode
+    static const char* profileForMode(uint8_t mode);
+    // Process image of the default line
+    static ProcessImage& processImage() { return defaultImage; }
+    static bool configureRxPDO(ecx_contextt* context, int slave);
+    static bool configureTxPDO(ecx_contextt* context, int slave);
     
     bool initializePDO();
     bool readProcessData(TxPDO& txpdo);
     bool writeProcessData(const RxPDO& rxpdo);
 
-    static bool configurePDOs(int slave);
+    static bool configurePDOs(ecx_contextt* context, int slave);
+
+    // Complete Access readers/writers, fall back to per-subindex access if CA is not supported
+    static bool supportsCompleteAccess(ecx_contextt* context, int slave);
+    static bool writeMappingObject(ecx_contextt* context, int slave, uint16_t pdoIndex,
+                                   const uint32_t* entries, uint8_t count);
+    static bool writeAssignObject(ecx_contextt* context, int slave, uint16_t assignIndex, uint16_t pdoIndex);
+    static bool readMappingObject(ecx_contextt* context, int slave, uint16_t pdoIndex,
+                                  uint32_t* entries, uint8_t& count);
+    static bool readAssignObject(ecx_contextt* context, int slave, uint16_t assignIndex,
+                                 uint16_t* pdos, uint8_t& count);
+
+    // One field copy between an application struct and the process data
+    struct CopyOp {
+        uint8_t structOffset;
+        uint16_t pdoOffset;
+        uint8_t size;
+    };
+
+    // What one slave runs: the layout PdoLayouts chose for it and its entries.
+    // For a "device" layout the entries are read back from the slave. The copies
+    // to and from the drive structs are resolved once the process image is
+    // mapped. A slave that runs the full drive PDO byte aligned is copied with
+    // the compile time accessors and needs no copy table; a slave without
+    // drive objects gets no copies.
+    struct SlaveMapping {
+        const PdoLayout* layout = nullptr;
+        std::vector<uint32_t> rx;
+        std::vector<uint32_t> tx;
+        uint8_t rxStartBit = 0;
+        uint8_t txStartBit = 0;
+        int rxBytes = 0;
+        int txBytes = 0;
+        bool rxFull = false;
+        bool txFull = false;
+        bool fromCache = false;  // rewrite skipped, the device held the cached layout
+        std::vector<CopyOp> rxOps;
+        std::vector<CopyOp> txOps;
+    };
+
+    // Mappings of a line indexed by slave number, empty before the line is mapped
+    static const std::vector<SlaveMapping>& mappings(ecx_contextt* context);
+    // Where an object of one slave sits in its outputs / inputs
+    static PdoOffset rxOffset(ecx_contextt* context, int slave, uint16_t index, uint8_t subindex = 0);
+    static PdoOffset txOffset(ecx_contextt* context, int slave, uint16_t index, uint8_t subindex = 0);
+    // Whether the drives of the default line carry the setpoint of an operation mode
+    static bool supportsMode(uint8_t mode);
+
+    // Copy the fields a slave maps between the full structs and its process data
+    static void packRx(const SlaveMapping& mapping, const RxPDO& rx, ec_slavet& slave);
+    static void unpackTx(const SlaveMapping& mapping, const ec_slavet& slave, TxPDO& tx);
+    // Same for a slave of the default line
+    static void packRx(const RxPDO& rx, int slave);
+    static void unpackTx(int slave, TxPDO& tx);
+
+    // Map one slave, skipping the rewrite if the device already holds the layout
+    static bool configureSlaveMapping(ecx_contextt* context, int slave);
+    // Where the mapping cache lives, by default next to the executable
+    static void setCacheDirectory(const std::string& directory);
+    // Path of another file kept with the mapping cache, e.g. the warm start fingerprint
+    static std::string cacheFile(const char* name);
 
 private:
+    // Identity used as PDO mapping cache key
+    struct SlaveIdentity {
+        uint32_t vendor;
+        uint32_t product;
+        uint32_t revision;
+        uint32_t serial;
+    };
+
+    // Last layout written to a device and whether it accepted Complete Access
+    struct MappingCacheEntry {
+        uint32_t fingerprint = 0;
+        bool completeAccess = true;
+    };
+
+    static constexpr const char* MAPPING_CACHE_FILE = "pdo_mapping_cache.txt";
+    static std::string cachePath();
+    static const std::string& resolvedCacheDirectory();
+    static void resetFmmus(ecx_contextt* context);
+    static int rewriteStaleMappings(ecx_contextt* context);
+
+    static SlaveIdentity readIdentity(ecx_contextt* context, int slave);
+    static std::string identityKey(const SlaveIdentity& id);
+    static uint32_t layoutFingerprint(const PdoLayout& layout);
+    static bool mappingMatches(ecx_contextt* context, int slave, uint16_t assignIndex, uint16_t pdoIndex,
+                               const std::vector<uint32_t>& entries);
+    static bool readDeviceMapping(ecx_contextt* context, int slave, uint16_t assignIndex,
+                                  std::vector<uint32_t>& entries);
+    static bool readSiiMapping(ecx_contextt* context, int slave, bool outputs, std::vector<uint32_t>& entries);
+    static void loadEntries(ecx_contextt* context, int slave, const PdoLayout& layout, SlaveMapping& mapping);
+    static std::vector<SlaveMapping>& lineMappings(ecx_contextt* context);
+    static void prepareMappings(ecx_contextt* context);
+    static void resolveMappings(ecx_contextt* context);
+    static void loadMappingCache();
+    static void saveMappingCache();
+    static void reportMailboxStatusMapping(ecx_contextt* context);
+    static uint8_t& caRejected(ecx_contextt* context, int slave);
+
+    static std::map<std::string, MappingCacheEntry> mappingCache;
+    static std::mutex cacheMutex;
+    static std::string cacheDirectory;
+    static std::mutex caMutex;
+    static std::map<const ecx_contextt*, std::vector<uint8_t>> caRejectedByLine;
+    static std::vector<SlaveMapping> defaultMappings;
+    static std::mutex mappingMutex;
+    static std::map<const ecx_contextt*, std::vector<SlaveMapping>> mappingsByLine;
+
+    // Number of slaves mapped concurrently, each worker holds at most one frame index
+    static const int MAPPING_WORKERS = EC_MAXBUF / 2;
+
     RxPDO rxpdo;
     TxPDO txpdo;
-    static char IOmap[4096];
+    static ProcessImage defaultImage;
 };
 
 struct SharedData {
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ethercat.h"
+#include "task_groups.h"
+#include <cstddef>
+#include <cstdint>
+
+// Process image of one line, allocated to exactly the size the PDO mapping
+// needs instead of a fixed 4 KB IOmap. The mapping is first laid out in a
+// scratch buffer big enough for any line, then moved into a cache line
+// aligned (optionally hugepage backed) block of the final size.
+class ProcessImage {
+public:
+    static const size_t ALIGNMENT = 64;
+    static const size_t HUGEPAGE_SIZE = 2 * 1024 * 1024;
+    // Spare bytes after the image, 32 bit gathers of its last narrow field stay inside the block
+    static const size_t TAIL = 4;
+
+    ProcessImage() = default;
+    ~ProcessImage();
+
+    ProcessImage(const ProcessImage&) = delete;
+    ProcessImage& operator=(const ProcessImage&) = delete;
+
+    // Back the image with a 2 MB hugepage, falls back to normal pages if none are reserved
+    void setHugePages(bool enable) { useHugePages = enable; }
+    // IOmap layout used by the next map()
+    void setLayout(TaskGroups::Layout value) { layout = value; }
+    TaskGroups::Layout getLayout() const { return layout; }
+
+    // Map the line's groups (see TaskGroups::map) and move them into the image,
+    // returns the image size or 0 on failure
+    int map(ecx_contextt* context);
+    void release();
+
+    uint8_t* data() { return image; }
+    size_t size() const { return bytes; }
+    bool isHugePage() const { return hugePage; }
+
+private:
+    bool allocate(size_t size);
+
+    uint8_t* image = nullptr;
+    size_t bytes = 0;
+    size_t allocated = 0;
+    bool hugePage = false;
+    bool useHugePages = false;
+    TaskGroups::Layout layout = TaskGroups::LAYOUT_PACKED;
+};
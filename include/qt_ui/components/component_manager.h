@@ -25,6 +25,7 @@ public:
     // network interface components
     struct NetworkComponents {
         QComboBox* selector;
+        QComboBox* secondarySelector;  // second port of a cable redundant ring
         QPushButton* refreshBtn;
         QPushButton* confirmBtn;
         QVBoxLayout* layout;
@@ -49,6 +49,8 @@ public slots:
     void onCSTParamsConfirmed();
     
 private:
+    static const int MODE_CHANGE_TIMEOUT_MS = 5000;
+
     MonitorWindow* mainWindow;
     monitor::SharedData& sharedData;
     ComponentManager::ModeComponents* modeComps;
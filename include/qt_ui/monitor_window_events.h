@@ -10,6 +10,8 @@
 #include <QSpinBox>
 #include <QTextEdit>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QTimer>
 #include "component_manager.h"
 #include "monitor_window.h"
 
@@ -64,6 +66,7 @@ public slots:
     void onPTParamsConfirmed();
     void onCSTParamsConfirmed();
     void onCSPParamsConfirmed();
+    void onModeChangeFinished(bool complete);
     
     // 网络相关
     void onNetworkChanged(int index);
@@ -78,8 +81,25 @@ public slots:
     void onMouseMove(QMouseEvent* event);
     void onMouseDoubleClick();
 
+signals:
+    // Once per mode change: every axis confirmed the mode, or the timeout hit
+    void modeChangeFinished(bool complete);
+
+private slots:
+    void pollModeChange();
+
 private:
+    static const int MODE_CHANGE_TIMEOUT_MS = 5000;
+    // Includes the PRE-OP round trip when the drives have to be remapped first
+    static const int MODE_CHANGE_REMAP_TIMEOUT_MS = 15000;
+    static const int MODE_CHANGE_POLL_MS = 10;
+    // Past the transaction timeout, the RT thread is not stepping it any more
+    static const int MODE_CHANGE_GRACE_MS = 1000;
+
     QMainWindow* window;
+    QTimer* modeChangeTimer;
+    QElapsedTimer modeChangeStarted;
+    int modeChangeTimeoutMs = MODE_CHANGE_TIMEOUT_MS;
     monitor::SharedData& sharedData;
     
     // 组件指针
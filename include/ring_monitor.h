@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ethercat.h"
+#include <atomic>
+#include <cstdint>
+
+// Per-cycle return path of the process data frames of a cable redundant line.
+// A ring break shows up as a change from EC_RXPATH_OK to one of the degraded
+// paths; the cycles without complete process data from there until the first
+// complete cycle are the failover time of that break.
+class RingMonitor {
+public:
+    struct Stats {
+        uint64_t cycles;
+        uint64_t paths[EC_RXPATHS];
+        uint64_t lostCycles;      // cycles whose WKC fell short
+        uint64_t breaks;          // ring closed -> degraded transitions
+        uint64_t restores;        // degraded -> ring closed transitions
+        int lastFailoverCycles;   // cycles lost by the last break
+        int maxFailoverCycles;
+        int lastPath;
+    };
+
+    // Our lines have to ride through a break with at most one lost cycle
+    static const int MAX_FAILOVER_CYCLES = 1;
+
+    // Called by the RT thread after each receive with the fast group's path
+    // and whether the working counter was complete
+    void record(int path, bool complete);
+    void reset();
+
+    bool isDegraded() const { return degraded.load(); }
+    Stats getStats() const;
+    void print(const char* name) const;
+
+    static const char* pathName(int path);
+
+private:
+    std::atomic<uint64_t> cycles{0};
+    std::atomic<uint64_t> paths[EC_RXPATHS] = {};
+    std::atomic<uint64_t> lostCycles{0};
+    std::atomic<uint64_t> breaks{0};
+    std::atomic<uint64_t> restores{0};
+    std::atomic<int> lastFailoverCycles{0};
+    std::atomic<int> maxFailoverCycles{0};
+    std::atomic<int> lastPath{EC_RXPATH_OK};
+    std::atomic<bool> degraded{false};
+
+    // RT thread only
+    bool failingOver = false;
+    int failoverCycles = 0;
+};
@@ -71,8 +71,6 @@ private:
     SDOManager() {} // Private constructor
     std::string lastError;
 
-    static char IOmap[4096];
-
     // Helper function
     bool writeSDO(uint16_t slave, uint16_t index, uint8_t subindex, 
                   int size, void* data, const char* description);
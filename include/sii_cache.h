@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ethercat.h"
+#include <map>
+#include <mutex>
+#include <string>
+
+// On-disk cache of parsed slave SII data, keyed by identity and SII checksum.
+// Registered as SOEM SII hooks so ec_config_init skips the EEPROM category walk
+// for devices seen before. The checksum does not cover the categories, delete
+// the cache file after reflashing a device's ESI under the same identity.
+class SIICache {
+public:
+    static SIICache& getInstance() {
+        static SIICache instance;
+        return instance;
+    }
+
+    SIICache(const SIICache&) = delete;
+    SIICache& operator=(const SIICache&) = delete;
+
+    // Load the cache file and register the hooks with the default SOEM context
+    void attach(const std::string& path = CACHE_FILE);
+    // Register the hooks with another line's context, loading the file on first use
+    void attach(ecx_contextt* context);
+    // Write back the cache file if ec_config_init added entries
+    void save();
+    void clear();
+
+    // Number of slaves whose SII was read from EEPROM since attach()
+    int misses() const { return missCount; }
+
+private:
+    SIICache() : dirty(false), missCount(0) {}
+
+    static int loadHook(ecx_contextt* context, uint16 slave, ec_siicachet* sii);
+    static void storeHook(ecx_contextt* context, uint16 slave, const ec_siicachet* sii);
+
+    static std::string key(const ec_siicachet& sii);
+    bool load();
+
+    static const char* CACHE_FILE;
+
+    std::string path;
+    std::map<std::string, ec_siicachet> entries;
+    bool dirty;
+    int missCount;
+    std::mutex mutex;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ethercat.h"
+#include <cstdint>
+
+// Multi-rate process data: CiA402 drives are exchanged every cycle in group 1,
+// everything else in group 2 every few cycles, so the fast frame carries only
+// drive data. A line with only one kind of slave keeps the single group 0.
+// The divisor of each group lives in ec_groupt::cycledivisor.
+class TaskGroups {
+public:
+    static const uint8 FAST_GROUP = 1;
+    static const uint8 SLOW_GROUP = 2;
+    // Slow IO is exchanged about every 10 ms whatever the line cycle is
+    static const int SLOW_PERIOD_US = 10000;
+    // Frame indexes all frozen groups together may hold, the rest stays for acyclic traffic
+    static const int MAX_FROZEN_FRAMES = EC_MAXBUF / 2;
+
+    // IOmap layouts offered by SOEM. PACKED puts outputs and inputs one after
+    // the other bit by bit, OVERLAP lets inputs reuse the outputs' logical
+    // range so the LRW datagram only carries the larger of both, ALIGNED
+    // starts every slave on a byte boundary.
+    enum Layout { LAYOUT_PACKED, LAYOUT_OVERLAP, LAYOUT_ALIGNED };
+    static bool parseLayout(const char* name, Layout& layout);
+    static const char* layoutName(Layout layout);
+
+    // Frames one exchange of a group puts on the wire
+    struct FrameStats {
+        int frames;
+        int datagrams;
+        int bytes;      // Ethernet frame bytes without FCS
+        double wireUs;  // at 100 Mbit/s including preamble, FCS and inter-frame gap
+    };
+
+    // Sort slaves into groups before ec_config_map, returns the number of cycled groups
+    static int assign(ecx_contextt* context);
+    // Divisors for the line cycle, call before the first cyclic exchange
+    static void setCycle(ecx_contextt* context, int cycleUs);
+    // Map the cycled groups back to back into one IOmap, returns the bytes used
+    static int map(ecx_contextt* context, void* IOmap, Layout layout = LAYOUT_PACKED);
+    // After DC configuration: distribute the reference time in the fast frame
+    static void shareDC(ecx_contextt* context);
+
+    // Group that is exchanged every cycle and carries supervision and DC
+    static uint8 fastGroup(ecx_contextt* context);
+    static bool isCycled(ecx_contextt* context, uint8 group);
+
+    // Frozen topology: build the frames of every cycled group once, send() then
+    // only refreshes outputs and working counters. Call after DC and supervision
+    // are set up. Inputs of single frame groups are then read in place from the
+    // receive buffer, so bind anything holding input pointers afterwards.
+    static int freeze(ecx_contextt* context);
+    static void unfreeze(ecx_contextt* context);
+    static bool isFrozen(ecx_contextt* context);
+
+    // Send every group due in this cycle back to back, returns their expected WKC
+    static int send(ecx_contextt* context, uint32_t cycle);
+    // Collect the frames of all groups sent by the last send()
+    static int receive(ecx_contextt* context, int timeout);
+    // Expected WKC of the groups due in this cycle
+    static int expectedWKC(ecx_contextt* context, uint32_t cycle);
+
+    // Frame accounting of one group as ecx_send_processdata_group builds it
+    static FrameStats frameStats(ecx_contextt* context, uint8 group);
+
+    static void print(ecx_contextt* context);
+
+private:
+    static bool isDrive(ecx_contextt* context, int slave);
+    static bool isDue(ecx_contextt* context, uint8 group, uint32_t cycle);
+    static int mapGroup(ecx_contextt* context, void* IOmap, uint8 group, Layout layout);
+    static void addFrame(FrameStats& stats, int dataBytes, int extraDatagrams, int extraBytes);
+};
@@ -0,0 +1,340 @@
+#include "axis_state.h"
+#include "pdo_descriptor.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+
+const AxisState::FieldMap AxisState::TX_MAP[TX_FIELDS] = {
+    {cia402::Statusword::index, 2, false},
+    {cia402::ActualPosition::index, 4, true},
+    {cia402::ActualVelocity::index, 4, true},
+    {cia402::ActualTorque::index, 2, true},
+    {cia402::ModeOfOperationDisplay::index, 1, true},
+};
+
+const AxisState::FieldMap AxisState::RX_MAP[RX_FIELDS] = {
+    {cia402::Controlword::index, 2, false},
+    {cia402::TargetPosition::index, 4, true},
+    {cia402::TargetVelocity::index, 4, true},
+    {cia402::TargetTorque::index, 2, true},
+    {cia402::ModeOfOperation::index, 1, true},
+};
+
+AxisState::~AxisState() {
+    release();
+}
+
+void AxisState::release() {
+    free(block);
+    block = nullptr;
+    axes = 0;
+    padded = 0;
+    slaves.clear();
+}
+
+bool AxisState::bind(ecx_contextt* context, uint8_t* image) {
+    const std::vector<PDOManager::SlaveMapping>& table = PDOManager::mappings(context);
+    std::vector<int> drives;
+    const uint8_t* lowest = nullptr;
+    const uint8_t* highest = nullptr;
+    for (int slave = 1; slave < (int)table.size(); slave++) {
+        const ec_slavet& info = context->slavelist[slave];
+        if (info.outputs && info.inputs &&
+            PdoLayouts::locate(table[slave].rx, cia402::Controlword::index, 0).valid()) {
+            drives.push_back(slave);
+            lowest = (!lowest || info.inputs < lowest) ? info.inputs : lowest;
+            highest = (!highest || info.inputs > highest) ? info.inputs : highest;
+        }
+    }
+    // Gather indexes are 32 bit, all drive inputs have to be in one buffer
+    if (lowest && highest - lowest > 0x10000000) {
+        printf("Axis state: drive inputs are spread over unrelated buffers\n");
+        release();
+        return false;
+    }
+
+    std::vector<Binding> axes;
+    for (int slave : drives) {
+        const ec_slavet& info = context->slavelist[slave];
+        axes.push_back({slave, (int)(info.outputs - image), (int)(info.inputs - lowest), &table[slave]});
+    }
+    return bind(axes, lowest, image);
+}
+
+// Byte offset of a field in the image, -1 if the axis does not map it whole and byte aligned
+static int32_t fieldOffset(const std::vector<uint32_t>& entries, uint8_t startBit, int base,
+                           uint16_t object, uint8_t size) {
+    PdoOffset at = PdoLayouts::locate(entries, object, 0, startBit);
+    if (!at.valid() || at.bit || at.bits != size * 8) {
+        return -1;
+    }
+    return base + at.byte;
+}
+
+bool AxisState::bind(const std::vector<Binding>& drives, const uint8_t* inputs, uint8_t* outputs) {
+    release();
+    inputBase = inputs;
+    outputBase = outputs;
+    axes = (int)drives.size();
+    padded = (axes + LANES - 1) / LANES * LANES;
+    if (padded == 0) {
+        return true;
+    }
+
+    // values, offsets and masks of every field, each array 64 byte aligned
+    size_t arrays = 3 * (TX_FIELDS + RX_FIELDS);
+    void* memory = nullptr;
+    if (posix_memalign(&memory, 64, arrays * padded * sizeof(int32_t))) {
+        printf("Axis state: cannot allocate %d axes\n", axes);
+        axes = 0;
+        padded = 0;
+        return false;
+    }
+    block = (int32_t*)memory;
+    memset(block, 0, arrays * padded * sizeof(int32_t));
+
+    int32_t* next = block;
+    auto take = [&next, this]() {
+        int32_t* array = next;
+        next += padded;
+        return array;
+    };
+    for (int f = 0; f < TX_FIELDS; f++) {
+        txValues[f] = take();
+        txOffsets[f] = take();
+        txMasks[f] = take();
+    }
+    for (int f = 0; f < RX_FIELDS; f++) {
+        rxValues[f] = take();
+        rxOffsets[f] = take();
+        rxMasks[f] = take();
+    }
+
+    for (int axis = 0; axis < axes; axis++) {
+        const Binding& drive = drives[axis];
+        slaves.push_back(drive.slave);
+        for (int f = 0; f < TX_FIELDS; f++) {
+            int32_t offset = fieldOffset(drive.mapping->tx, drive.mapping->txStartBit, drive.inputs,
+                                         TX_MAP[f].object, TX_MAP[f].size);
+            txOffsets[f][axis] = offset < 0 ? 0 : offset;
+            txMasks[f][axis] = offset < 0 ? 0 : -1;
+        }
+        for (int f = 0; f < RX_FIELDS; f++) {
+            int32_t offset = fieldOffset(drive.mapping->rx, drive.mapping->rxStartBit, drive.outputs,
+                                         RX_MAP[f].object, RX_MAP[f].size);
+            rxOffsets[f][axis] = offset < 0 ? 0 : offset;
+            rxMasks[f][axis] = offset < 0 ? 0 : -1;
+        }
+    }
+    printf("Axis state: %d axes, %s kernels\n", axes, kernelName());
+    return true;
+}
+
+static inline int32_t readField(const uint8_t* at, uint8_t size, bool isSigned) {
+    switch (size) {
+        case 1: return isSigned ? (int32_t)(int8_t)*at : (int32_t)*at;
+        case 2: {
+            uint16_t value;
+            memcpy(&value, at, 2);
+            return isSigned ? (int32_t)(int16_t)value : (int32_t)value;
+        }
+        default: {
+            int32_t value;
+            memcpy(&value, at, 4);
+            return value;
+        }
+    }
+}
+
+static inline void writeField(uint8_t* at, uint8_t size, int32_t value) {
+    switch (size) {
+        case 1: *at = (uint8_t)value; break;
+        case 2: {
+            uint16_t narrow = (uint16_t)value;
+            memcpy(at, &narrow, 2);
+            break;
+        }
+        default: memcpy(at, &value, 4); break;
+    }
+}
+
+void AxisState::unpackScalar() {
+    for (int f = 0; f < TX_FIELDS; f++) {
+        for (int axis = 0; axis < axes; axis++) {
+            if (txMasks[f][axis]) {
+                txValues[f][axis] = readField(inputBase + txOffsets[f][axis], TX_MAP[f].size, TX_MAP[f].isSigned);
+            }
+        }
+    }
+}
+
+void AxisState::packScalar() const {
+    for (int f = 0; f < RX_FIELDS; f++) {
+        for (int axis = 0; axis < axes; axis++) {
+            if (rxMasks[f][axis]) {
+                writeField(outputBase + rxOffsets[f][axis], RX_MAP[f].size, rxValues[f][axis]);
+            }
+        }
+    }
+}
+
+// Eight axes per gather. Narrow fields are read as 32 bits and then sign or
+// zero extended in the register. Reading the last field never runs past the
+// buffer: ProcessImage keeps a tail, and in a frozen frame's receive buffer
+// the working counter follows the data.
+__attribute__((target("avx2")))
+static void gatherFields(const uint8_t* image, int padded, int32_t* values, const int32_t* offsets,
+                         const int32_t* masks, uint8_t size, bool isSigned) {
+    int shift = 32 - size * 8;
+    for (int axis = 0; axis < padded; axis += 8) {
+        __m256i mask = _mm256_load_si256((const __m256i*)(masks + axis));
+        if (_mm256_testz_si256(mask, mask)) {
+            continue;
+        }
+        __m256i old = _mm256_load_si256((const __m256i*)(values + axis));
+        __m256i index = _mm256_load_si256((const __m256i*)(offsets + axis));
+        __m256i value = _mm256_mask_i32gather_epi32(old, (const int*)image, index, mask, 1);
+        if (shift) {
+            value = _mm256_slli_epi32(value, shift);
+            value = isSigned ? _mm256_srai_epi32(value, shift) : _mm256_srli_epi32(value, shift);
+        }
+        _mm256_store_si256((__m256i*)(values + axis), value);
+    }
+}
+
+// AVX2 has no scatter. With AVX-512 the 32 bit setpoints go out 16 axes per
+// store. Narrow fields are always stored one by one, because a 32 bit
+// scatter would overwrite the neighbouring object.
+__attribute__((target("avx512f")))
+static void scatterFields(uint8_t* image, int padded, const int32_t* values, const int32_t* offsets,
+                          const int32_t* masks) {
+    for (int axis = 0; axis < padded; axis += 16) {
+        __m512i mask = _mm512_load_si512((const void*)(masks + axis));
+        __mmask16 lanes = _mm512_test_epi32_mask(mask, mask);
+        if (!lanes) {
+            continue;
+        }
+        __m512i index = _mm512_load_si512((const void*)(offsets + axis));
+        __m512i value = _mm512_load_si512((const void*)(values + axis));
+        _mm512_mask_i32scatter_epi32(image, lanes, index, value, 1);
+    }
+}
+
+static bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+static bool hasAvx512() {
+    static const bool supported = __builtin_cpu_supports("avx512f");
+    return supported;
+}
+
+const char* AxisState::kernelName() {
+    if (hasAvx512()) {
+        return "avx2 gather / avx512 scatter";
+    }
+    return hasAvx2() ? "avx2 gather / scalar store" : "scalar";
+}
+
+void AxisState::unpack() {
+    if (!hasAvx2()) {
+        unpackScalar();
+        return;
+    }
+    for (int f = 0; f < TX_FIELDS; f++) {
+        gatherFields(inputBase, padded, txValues[f], txOffsets[f], txMasks[f], TX_MAP[f].size, TX_MAP[f].isSigned);
+    }
+}
+
+void AxisState::pack() const {
+    if (!hasAvx512()) {
+        packScalar();
+        return;
+    }
+    for (int f = 0; f < RX_FIELDS; f++) {
+        if (RX_MAP[f].size == 4) {
+            scatterFields(outputBase, padded, rxValues[f], rxOffsets[f], rxMasks[f]);
+            continue;
+        }
+        for (int axis = 0; axis < axes; axis++) {
+            if (rxMasks[f][axis]) {
+                writeField(outputBase + rxOffsets[f][axis], RX_MAP[f].size, rxValues[f][axis]);
+            }
+        }
+    }
+}
+
+void AxisState::toTx(int axis, PDOManager::TxPDO& tx) const {
+    tx.statusword = (uint16_t)txValues[STATUSWORD][axis];
+    tx.actual_position = txValues[ACTUAL_POSITION][axis];
+    tx.actual_velocity = txValues[ACTUAL_VELOCITY][axis];
+    tx.actual_torque = (int16_t)txValues[ACTUAL_TORQUE][axis];
+    tx.mode_of_operation_display = (uint8_t)txValues[MODE_DISPLAY][axis];
+}
+
+void AxisState::toRx(int axis, PDOManager::RxPDO& rx) const {
+    rx.controlword = (uint16_t)rxValues[CONTROLWORD][axis];
+    rx.target_position = rxValues[TARGET_POSITION][axis];
+    rx.target_velocity = rxValues[TARGET_VELOCITY][axis];
+    rx.target_torque = (int16_t)rxValues[TARGET_TORQUE][axis];
+    rx.mode_of_operation = (uint8_t)rxValues[MODE][axis];
+}
+
+void AxisState::fill(RxField field, int32_t value) {
+    int32_t* values = rxValues[field];
+    for (int axis = 0; axis < axes; axis++) {
+        values[axis] = value;
+    }
+}
+
+void AxisState::copy(RxField to, TxField from) {
+    int32_t* values = rxValues[to];
+    const int32_t* source = txValues[from];
+    for (int axis = 0; axis < axes; axis++) {
+        values[axis] = source[axis];
+    }
+}
+
+void AxisState::benchmark() {
+    static const int AXES[] = {1, 2, 4, 8, 16, 32, 64, 100, 128, 200};
+    const int ROUNDS = 20000;
+
+    PDOManager::SlaveMapping drive;
+    drive.rx = cia402::RxFull::mapping();
+    drive.tx = cia402::TxFull::mapping();
+    int stride = (int)(cia402::RxFull::size + cia402::TxFull::size);
+
+    printf("Axis state pack+unpack, full layout, %s kernels\n", kernelName());
+    printf("%6s %12s %12s %10s\n", "axes", "vector ns", "scalar ns", "ns/axis");
+    for (int count : AXES) {
+        // Drives back to back like the packed IOmap layout: outputs then inputs
+        std::vector<uint8_t> image(count * stride + 8);
+        std::vector<Binding> drives;
+        for (int axis = 0; axis < count; axis++) {
+            drives.push_back({axis + 1, axis * stride, axis * stride + (int)cia402::RxFull::size, &drive});
+        }
+        AxisState state;
+        state.bind(drives, image.data(), image.data());
+
+        auto time = [&](bool vector) {
+            auto start = std::chrono::steady_clock::now();
+            for (int round = 0; round < ROUNDS; round++) {
+                if (vector) {
+                    state.unpack();
+                    state.pack();
+                } else {
+                    state.unpackScalar();
+                    state.packScalar();
+                }
+            }
+            return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+        };
+        double vectorNs = time(true);
+        double scalarNs = time(false);
+        printf("%6d %12.1f %12.1f %10.2f\n", count, vectorNs, scalarNs, vectorNs / count);
+    }
+}
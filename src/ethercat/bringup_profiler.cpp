@@ -0,0 +1,106 @@
+#include "bringup_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <map>
+
+static int64_t steadyClockUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BringupProfiler::BringupProfiler() : originUs(steadyClockUs()) {
+}
+
+BringupProfiler::Scope::Scope(const std::string& name, const char* category, int slave)
+    : name(name), category(category), slave(slave),
+      startUs(BringupProfiler::getInstance().nowUs()), open(true) {
+}
+
+void BringupProfiler::Scope::end() {
+    if (!open) return;
+    open = false;
+    BringupProfiler& profiler = BringupProfiler::getInstance();
+    profiler.record(name, category, slave, startUs, profiler.nowUs() - startUs);
+}
+
+int BringupProfiler::currentThreadId() {
+    static std::atomic<int> nextId(1);
+    thread_local int id = nextId++;
+    return id;
+}
+
+void BringupProfiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    spans.clear();
+    originUs = steadyClockUs();
+}
+
+int64_t BringupProfiler::nowUs() const {
+    return steadyClockUs() - originUs;
+}
+
+void BringupProfiler::record(const std::string& name, const char* category, int slave,
+                             int64_t startUs, int64_t durationUs) {
+    Span span{name, category, slave, currentThreadId(), startUs, durationUs};
+    std::lock_guard<std::mutex> lock(mutex);
+    spans.push_back(span);
+}
+
+bool BringupProfiler::writeChromeTrace(const std::string& path) const {
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        printf("Failed to write bring-up trace to %s\n", path.c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < spans.size(); i++) {
+        const Span& span = spans[i];
+        fprintf(file, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+                      "\"pid\":1,\"tid\":%d,\"args\":{\"slave\":%d}}%s\n",
+                span.name.c_str(), span.category.c_str(),
+                (long long)span.startUs, (long long)span.durationUs,
+                span.thread, span.slave, (i + 1 < spans.size()) ? "," : "");
+    }
+    fprintf(file, "],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(file);
+
+    printf("Bring-up trace with %zu spans written to %s\n", spans.size(), path.c_str());
+    return true;
+}
+
+void BringupProfiler::printSummary() const {
+    struct Total {
+        int count = 0;
+        int64_t totalUs = 0;
+        int64_t maxUs = 0;
+    };
+
+    std::map<std::string, Total> totals;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const Span& span : spans) {
+            Total& total = totals[span.category + "/" + span.name];
+            total.count++;
+            total.totalUs += span.durationUs;
+            total.maxUs = std::max(total.maxUs, span.durationUs);
+        }
+    }
+
+    std::vector<std::pair<std::string, Total>> rows(totals.begin(), totals.end());
+    std::sort(rows.begin(), rows.end(), [](const std::pair<std::string, Total>& a,
+                                           const std::pair<std::string, Total>& b) {
+        return a.second.totalUs > b.second.totalUs;
+    });
+
+    printf("\nBring-up profile (%.1f ms since reset):\n", nowUs() / 1000.0);
+    printf("%-40s %8s %12s %12s\n", "span", "count", "total [ms]", "max [ms]");
+    for (const auto& row : rows) {
+        printf("%-40s %8d %12.2f %12.2f\n", row.first.c_str(), row.second.count,
+               row.second.totalUs / 1000.0, row.second.maxUs / 1000.0);
+    }
+}
@@ -0,0 +1,189 @@
+#include "cia402_fsm.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Controlword per command and drive state (CiA402 device control commands)
+const uint16_t Cia402Fsm::CONTROL[COMMANDS][STATES] = {
+    //  not ready  sw.on dis.  ready     sw.on     enabled   q.stop    f.react.  fault
+    {   0x0000,    0x0000,     0x0000,   0x0006,   0x0007,   0x0000,   0x0000,   0x0000 },  // DISABLE
+    {   0x0000,    0x0006,     0x0006,   0x0006,   0x0006,   0x0000,   0x0000,   0x0000 },  // READY
+    {   0x0000,    0x0006,     0x0007,   0x000F,   0x000F,   0x0000,   0x0000,   0x0080 },  // ENABLE
+    {   0x0000,    0x0000,     0x0006,   0x0007,   0x000F,   0x0002,   0x0000,   0x0000 },  // HOLD
+    {   0x0000,    0x0000,     0x0002,   0x0002,   0x0002,   0x0002,   0x0000,   0x0000 },  // QUICK_STOP
+};
+
+const uint8_t Cia402Fsm::POWERED[STATES] = {0, 0, 1, 1, 1, 1, 0, 0};
+
+const uint8_t* Cia402Fsm::buildDecodeTable() {
+    static uint8_t table[64];
+    for (int index = 0; index < 64; index++) {
+        // Back to statusword bits 0-3, 5 and 6
+        uint16_t sw = (uint16_t)((index & 0x0F) | ((index & 0x30) << 1));
+        State state = (sw & 0x08) ? FAULT : NOT_READY;
+        if ((sw & 0x4F) == 0x40) state = SWITCH_ON_DISABLED;
+        else if ((sw & 0x6F) == 0x21) state = READY_TO_SWITCH_ON;
+        else if ((sw & 0x6F) == 0x23) state = SWITCHED_ON;
+        else if ((sw & 0x6F) == 0x27) state = OPERATION_ENABLED;
+        else if ((sw & 0x6F) == 0x07) state = QUICK_STOP_ACTIVE;
+        else if ((sw & 0x4F) == 0x0F) state = FAULT_REACTION_ACTIVE;
+        else if ((sw & 0x4F) == 0x08) state = FAULT;
+        table[index] = state;
+    }
+    return table;
+}
+
+const uint8_t* const Cia402Fsm::DECODE = Cia402Fsm::buildDecodeTable();
+
+void Cia402Fsm::resize(int count) {
+    axes = count;
+    goals.assign(count, DISABLE);
+    states.assign(count, NOT_READY);
+    flags.assign(count, 0);
+    lastControl.assign(count, 0);
+    memset(counts, 0, sizeof(counts));
+    counts[NOT_READY] = count;
+    powered = 0;
+}
+
+void Cia402Fsm::commandAll(Command command) {
+    memset(goals.data(), command, goals.size());
+}
+
+void Cia402Fsm::newSetpoint(int axis) {
+    // A target that changes while bit 4 is up is raised again after the acknowledge
+    flags[axis] |= (lastControl[axis] & 0x10) ? SETPOINT_REPEAT : SETPOINT_PENDING;
+}
+
+void Cia402Fsm::newSetpointAll() {
+    for (int axis = 0; axis < axes; axis++) {
+        newSetpoint(axis);
+    }
+}
+
+int Cia402Fsm::step(const int32_t* statuswords, int32_t* controlwords) {
+    int queued = 0;
+    int seen[STATES] = {};
+    int poweredAxes = 0;
+    cycle++;
+
+    for (int axis = 0; axis < axes; axis++) {
+        uint16_t sw = (uint16_t)statuswords[axis];
+        uint8_t state = DECODE[statusIndex(sw)];
+        uint16_t last = lastControl[axis];
+        uint8_t flag = flags[axis];
+        uint16_t cw = CONTROL[goals[axis]][state];
+
+        // Fault reset acts on the rising edge of bit 7, alternate it with 0
+        cw &= (uint16_t)~(last & 0x80);
+
+        // New setpoint handshake: bit 4 up until statusword bit 12 answers, a
+        // further setpoint waits until the drive has dropped the acknowledge
+        int ack = (sw >> 12) & 1;
+        int sent = (last >> 4) & 1;
+        int enabled = (state == OPERATION_ENABLED) & ((goals[axis] == ENABLE) | (goals[axis] == HOLD));
+        int acknowledged = sent & ack;
+        int raise = (flag & SETPOINT_PENDING) & !acknowledged & !(ack & !sent) & enabled;
+        int reached = ((flag & MOVING) >> 1) & (sw >> 10) & !ack & 1;
+        cw |= (uint16_t)(raise << 4);
+
+        if (acknowledged) {
+            flag = (uint8_t)((flag & ~(SETPOINT_PENDING | SETPOINT_REPEAT)) | MOVING |
+                             ((flag & SETPOINT_REPEAT) ? SETPOINT_PENDING : 0));
+        }
+        flag &= (uint8_t)~((reached | !enabled) ? MOVING : 0);
+
+        controlwords[axis] = cw;
+        lastControl[axis] = cw;
+        flags[axis] = flag;
+        seen[state]++;
+        poweredAxes += POWERED[state];
+
+        if (state != states[axis]) {
+            push(Event::TRANSITION, axis, states[axis], state, sw, cw);
+            states[axis] = state;
+            queued++;
+        }
+        if (acknowledged | reached) {
+            push(acknowledged ? Event::SETPOINT_ACKNOWLEDGED : Event::TARGET_REACHED, axis, state, state, sw, cw);
+            queued++;
+        }
+    }
+
+    memcpy(counts, seen, sizeof(counts));
+    powered = poweredAxes;
+    return queued;
+}
+
+void Cia402Fsm::notify(Event::Type type, int axis) {
+    push(type, axis, states[axis], states[axis], 0, lastControl[axis]);
+}
+
+void Cia402Fsm::push(Event::Type type, int axis, uint8_t from, uint8_t to, uint16_t statusword,
+                     uint16_t controlword) {
+    uint32_t at = head.load(std::memory_order_relaxed);
+    if (at - tail.load(std::memory_order_acquire) >= EVENT_CAPACITY) {
+        droppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    events[at & (EVENT_CAPACITY - 1)] = {type, from, to, (uint16_t)axis, statusword, controlword, cycle};
+    head.store(at + 1, std::memory_order_release);
+}
+
+bool Cia402Fsm::poll(Event& event) {
+    uint32_t at = tail.load(std::memory_order_relaxed);
+    if (at == head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    event = events[at & (EVENT_CAPACITY - 1)];
+    tail.store(at + 1, std::memory_order_release);
+    return true;
+}
+
+const char* Cia402Fsm::stateName(uint8_t state) {
+    static const char* names[STATES] = {
+        "not ready to switch on", "switch on disabled", "ready to switch on", "switched on",
+        "operation enabled", "quick stop active", "fault reaction active", "fault"};
+    return state < STATES ? names[state] : "unknown";
+}
+
+const char* Cia402Fsm::commandName(uint8_t command) {
+    static const char* names[COMMANDS] = {"disable", "ready", "enable", "hold", "quick stop"};
+    return command < COMMANDS ? names[command] : "unknown";
+}
+
+void Cia402Fsm::benchmark() {
+    static const int AXES[] = {1, 2, 4, 8, 16, 32, 64, 100, 128, 200};
+    const int ROUNDS = 20000;
+
+    printf("CiA402 state machine step\n");
+    printf("%6s %12s %12s %12s\n", "axes", "steady ns", "switching ns", "ns/axis");
+    for (int count : AXES) {
+        std::vector<int32_t> statuswords(count);
+        std::vector<int32_t> controlwords(count);
+        Cia402Fsm fsm;
+        fsm.resize(count);
+        fsm.commandAll(ENABLE);
+
+        // steady: every drive holds operation enabled; switching: every drive
+        // changes between ready to switch on and switched on each cycle
+        auto time = [&](bool switching) {
+            Event event;
+            auto start = std::chrono::steady_clock::now();
+            for (int round = 0; round < ROUNDS; round++) {
+                int32_t sw = switching ? ((round & 1) ? 0x0233 : 0x0231) : 0x0237;
+                for (int axis = 0; axis < count; axis++) {
+                    statuswords[axis] = sw;
+                }
+                fsm.step(statuswords.data(), controlwords.data());
+                while (fsm.poll(event)) {
+                }
+            }
+            return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ROUNDS;
+        };
+        double steadyNs = time(false);
+        double switchingNs = time(true);
+        printf("%6d %12.1f %12.1f %12.2f\n", count, steadyNs, switchingNs, steadyNs / count);
+    }
+}
@@ -1,22 +1,29 @@
 // Function: Implement time synchronization and cycle control
 
 #include "dc_manager.h"
+#include "bringup_profiler.h"
+#include "task_groups.h"
 #include <cstdio>
 #include <unistd.h>
 
 extern ecx_contextt ecx_context;
 
 bool DCManager::configureDC() {
+    return configureDC(&ecx_context, 1000000);
+}
+
+bool DCManager::configureDC(ecx_contextt* context, uint32_t cycleTime) {
     printf("Configuring DC...\n");
     
 
         
-    for (int i = 1; i <= ec_slavecount; i++) {
+    for (int i = 1; i <= *context->slavecount; i++) {
         // Configure DC for each slave
-        ecx_dcsync0(&ecx_context, i, TRUE, 1000000, 0);  // 500us cycle time
+        BringupProfiler::Scope span("DC sync0 setup", "slave", i);
+        ecx_dcsync0(context, i, TRUE, cycleTime, 0);
         // Verify configuration
-        if (ec_slave[i].hasdc) {
-            if (!ec_slave[i].DCactive) {
+        if (context->slavelist[i].hasdc) {
+            if (!context->slavelist[i].DCactive) {
                 printf("Warning: DC not active for slave %d\n", i);
                 return false;
             }
@@ -25,11 +32,50 @@ bool DCManager::configureDC() {
     }
     
     // Configure DC
-    ec_configdc();
+    {
+        BringupProfiler::Scope span("ec_configdc", "config");
+        ecx_configdc(context);
+        TaskGroups::shareDC(context);
+    }
     
     // Wait for DC configuration to take effect
-    osal_usleep(200000);  // 200ms
+    {
+        BringupProfiler::Scope span("DC settle delay", "sleep");
+        osal_usleep(200000);  // 200ms
+    }
+
+    return true;
+}
 
+bool DCManager::attachDC() {
+    return attachDC(&ecx_context);
+}
+
+bool DCManager::attachDC(ecx_contextt* context) {
+    printf("Attaching to running DC...\n");
+
+    // With warmstart set on the context this only builds the DC chain, offsets stay untouched
+    {
+        BringupProfiler::Scope span("ec_configdc (attach)", "config");
+        ecx_configdc(context);
+        TaskGroups::shareDC(context);
+    }
+
+    for (int i = 1; i <= *context->slavecount; i++) {
+        ec_slavet& slave = context->slavelist[i];
+        if (!slave.hasdc) continue;
+
+        uint8 syncAct = 0;
+        uint32 cycle = 0;
+        ecx_FPRD(context->port, slave.configadr, ECT_REG_DCSYNCACT, sizeof(syncAct), &syncAct, EC_TIMEOUTRET);
+        ecx_FPRD(context->port, slave.configadr, ECT_REG_DCCYCLE0, sizeof(cycle), &cycle, EC_TIMEOUTRET);
+        slave.DCactive = (syncAct & 0x03) == 0x03;
+        slave.DCcycle = (int32)etohl(cycle);
+        if (!slave.DCactive) {
+            printf("Warning: DC not active for slave %d\n", i);
+            return false;
+        }
+    }
     return true;
 }
 
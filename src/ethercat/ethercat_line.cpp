@@ -0,0 +1,263 @@
+#include "ethercat_line.h"
+#include "dc_manager.h"
+#include "pdo_manager.h"
+#include "sii_cache.h"
+#include "task_groups.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+
+std::mutex EtherCATLine::configMutex;
+
+EtherCATLine::EtherCATLine(int lineId, const std::string& name, int core)
+    : id(lineId), ifname(name), cpu(core), slaves(1) {
+    memset(&port, 0, sizeof(port));
+    memset(groups, 0, sizeof(groups));
+    memset(&elist, 0, sizeof(elist));
+    memset(&idxstack, 0, sizeof(idxstack));
+
+    // Same layout as the default context in ethercatmain.c
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.port = &port;
+    ctx.slavelist = slaves.data();
+    ctx.slavecount = &slaveCount;
+    ctx.maxslave = (int)slaves.size();
+    ctx.grouplist = groups;
+    ctx.maxgroup = EC_MAXGROUP;
+    ctx.esibuf = esibuf;
+    ctx.esimap = esimap;
+    ctx.elist = &elist;
+    ctx.idxstack = &idxstack;
+    ctx.ecaterror = &ecatError;
+    ctx.DCtime = &dcTime;
+    ctx.SMcommtype = smCommtype;
+    ctx.PDOassign = pdoAssign;
+    ctx.PDOdesc = pdoDesc;
+    ctx.eepSM = &eepSM;
+    ctx.eepFMMU = &eepFMMU;
+    ctx.userdata = this;
+}
+
+EtherCATLine::~EtherCATLine() {
+    stop();
+    if (opened) {
+        ecx_close(&ctx);
+    }
+}
+
+bool EtherCATLine::configure(int cycle) {
+    std::lock_guard<std::mutex> lock(configMutex);
+    cycleUs = cycle;
+
+    printf("Line %d: opening %s\n", id, ifname.c_str());
+    if (ecx_init(&ctx, ifname.c_str()) <= 0) {
+        printf("Line %d: cannot open %s\n", id, ifname.c_str());
+        return false;
+    }
+    opened = true;
+
+    // Size the slave list to the line before the scan fills it
+    int found = ecx_countslaves(&ctx);
+    if (found <= 0) {
+        printf("Line %d: no slaves found\n", id);
+        return false;
+    }
+    slaves.assign(found + 1, ec_slavet());
+    ctx.slavelist = slaves.data();
+    ctx.maxslave = (int)slaves.size();
+
+    SIICache::getInstance().attach(&ctx);
+    if (ecx_config_init(&ctx, FALSE) <= 0) {
+        printf("Line %d: no slaves found\n", id);
+        return false;
+    }
+    printf("Line %d: %d slaves found\n", id, slaveCount);
+
+    if (ecx_statecheck(&ctx, 0, EC_STATE_PRE_OP, EC_TIMEOUTSTATE * 4) != EC_STATE_PRE_OP) {
+        printf("Line %d: not all slaves reached PRE_OP\n", id);
+        return false;
+    }
+    if (!PDOManager::configureMapping(&ctx, processImage)) {
+        printf("Line %d: PDO mapping failed\n", id);
+        return false;
+    }
+    if (!DCManager::getInstance().configureDC(&ctx, (uint32_t)cycleUs * 1000)) {
+        printf("Line %d: DC configuration failed\n", id);
+        return false;
+    }
+    TaskGroups::setCycle(&ctx, cycleUs);
+    expectedWKC = TaskGroups::expectedWKC(&ctx, 0);
+
+    slaves[0].state = EC_STATE_SAFE_OP;
+    ecx_writestate(&ctx, 0);
+    if (ecx_statecheck(&ctx, 0, EC_STATE_SAFE_OP, EC_TIMEOUTSTATE * 4) != EC_STATE_SAFE_OP) {
+        printf("Line %d: not all slaves reached SAFE_OP\n", id);
+        return false;
+    }
+    printf("Line %d: SAFE_OP, expected WKC %d\n", id, expectedWKC);
+    TaskGroups::print(&ctx);
+    return true;
+}
+
+bool EtherCATLine::start() {
+    running.store(true);
+    rtThread = std::thread(&EtherCATLine::cycleLoop, this);
+
+    // Slaves only go to OP while valid outputs arrive, so request it with the cycle running
+    slaves[0].state = EC_STATE_OPERATIONAL;
+    ecx_writestate(&ctx, 0);
+    if (ecx_statecheck(&ctx, 0, EC_STATE_OPERATIONAL, EC_TIMEOUTSTATE * 4) != EC_STATE_OPERATIONAL) {
+        printf("Line %d: not all slaves reached OP\n", id);
+        return false;
+    }
+    printf("Line %d: OP on CPU %d, %d us cycle\n", id, cpu, cycleUs);
+    return true;
+}
+
+void EtherCATLine::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    if (rtThread.joinable()) {
+        rtThread.join();
+    }
+    slaves[0].state = EC_STATE_INIT;
+    ecx_writestate(&ctx, 0);
+}
+
+void EtherCATLine::cycleLoop() {
+    struct sched_param param;
+    param.sched_priority = 98;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+        printf("Line %d: failed to set RT priority\n", id);
+    }
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet)) {
+        printf("Line %d: failed to pin RT thread to CPU %d\n", id, cpu);
+    }
+    ecx_setwaitmode(EC_WAIT_SPIN);
+
+    const int64_t cycleNs = (int64_t)cycleUs * 1000;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    uint32_t cycle = 0;
+
+    while (running.load()) {
+        next.tv_nsec += cycleNs;
+        while (next.tv_nsec >= 1000000000) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        struct timespec woke, done;
+        clock_gettime(CLOCK_MONOTONIC, &woke);
+        int64_t latencyNs = (woke.tv_sec - next.tv_sec) * 1000000000LL + (woke.tv_nsec - next.tv_nsec);
+
+        int expected = TaskGroups::send(&ctx, cycle++);
+        int wkc = TaskGroups::receive(&ctx, EC_TIMEOUTRET);
+        clock_gettime(CLOCK_MONOTONIC, &done);
+        int64_t exchangeNs = (done.tv_sec - woke.tv_sec) * 1000000000LL + (done.tv_nsec - woke.tv_nsec);
+
+        if (cycleHook) {
+            cycleHook(*this);
+        }
+
+        int latencyUs = (int)(latencyNs / 1000);
+        int exchangeUs = (int)(exchangeNs / 1000);
+        cycleCount++;
+        latencySumUs += latencyUs;
+        exchangeSumUs += exchangeUs;
+        if (wkc < expected) {
+            wkcErrorCount++;
+        }
+        if (latencyNs >= cycleNs) {
+            overrunCount++;
+        }
+        if (latencyUs > maxLatencyUs.load()) {
+            maxLatencyUs.store(latencyUs);
+        }
+        if (exchangeUs > maxExchangeUs.load()) {
+            maxExchangeUs.store(exchangeUs);
+        }
+    }
+}
+
+EtherCATLine::Stats EtherCATLine::getStats() const {
+    Stats stats;
+    stats.cycles = cycleCount.load();
+    stats.wkcErrors = wkcErrorCount.load();
+    stats.overruns = overrunCount.load();
+    stats.avgLatencyUs = stats.cycles ? (double)latencySumUs.load() / stats.cycles : 0.0;
+    stats.maxLatencyUs = maxLatencyUs.load();
+    stats.avgExchangeUs = stats.cycles ? (double)exchangeSumUs.load() / stats.cycles : 0.0;
+    stats.maxExchangeUs = maxExchangeUs.load();
+    return stats;
+}
+
+void EtherCATLine::printStats() const {
+    Stats stats = getStats();
+    printf("Line %d (%s, CPU %d, %d slaves): %llu cycles, latency avg %.1f us max %d us, "
+           "exchange avg %.1f us max %d us, %llu WKC errors, %llu overruns\n",
+           id, ifname.c_str(), cpu, slaveCount, (unsigned long long)stats.cycles,
+           stats.avgLatencyUs, stats.maxLatencyUs, stats.avgExchangeUs, stats.maxExchangeUs,
+           (unsigned long long)stats.wkcErrors, (unsigned long long)stats.overruns);
+}
+
+bool LineManager::addLine(const std::string& spec) {
+    std::string ifname = spec;
+    int cpu = FIRST_LINE_CPU + (int)lines.size();
+
+    size_t at = spec.find('@');
+    if (at != std::string::npos) {
+        ifname = spec.substr(0, at);
+        cpu = atoi(spec.c_str() + at + 1);
+    }
+    if (ifname.empty() || cpu < 0 || cpu >= CPU_SETSIZE) {
+        printf("Invalid line specification '%s'\n", spec.c_str());
+        return false;
+    }
+    for (const auto& line : lines) {
+        if (line->getInterface() == ifname) {
+            printf("Interface %s is already used by line %d\n", ifname.c_str(), line->getId());
+            return false;
+        }
+    }
+    lines.emplace_back(new EtherCATLine((int)lines.size() + 1, ifname, cpu));
+    return true;
+}
+
+bool LineManager::startAll(int cycleUs) {
+    bool ok = true;
+    ecx_setwaitmode(EC_WAIT_POLL);
+    for (auto& line : lines) {
+        line->image().setHugePages(hugePages);
+        line->image().setLayout(layout);
+        if (!line->configure(cycleUs) || !line->start()) {
+            printf("Line %d on %s failed to start\n", line->getId(), line->getInterface().c_str());
+            ok = false;
+        }
+    }
+    SIICache::getInstance().save();
+    return ok;
+}
+
+void LineManager::stopAll() {
+    for (auto& line : lines) {
+        line->stop();
+    }
+    printStats();
+}
+
+void LineManager::printStats() const {
+    for (const auto& line : lines) {
+        line->printStats();
+    }
+}
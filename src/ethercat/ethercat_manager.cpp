@@ -2,29 +2,72 @@
 // Implement state recovery mechanism
 
 #include "ethercat_manager.h"
+#include "bringup_profiler.h"
+#include "sii_cache.h"
+#include "task_groups.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
 
-bool EtherCATManager::initialize(const std::string& ifname) {
+extern ecx_contextt ecx_context;
+
+const char* EtherCATManager::WARM_START_FILE = "warm_start.txt";
+
+bool EtherCATManager::initialize(const std::string& ifname, const std::string& secondary) {
     log("__________STEP 1___________________");
     log("Initializing EtherCAT...");
     
-    if (ec_init(ifname.c_str()) <= 0) {
+    interface = ifname;
+    secondaryInterface = secondary;
+    int opened;
+    BringupProfiler::Scope initSpan("ec_init", "config");
+    if (secondary.empty()) {
+        opened = ec_init(ifname.c_str());
+    } else {
+        // Frames leave on both ports, on a closed ring each comes back on the other one
+        log("Cable redundancy: primary " + ifname + ", secondary " + secondary);
+        std::string if2name = secondary;
+        opened = ec_init_redundant(ifname.c_str(), &if2name[0]);
+    }
+    ringMonitor.reset();
+    if (opened <= 0) {
         log("Error: Could not initialize EtherCAT master!");
         log("No socket connection on Ethernet port. Execute as root.");
         log("___________________________________________");
         return false;
     }
+    initSpan.end();
     log("EtherCAT master initialized successfully.");
     log("___________________________________________");
 
-    // Search for EtherCAT slaves on the network
-    if (ec_config_init(FALSE) <= 0) {
+    // Slaves still running with the configuration of the last session are kept in their state
+    warmStart = probeWarmStart();
+    ecx_context.warmstart = warmStart ? 1 : 0;
+    if (warmStart) {
+        log("Warm start: line matches last configuration, slaves keep their state.");
+    }
+
+    // Search for EtherCAT slaves on the network, this reads the SII of every
+    // slave unless it is already known to the SII cache
+    SIICache::getInstance().attach();
+    BringupProfiler::Scope configSpan("ec_config_init (SII read)", "config");
+    int found = ec_config_init(FALSE);
+    if (found > 0 && warmStart && !matchesWarmIdentities()) {
+        log("Warm start: slave identities changed, falling back to cold start.");
+        endWarmStart();
+        found = ec_config_init(FALSE);
+    }
+    if (found <= 0) {
         log("Error: Cannot find EtherCAT slaves!");
         log("___________________________________________");
         ec_close(); // Close the EtherCAT connection
         return false;
     }
+    configSpan.end();
+    SIICache::getInstance().save();
     log(std::to_string(ec_slavecount) + " slaves found and configured.");
     log("___________________________________________");
     
@@ -32,13 +75,14 @@ bool EtherCATManager::initialize(const std::string& ifname) {
     return true;
 }
 
+// Outside the RT loop every group is exchanged, as in cycle 0
 bool EtherCATManager::sendProcessData() {
-    workingCounter = ec_send_processdata();
-    return workingCounter > 0;
+    expectedWKC = TaskGroups::send(&ecx_context, 0);
+    return true;
 }
 
 int EtherCATManager::receiveProcessData(int timeout) {
-    workingCounter = ec_receive_processdata(timeout);
+    workingCounter = TaskGroups::receive(&ecx_context, timeout);
     return workingCounter;
 }
 
@@ -46,6 +90,7 @@ void EtherCATManager::cleanup() {
     if (!initialized) return; // Prevent cleanup when not initialized
     ec_slave[0].state = EC_STATE_INIT;
     ec_writestate(0);
+    TaskGroups::unfreeze(&ecx_context);
     ec_close();
     initialized = false;
 }
@@ -76,13 +121,15 @@ bool EtherCATManager::configureSlaves() {
 
 bool EtherCATManager::configurePDOs() {
     for (int slave = 1; slave <= ec_slavecount; slave++) {
-        if (!PDOManager::configurePDOs(slave)) {
+        if (!PDOManager::configurePDOs(&ecx_context, slave)) {
             return false;
         }
     }
     
-    // Configure PDO mapping to IOmap
-    ec_config_map(&IOmap);
+    // Configure PDO mapping into the process image
+    if (PDOManager::processImage().map(&ecx_context) <= 0) {
+        return false;
+    }
     
     // Calculate expected working counter value
     expectedWKC = (ec_group[0].outputsWKC * 2) + ec_group[0].inputsWKC;
@@ -95,28 +142,28 @@ bool EtherCATManager::checkState() {
     ec_readstate();
     printf("\nChecking slave states...\n");
     
+    std::vector<int> notPreOp;
     for (int i = 1; i <= ec_slavecount; i++) {
         printf("Slave %d - State: 0x%02x, AL Status: 0x%04x - %s\n",
                i, ec_slave[i].state, ec_slave[i].ALstatuscode,
                ec_ALstatuscode2string(ec_slave[i].ALstatuscode));
         
         if (ec_slave[i].state != EC_STATE_PRE_OP) {
-            printf("Requesting INIT state for slave %d\n", i);
-            ec_slave[i].state = EC_STATE_INIT;
-            ec_writestate(i);
-            
-            if (!waitForState(i, EC_STATE_INIT)) {
-                printf("Failed to reach INIT state for slave %d\n", i);
-                return false;
-            }
+            notPreOp.push_back(i);
+        }
+    }
+
+    // Force all slaves that are not in PRE-OP to INIT together
+    if (!notPreOp.empty()) {
+        printf("Requesting INIT state for %zu slaves\n", notPreOp.size());
+        if (!transitionSlaves(notPreOp, EC_STATE_INIT)) {
+            printf("Failed to reach INIT state\n");
+            return false;
         }
     }
 
     // Set all slaves to PRE-OP state
-    ec_slave[0].state = EC_STATE_PRE_OP;
-    ec_writestate(0);
-    
-    if (!waitForState(0, EC_STATE_PRE_OP)) {
+    if (!setState(EC_STATE_PRE_OP)) {
         printf("Failed to reach PRE-OP state for all slaves\n");
         return false;
     }
@@ -125,28 +172,242 @@ bool EtherCATManager::checkState() {
     return true;
 }
 
+void EtherCATManager::endWarmStart() {
+    warmStart = false;
+    ecx_context.warmstart = 0;
+}
+
+std::string EtherCATManager::identityKey(int slave) {
+    char key[32];
+    snprintf(key, sizeof(key), "%08X:%08X:%08X",
+             (unsigned)ec_slave[slave].eep_man, (unsigned)ec_slave[slave].eep_id,
+             (unsigned)ec_slave[slave].eep_rev);
+    return key;
+}
+
+// FNV-1a over the registers that describe position, process data layout and DC
+// setup of every slave, read with auto-increment addressing before configuration
+uint32_t EtherCATManager::lineFingerprint(int slaveCount) {
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const uint8* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+    };
+
+    // Same register set for every slave, all of them queued into shared frames
+    struct Registers {
+        uint8 escType[8];
+        uint16 stationAddress;
+        uint16 dlStatus;
+        uint8 sm[16];
+        uint8 fmmu[32];
+        uint8 syncAct;
+        uint32 sync0Cycle;
+    };
+    std::vector<Registers> regs(slaveCount);
+    std::vector<ec_batchdgt> batch;
+    batch.reserve(slaveCount * 7);
+    memset(regs.data(), 0, regs.size() * sizeof(Registers));
+
+    for (int slave = 1; slave <= slaveCount; slave++) {
+        Registers& r = regs[slave - 1];
+        uint16 adp = (uint16)(1 - slave);
+        auto read = [&batch, adp](uint16 ado, uint16 length, void* data) {
+            ec_batchdgt dg = {EC_CMD_APRD, adp, ado, length, data, 0};
+            batch.push_back(dg);
+        };
+        read(ECT_REG_TYPE, sizeof(r.escType), r.escType);
+        read(ECT_REG_STADR, sizeof(r.stationAddress), &r.stationAddress);
+        read(ECT_REG_DLSTAT, sizeof(r.dlStatus), &r.dlStatus);
+        read(ECT_REG_SM2, sizeof(r.sm), r.sm);
+        read(ECT_REG_FMMU0, sizeof(r.fmmu), r.fmmu);
+        read(ECT_REG_DCSYNCACT, sizeof(r.syncAct), &r.syncAct);
+        read(ECT_REG_DCCYCLE0, sizeof(r.sync0Cycle), &r.sync0Cycle);
+    }
+    for (size_t i = 0; i < batch.size(); i += EC_MAXBATCH) {
+        int n = (int)std::min(batch.size() - i, (size_t)EC_MAXBATCH);
+        ec_batch(n, &batch[i], EC_TIMEOUTRET3);
+    }
+
+    for (Registers& r : regs) {
+        // Port link and loop bits only, SM status bytes change with every exchange
+        r.dlStatus = htoes(etohs(r.dlStatus) & 0xFFF0);
+        r.sm[5] = 0;
+        r.sm[13] = 0;
+
+        mix(r.escType, sizeof(r.escType));
+        mix((const uint8*)&r.stationAddress, sizeof(r.stationAddress));
+        mix((const uint8*)&r.dlStatus, sizeof(r.dlStatus));
+        mix(r.sm, sizeof(r.sm));
+        mix(r.fmmu, sizeof(r.fmmu));
+        mix(&r.syncAct, sizeof(r.syncAct));
+        mix((const uint8*)&r.sync0Cycle, sizeof(r.sync0Cycle));
+    }
+    return hash;
+}
+
+bool EtherCATManager::probeWarmStart() {
+    warmIdentities.clear();
+
+    std::ifstream file(PDOManager::cacheFile(WARM_START_FILE));
+    int savedCount = 0;
+    uint32_t savedFingerprint = 0;
+    if (!(file >> savedCount >> std::hex >> savedFingerprint)) {
+        return false;
+    }
+    std::string key;
+    while (file >> key) {
+        warmIdentities.push_back(key);
+    }
+
+    uint16 w = 0;
+    int count = ec_BRD(0x0000, ECT_REG_TYPE, sizeof(w), &w, EC_TIMEOUTSAFE);
+    if (count != savedCount || (int)warmIdentities.size() != savedCount) {
+        printf("Warm start: %d slaves found, %d expected\n", count, savedCount);
+        return false;
+    }
+
+    std::vector<uint16> alStatus(count, 0);
+    std::vector<ec_batchdgt> batch(count);
+    for (int slave = 1; slave <= count; slave++) {
+        ec_batchdgt dg = {EC_CMD_APRD, (uint16)(1 - slave), ECT_REG_ALSTAT,
+                          sizeof(uint16), &alStatus[slave - 1], 0};
+        batch[slave - 1] = dg;
+    }
+    for (int i = 0; i < count; i += EC_MAXBATCH) {
+        ec_batch(std::min(count - i, EC_MAXBATCH), &batch[i], EC_TIMEOUTRET3);
+    }
+    for (int slave = 1; slave <= count; slave++) {
+        // A slave with the error bit set is not adopted, it needs the cold bring-up
+        uint16 state = etohs(alStatus[slave - 1]) & 0x1F;
+        if (state != EC_STATE_SAFE_OP && state != EC_STATE_OPERATIONAL) {
+            printf("Warm start: slave %d in state 0x%02x\n", slave, etohs(alStatus[slave - 1]));
+            return false;
+        }
+    }
+
+    uint32_t fingerprint = lineFingerprint(count);
+    if (fingerprint != savedFingerprint) {
+        printf("Warm start: line fingerprint %08X differs from saved %08X\n",
+               fingerprint, savedFingerprint);
+        return false;
+    }
+    return true;
+}
+
+bool EtherCATManager::matchesWarmIdentities() const {
+    if ((int)warmIdentities.size() != ec_slavecount) {
+        return false;
+    }
+    for (int slave = 1; slave <= ec_slavecount; slave++) {
+        if (identityKey(slave) != warmIdentities[slave - 1]) {
+            printf("Warm start: slave %d is %s, expected %s\n",
+                   slave, identityKey(slave).c_str(), warmIdentities[slave - 1].c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Called once the line is in OP, the next session may then re-attach without a reset
+void EtherCATManager::saveLineFingerprint() {
+    std::string path = PDOManager::cacheFile(WARM_START_FILE);
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        printf("Warning: cannot write %s\n", path.c_str());
+        return;
+    }
+    file << ec_slavecount << " " << std::hex << lineFingerprint(ec_slavecount) << "\n";
+    for (int slave = 1; slave <= ec_slavecount; slave++) {
+        file << identityKey(slave) << "\n";
+    }
+}
+
 bool EtherCATManager::setState(uint16 state) {
-    ec_slave[0].state = state;
-    ec_writestate(0);
-    return waitForState(0, state);
+    std::vector<int> slaves;
+    for (int i = 1; i <= ec_slavecount; i++) {
+        slaves.push_back(i);
+    }
+    return transitionSlaves(slaves, state);
 }
 
-bool EtherCATManager::waitForState(int slave, uint16 state, int timeout) {
-    int retries = timeout;
-    while (retries--) {
+bool EtherCATManager::transitionSlaves(const std::vector<int>& slaves, uint16 state, int timeoutUs) {
+    // Slaves already signalling an error get the request with an error acknowledge
+    ec_readstate();
+    std::vector<bool> hadError(slaves.size(), false);
+    bool anyError = false;
+    for (size_t i = 0; i < slaves.size(); i++) {
+        hadError[i] = (ec_slave[slaves[i]].state & EC_STATE_ERROR) != 0;
+        anyError = anyError || hadError[i];
+    }
+
+    // Request the state for all slaves at once, a broadcast if the whole line is addressed
+    if (slaves.size() == (size_t)ec_slavecount) {
+        ec_slave[0].state = state | (anyError ? EC_STATE_ACK : 0);
+        ec_writestate(0);
+    } else {
+        for (size_t i = 0; i < slaves.size(); i++) {
+            ec_slave[slaves[i]].state = state | (hadError[i] ? EC_STATE_ACK : 0);
+            ec_writestate(slaves[i]);
+        }
+    }
+
+    return waitForStates(slaves, state, hadError, timeoutUs);
+}
+
+bool EtherCATManager::waitForStates(const std::vector<int>& slaves, uint16 state,
+                                    const std::vector<bool>& hadError, int timeoutUs) {
+    BringupProfiler& profiler = BringupProfiler::getInstance();
+    BringupProfiler::Scope span("state wait " + std::to_string(state), "state");
+    int64_t startUs = profiler.nowUs();
+
+    std::vector<bool> reached(slaves.size(), false);
+    size_t pending = slaves.size();
+    int pollUs = STATE_POLL_MIN_US;
+
+    while (true) {
         ec_readstate();
-        if (ec_slave[slave].state == state) {
+        int64_t elapsedUs = profiler.nowUs() - startUs;
+
+        for (size_t i = 0; i < slaves.size(); i++) {
+            if (reached[i]) continue;
+            int slave = slaves[i];
+            uint16 current = ec_slave[slave].state;
+
+            if ((current & 0x0F) == state && !(current & EC_STATE_ERROR)) {
+                reached[i] = true;
+                pending--;
+                profiler.record("state " + std::to_string(state), "state", slave, startUs, elapsedUs);
+                printf("Slave %d reached state 0x%02x after %.2f ms (%zu pending)\n",
+                       slave, state, elapsedUs / 1000.0, pending);
+            } else if ((current & EC_STATE_ERROR) &&
+                       (!hadError[i] || elapsedUs >= STATE_ERROR_GRACE_US)) {
+                // A fresh error, or one that survived the acknowledge, fails the transition
+                printf("Slave %d failed transition to 0x%02x in state 0x%02x, AL Status: 0x%04x - %s\n",
+                       slave, state, current, ec_slave[slave].ALstatuscode,
+                       ec_ALstatuscode2string(ec_slave[slave].ALstatuscode));
+                return false;
+            }
+        }
+
+        if (pending == 0) {
             return true;
         }
-        if (ec_slave[slave].state == (EC_STATE_ERROR)) {
-            printf("Slave %d is in ERROR state, AL Status: 0x%04x - %s\n",
-                   slave, ec_slave[slave].ALstatuscode,
-                   ec_ALstatuscode2string(ec_slave[slave].ALstatuscode));
+        if (elapsedUs >= timeoutUs) {
+            for (size_t i = 0; i < slaves.size(); i++) {
+                if (!reached[i]) {
+                    printf("Slave %d timed out in state 0x%02x waiting for 0x%02x\n",
+                           slaves[i], ec_slave[slaves[i]].state, state);
+                }
+            }
             return false;
         }
-        osal_usleep(100000); // 100ms
+
+        // Exponential backoff, fast slaves are seen within tens of microseconds
+        osal_usleep(pollUs);
+        pollUs = (pollUs * 2 < STATE_POLL_MAX_US) ? pollUs * 2 : STATE_POLL_MAX_US;
     }
-    return false;
 }
 
 bool EtherCATManager::DCinfo()
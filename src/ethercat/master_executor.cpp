@@ -0,0 +1,279 @@
+#include "master_executor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+void MasterExecutor::attach(int budget) {
+    owner = std::this_thread::get_id();
+    budgetUs = budget;
+    attached.store(true);
+    printf("Master executor attached, %d us per cycle for acyclic jobs\n", budgetUs);
+}
+
+void MasterExecutor::detach() {
+    {
+        std::lock_guard<std::mutex> lock(incomingMutex);
+        attached.store(false);
+        while (!incoming.empty()) {
+            active.push_back(std::move(incoming.front()));
+            incoming.pop_front();
+        }
+    }
+    for (auto& entry : active) {
+        printf("Master executor: job '%s' dropped\n", entry->name);
+        finish(*entry, false);
+    }
+    active.clear();
+
+    Stats stats = getStats();
+    printf("Master executor detached: %llu jobs (%llu failed), %llu slices, %llu over budget, longest slice %d us\n",
+           (unsigned long long)stats.jobs, (unsigned long long)stats.failed,
+           (unsigned long long)stats.slices, (unsigned long long)stats.overruns, stats.maxSliceUs);
+}
+
+bool MasterExecutor::onOwnerThread() const {
+    return std::this_thread::get_id() == owner;
+}
+
+void MasterExecutor::finish(Entry& entry, bool ok) {
+    if (entry.locked) {
+        unlockMailbox(entry.slave);
+        entry.locked = false;
+    }
+    entry.result.set_value(ok);
+}
+
+bool MasterExecutor::tryLockMailbox(uint16 slave) {
+    if (slave != ALL_SLAVES) {
+        bool busy = false;
+        return mailboxBusy[slave].compare_exchange_strong(busy, true, std::memory_order_acquire);
+    }
+    // In slave order, a partial grab is handed back
+    int count = std::min(ec_slavecount, EC_MAXSLAVE - 1);
+    for (int each = 1; each <= count; each++) {
+        if (!tryLockMailbox((uint16)each)) {
+            while (--each >= 1) {
+                unlockMailbox((uint16)each);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MasterExecutor::lockMailbox(uint16 slave, int timeoutMs) {
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!tryLockMailbox(slave)) {
+        if (Clock::now() > deadline) {
+            return false;
+        }
+        osal_usleep(100);
+    }
+    return true;
+}
+
+void MasterExecutor::unlockMailbox(uint16 slave) {
+    if (slave != ALL_SLAVES) {
+        mailboxBusy[slave].store(false, std::memory_order_release);
+        return;
+    }
+    int count = std::min(ec_slavecount, EC_MAXSLAVE - 1);
+    for (int each = 1; each <= count; each++) {
+        mailboxBusy[each].store(false, std::memory_order_release);
+    }
+}
+
+std::future<bool> MasterExecutor::post(const char* name, uint16 slave, Job job, int timeoutMs) {
+    std::unique_ptr<Entry> entry(new Entry{name, slave, std::move(job), std::promise<bool>(),
+                                           Clock::now() + std::chrono::milliseconds(timeoutMs), false});
+    std::future<bool> result = entry->result.get_future();
+    {
+        std::lock_guard<std::mutex> lock(incomingMutex);
+        if (attached.load() && !onOwnerThread()) {
+            incoming.push_back(std::move(entry));
+            return result;
+        }
+    }
+
+    // No cyclic owner, step the job right here
+    entry->locked = lockMailbox(slave, timeoutMs);
+    Step step = entry->locked ? Step::Pending : Step::Failed;
+    while (step == Step::Pending) {
+        step = Clock::now() > entry->deadline ? Step::Failed : entry->job();
+        if (step == Step::Pending) {
+            osal_usleep(100);
+        }
+    }
+    finish(*entry, step == Step::Done);
+    return result;
+}
+
+bool MasterExecutor::wait(std::future<bool>& result, int timeoutMs) {
+    // Margin over the job deadline, the RT thread fails late jobs itself
+    if (result.wait_for(std::chrono::milliseconds(timeoutMs + 1000)) != std::future_status::ready) {
+        printf("Master executor: no result within %d ms\n", timeoutMs + 1000);
+        return false;
+    }
+    return result.get();
+}
+
+bool MasterExecutor::call(const char* name, uint16 slave, std::function<bool()> work) {
+    // Mailbox and recovery calls wait for the slave, the cycle must not
+    if (attached.load() && onOwnerThread()) {
+        printf("Master executor: '%s' blocks, not run on the RT thread\n", name);
+        return false;
+    }
+    // A queued job may be between its request and its reply on this mailbox
+    bool ok = lockMailbox(slave, DEFAULT_TIMEOUT_MS);
+    if (!ok) {
+        printf("Master executor: '%s' gave up waiting for the mailbox of slave %d\n", name, slave);
+    } else {
+        ok = work();
+        unlockMailbox(slave);
+    }
+    if (attached.load()) {
+        jobCount++;
+        if (!ok) {
+            failedCount++;
+        }
+    }
+    return ok;
+}
+
+bool MasterExecutor::sdoWrite(uint16 slave, uint16 index, uint8 subindex, int size, const void* data) {
+    if (size > 4) {
+        // Runs on this thread, the caller's buffer outlives the transfer
+        return call("SDO write", slave, [=]() {
+            return ec_SDOwrite(slave, index, subindex, FALSE, size, (void*)data, EC_TIMEOUTRXM) > 0;
+        });
+    }
+
+    // Request goes out in one slice, the reply is picked up in a later one
+    struct Transfer {
+        uint8 data[4];
+        bool sent;
+    };
+    auto transfer = std::make_shared<Transfer>();
+    memcpy(transfer->data, data, size);
+    transfer->sent = false;
+
+    std::future<bool> result = post("SDO write", slave, [=]() {
+        if (!transfer->sent) {
+            transfer->sent = ec_SDOexp_start(slave, index, subindex, size, transfer->data) > 0;
+            return Step::Pending;
+        }
+        int rc = ec_SDOexp_poll(slave, index, subindex, nullptr, nullptr);
+        return rc > 0 ? Step::Done : (rc < 0 ? Step::Failed : Step::Pending);
+    }, EC_TIMEOUTRXM / 1000);
+    return wait(result, EC_TIMEOUTRXM / 1000);
+}
+
+bool MasterExecutor::sdoRead(uint16 slave, uint16 index, uint8 subindex, int* size, void* data) {
+    if (*size > 4) {
+        // Copied out only on success, a failed read leaves the caller's buffer alone
+        std::vector<uint8> buffer(*size);
+        int read = *size;
+        bool ok = call("SDO read", slave, [slave, index, subindex, &buffer, &read]() {
+            return ec_SDOread(slave, index, subindex, FALSE, &read, buffer.data(), EC_TIMEOUTRXM) > 0;
+        });
+        if (!ok) {
+            return false;
+        }
+        memcpy(data, buffer.data(), read);
+        *size = read;
+        return true;
+    }
+
+    // The job owns its buffer, a caller that gave up never sees a late write
+    struct Transfer {
+        uint8 data[4];
+        int size;
+        bool sent;
+    };
+    auto transfer = std::make_shared<Transfer>();
+    transfer->size = *size;
+    transfer->sent = false;
+
+    std::future<bool> result = post("SDO read", slave, [=]() {
+        if (!transfer->sent) {
+            transfer->sent = ec_SDOexp_start(slave, index, subindex, 0, nullptr) > 0;
+            return Step::Pending;
+        }
+        int rc = ec_SDOexp_poll(slave, index, subindex, &transfer->size, transfer->data);
+        return rc > 0 ? Step::Done : (rc < 0 ? Step::Failed : Step::Pending);
+    }, EC_TIMEOUTRXM / 1000);
+    if (!wait(result, EC_TIMEOUTRXM / 1000)) {
+        return false;
+    }
+    memcpy(data, transfer->data, transfer->size);
+    *size = transfer->size;
+    return true;
+}
+
+void MasterExecutor::runSlack() {
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::microseconds(budgetUs);
+
+    {
+        // Never wait for a producer, its jobs are picked up next cycle
+        std::unique_lock<std::mutex> lock(incomingMutex, std::try_to_lock);
+        if (lock.owns_lock()) {
+            while (!incoming.empty()) {
+                active.push_back(std::move(incoming.front()));
+                incoming.pop_front();
+            }
+        }
+    }
+
+    // Strict FIFO: one mailbox conversation at a time, a pending job holds the line
+    while (!active.empty()) {
+        Clock::time_point sliceStart = Clock::now();
+        if (sliceStart >= end) {
+            break;
+        }
+        Entry& entry = *active.front();
+        Step step;
+        if (sliceStart > entry.deadline) {
+            step = Step::Failed;
+        } else if (!entry.locked && !(entry.locked = tryLockMailbox(entry.slave))) {
+            step = Step::Pending;  // a blocking call is talking to the slave
+        } else {
+            step = entry.job();
+        }
+
+        Clock::time_point sliceEnd = Clock::now();
+        int sliceUs = (int)std::chrono::duration_cast<std::chrono::microseconds>(sliceEnd - sliceStart).count();
+        sliceCount++;
+        if (sliceEnd > end) {
+            overrunCount++;
+        }
+        if (sliceUs > maxSliceUs.load()) {
+            maxSliceUs.store(sliceUs);
+        }
+
+        if (step == Step::Pending) {
+            break;
+        }
+        jobCount++;
+        if (step == Step::Failed) {
+            failedCount++;
+            printf("Master executor: job '%s' failed\n", entry.name);
+        }
+        finish(entry, step == Step::Done);
+        active.pop_front();
+    }
+}
+
+MasterExecutor::Stats MasterExecutor::getStats() const {
+    Stats stats;
+    stats.jobs = jobCount.load();
+    stats.failed = failedCount.load();
+    stats.slices = sliceCount.load();
+    stats.overruns = overrunCount.load();
+    stats.maxSliceUs = maxSliceUs.load();
+    return stats;
+}
@@ -0,0 +1,81 @@
+#include "mode_change.h"
+
+void ModeChange::resize(const std::vector<int>& slaves) {
+    axes.clear();
+    for (int slave : slaves) {
+        axes.push_back({slave, 0, false, 0});
+    }
+}
+
+bool ModeChange::begin(uint8_t mode, int timeoutMs) {
+    uint32_t current = word.load(std::memory_order_acquire);
+    if ((current & STATUS_MASK) == PENDING) {
+        return false;
+    }
+    // Published by the release CAS below, the RT thread reads them after its acquire load
+    requested.store(mode, std::memory_order_relaxed);
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    deadline.store(now + (int64_t)timeoutMs * 1000000, std::memory_order_relaxed);
+    uint32_t next = ((current & ~STATUS_MASK) + (STATUS_MASK + 1)) | PENDING;
+    return word.compare_exchange_strong(current, next, std::memory_order_acq_rel);
+}
+
+void ModeChange::cancel() {
+    abort(CANCELLED);
+}
+
+void ModeChange::fail() {
+    abort(FAILED);
+}
+
+void ModeChange::abort(Status outcome) {
+    uint32_t current = word.load(std::memory_order_acquire);
+    while ((current & STATUS_MASK) == PENDING &&
+           !word.compare_exchange_weak(current, (current & ~STATUS_MASK) | outcome, std::memory_order_acq_rel)) {
+    }
+}
+
+bool ModeChange::finish(uint32_t current, Status outcome) {
+    // Fails if the UI cancelled or began another transaction in the meantime
+    return word.compare_exchange_strong(current, (current & ~STATUS_MASK) | outcome, std::memory_order_acq_rel);
+}
+
+ModeChange::Status ModeChange::step(const int32_t* modeDisplay) {
+    uint32_t current = word.load(std::memory_order_acquire);
+    if ((current & STATUS_MASK) != PENDING) {
+        return IDLE;
+    }
+    if (current != active) {
+        // First cycle of a new transaction
+        active = current;
+        elapsed = 0;
+        for (AxisResult& axis : axes) {
+            axis.confirmed = false;
+            axis.cycles = 0;
+        }
+    }
+    elapsed++;
+
+    if (modeDisplay) {
+        int8_t mode = (int8_t)requested.load(std::memory_order_relaxed);
+        int confirmed = 0;
+        for (int axis = 0; axis < (int)axes.size(); axis++) {
+            AxisResult& result = axes[axis];
+            result.display = (int8_t)modeDisplay[axis];
+            if (!result.confirmed && result.display == mode) {
+                result.confirmed = true;
+                result.cycles = elapsed;
+            }
+            confirmed += result.confirmed;
+        }
+        if (!axes.empty() && confirmed == (int)axes.size()) {
+            return finish(current, COMPLETE) ? COMPLETE : IDLE;
+        }
+    }
+
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    if (now < deadline.load(std::memory_order_relaxed)) {
+        return IDLE;
+    }
+    return finish(current, TIMED_OUT) ? TIMED_OUT : IDLE;
+}
@@ -0,0 +1,201 @@
+#include "pdo_layout.h"
+#include "pdo_descriptor.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+std::map<std::string, PdoLayout> PdoLayouts::layouts;
+std::map<int, std::string> PdoLayouts::byPosition;
+std::map<uint64_t, std::string> PdoLayouts::byIdentity;
+std::string PdoLayouts::defaultName = "full";
+
+// Drive profiles, generated from the descriptors in pdo_descriptor.h
+template <typename Rx, typename Tx>
+static PdoLayout driveLayout(const char* name) {
+    return {name, Rx::index, Rx::mapping(), Tx::index, Tx::mapping()};
+}
+
+static const PdoLayout BUILTIN_LAYOUTS[] = {
+    driveLayout<cia402::RxFull, cia402::TxFull>("full"),
+    driveLayout<cia402::RxCsp, cia402::TxCsp>("csp"),
+    driveLayout<cia402::RxCsv, cia402::TxCsv>("csv"),
+    driveLayout<cia402::RxCst, cia402::TxCst>("cst"),
+    // IO couplers and drives with a fixed mapping
+    {"device", 0, {}, 0, {}},
+};
+
+static uint32_t parseNumber(const std::string& text, bool& ok) {
+    char* end = nullptr;
+    unsigned long value = strtoul(text.c_str(), &end, 0);
+    ok = !text.empty() && *end == '\0';
+    return (uint32_t)value;
+}
+
+bool PdoLayouts::parseLayout(std::istream& fields, PdoLayout& layout) {
+    std::vector<uint32_t>* entries = nullptr;
+    bool expectPdo = false;
+    std::string word;
+    while (fields >> word) {
+        if (word == "rx" || word == "tx") {
+            entries = (word == "rx") ? &layout.rx : &layout.tx;
+            expectPdo = true;
+            continue;
+        }
+        bool ok;
+        uint32_t value = parseNumber(word, ok);
+        if (!ok || !entries) {
+            return false;
+        }
+        if (expectPdo) {
+            (entries == &layout.rx ? layout.rxPdo : layout.txPdo) = (uint16_t)value;
+            expectPdo = false;
+        } else {
+            entries->push_back(value);
+        }
+    }
+    // A PDO object holds at most 254 entries, 0x1C12/0x1C13 need a PDO index for every direction used
+    return layout.rx.size() < 255 && layout.tx.size() < 255 &&
+           (layout.rx.empty() || layout.rxPdo) && (layout.tx.empty() || layout.txPdo);
+}
+
+bool PdoLayouts::load(const std::string& path) {
+    layouts.clear();
+    byPosition.clear();
+    byIdentity.clear();
+    for (const PdoLayout& layout : BUILTIN_LAYOUTS) {
+        layouts[layout.name] = layout;
+    }
+
+    std::ifstream file(path);
+    std::string line;
+    int lineNumber = 0;
+    bool valid = true;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string kind;
+        if (!(fields >> kind) || kind[0] == '#') {
+            continue;
+        }
+
+        bool ok = false;
+        if (kind == "layout") {
+            PdoLayout layout;
+            ok = (fields >> layout.name) && parseLayout(fields, layout);
+            if (ok) {
+                layouts[layout.name] = layout;
+            }
+        } else if (kind == "slave") {
+            std::string position, name;
+            if (fields >> position >> name) {
+                int slave = (int)parseNumber(position, ok);
+                if (ok) {
+                    byPosition[slave] = name;
+                }
+            }
+        } else if (kind == "id") {
+            std::string vendor, product, name;
+            if (fields >> vendor >> product >> name) {
+                bool vendorOk, productOk;
+                uint64_t key = (uint64_t)parseNumber(vendor, vendorOk) << 32 | parseNumber(product, productOk);
+                ok = vendorOk && productOk;
+                if (ok) {
+                    byIdentity[key] = name;
+                }
+            }
+        }
+        if (!ok) {
+            printf("%s:%d: cannot parse '%s'\n", path.c_str(), lineNumber, line.c_str());
+            valid = false;
+        }
+    }
+
+    // Rules naming an unknown layout would leave slaves without a mapping
+    for (const auto& rule : byPosition) {
+        if (!find(rule.second)) {
+            printf("%s: slave %d uses unknown layout '%s'\n", path.c_str(), rule.first, rule.second.c_str());
+            valid = false;
+        }
+    }
+    for (const auto& rule : byIdentity) {
+        if (!find(rule.second)) {
+            printf("%s: id %08X:%08X uses unknown layout '%s'\n", path.c_str(),
+                   (uint32_t)(rule.first >> 32), (uint32_t)rule.first, rule.second.c_str());
+            valid = false;
+        }
+    }
+    if (!find(defaultName)) {
+        printf("Unknown default PDO layout '%s', using full\n", defaultName.c_str());
+        defaultName = "full";
+    }
+
+    printf("PDO layouts: %zu known, %zu position and %zu identity rules, default %s\n",
+           layouts.size(), byPosition.size(), byIdentity.size(), defaultName.c_str());
+    return valid;
+}
+
+const PdoLayout* PdoLayouts::find(const std::string& name) {
+    auto it = layouts.find(name);
+    return it != layouts.end() ? &it->second : nullptr;
+}
+
+bool PdoLayouts::setDefault(const std::string& name) {
+    if (layouts.empty()) {
+        load();
+    }
+    if (!find(name)) {
+        return false;
+    }
+    defaultName = name;
+    return true;
+}
+
+const PdoLayout& PdoLayouts::getDefault() {
+    if (layouts.empty()) {
+        load();
+    }
+    return layouts[defaultName];
+}
+
+const PdoLayout& PdoLayouts::select(ecx_contextt* context, int slave) {
+    const ec_slavet& info = context->slavelist[slave];
+    const PdoLayout* layout = nullptr;
+
+    auto position = byPosition.find(slave);
+    auto identity = byIdentity.find((uint64_t)info.eep_man << 32 | info.eep_id);
+    if (position != byPosition.end()) {
+        layout = find(position->second);
+    } else if (identity != byIdentity.end()) {
+        layout = find(identity->second);
+    } else if (!(info.mbx_proto & ECT_MBXPROT_COE)) {
+        layout = find("device");
+    }
+    return layout ? *layout : getDefault();
+}
+
+PdoOffset PdoLayouts::locate(const std::vector<uint32_t>& entries, uint16_t index, uint8_t subindex,
+                             uint8_t startBit) {
+    PdoOffset offset;
+    int position = startBit;
+    for (uint32_t entry : entries) {
+        uint8_t bits = entry & 0xFF;
+        if ((entry >> 16) == index && ((entry >> 8) & 0xFF) == subindex) {
+            offset.byte = position / 8;
+            offset.bit = position % 8;
+            offset.bits = bits;
+            break;
+        }
+        position += bits;
+    }
+    return offset;
+}
+
+int PdoLayouts::bytes(const std::vector<uint32_t>& entries) {
+    int bits = 0;
+    for (uint32_t entry : entries) {
+        bits += entry & 0xFF;
+    }
+    return (bits + 7) / 8;
+}
@@ -1,10 +1,29 @@
 #include "pdo_manager.h"
+#include "bringup_profiler.h"
+#include "pdo_descriptor.h"
+#include "task_groups.h"
 
+#include <atomic>
+#include <cstddef>
+#include <chrono>
 #include <cstdio>
+#include <climits>
 #include <cstring>  // Header for memcpy
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
-// Only define static IOmap
-char PDOManager::IOmap[4096];
+// Process image of the default line
+ProcessImage PDOManager::defaultImage;
+
+// PDO mapping cache state
+std::map<std::string, PDOManager::MappingCacheEntry> PDOManager::mappingCache;
+std::mutex PDOManager::cacheMutex;
+std::string PDOManager::cacheDirectory;
+std::mutex PDOManager::caMutex;
+std::map<const ecx_contextt*, std::vector<uint8_t>> PDOManager::caRejectedByLine;
 
 PDOManager::PDOManager() {
     // Initialize member variables
@@ -12,54 +31,617 @@ PDOManager::PDOManager() {
     memset(&txpdo, 0, sizeof(TxPDO));
 }
 
-bool PDOManager::configureRxPDO(int slave) {
+// The application structs mirror the full drive PDOs byte for byte, so the
+// descriptor offsets double as struct offsets for the copy tables
+using cia402::RxFull;
+using cia402::TxFull;
+static_assert(sizeof(PDOManager::RxPDO) == RxFull::size, "RxPDO does not match the full RxPDO");
+static_assert(sizeof(PDOManager::TxPDO) == TxFull::size, "TxPDO does not match the full TxPDO");
+static_assert(offsetof(PDOManager::RxPDO, controlword) == RxFull::offset<cia402::Controlword>() &&
+              offsetof(PDOManager::RxPDO, target_position) == RxFull::offset<cia402::TargetPosition>() &&
+              offsetof(PDOManager::RxPDO, target_velocity) == RxFull::offset<cia402::TargetVelocity>() &&
+              offsetof(PDOManager::RxPDO, target_torque) == RxFull::offset<cia402::TargetTorque>() &&
+              offsetof(PDOManager::RxPDO, mode_of_operation) == RxFull::offset<cia402::ModeOfOperation>(),
+              "RxPDO field order differs from the full RxPDO");
+static_assert(offsetof(PDOManager::TxPDO, statusword) == TxFull::offset<cia402::Statusword>() &&
+              offsetof(PDOManager::TxPDO, actual_position) == TxFull::offset<cia402::ActualPosition>() &&
+              offsetof(PDOManager::TxPDO, actual_velocity) == TxFull::offset<cia402::ActualVelocity>() &&
+              offsetof(PDOManager::TxPDO, actual_torque) == TxFull::offset<cia402::ActualTorque>() &&
+              offsetof(PDOManager::TxPDO, mode_of_operation_display) ==
+                  TxFull::offset<cia402::ModeOfOperationDisplay>(),
+              "TxPDO field order differs from the full TxPDO");
+
+std::vector<PDOManager::SlaveMapping> PDOManager::defaultMappings;
+std::mutex PDOManager::mappingMutex;
+std::map<const ecx_contextt*, std::vector<PDOManager::SlaveMapping>> PDOManager::mappingsByLine;
+
+// One copy per struct field the slave maps whole and byte aligned, bit packed
+// or resized objects are left to PdoOffset access
+template <size_t N>
+static void buildCopyOps(const std::vector<uint32_t>& entries, uint8_t startBit, const PdoField (&fields)[N],
+                         std::vector<PDOManager::CopyOp>& ops) {
+    ops.clear();
+    for (size_t f = 0; f < N; f++) {
+        if (!fields[f].index) {
+            continue;  // padding
+        }
+        PdoOffset at = PdoLayouts::locate(entries, fields[f].index, fields[f].subindex, startBit);
+        if (at.valid() && at.bit == 0 && at.bits == fields[f].size * 8) {
+            ops.push_back({fields[f].offset, (uint16_t)at.byte, fields[f].size});
+        }
+    }
+}
+
+// Fixed sizes so each field compiles to a single load and store
+static inline void copyField(uint8_t* to, const uint8_t* from, uint8_t size) {
+    switch (size) {
+        case 1: *to = *from; break;
+        case 2: memcpy(to, from, 2); break;
+        case 4: memcpy(to, from, 4); break;
+        default: memcpy(to, from, size); break;
+    }
+}
+
+std::vector<PDOManager::SlaveMapping>& PDOManager::lineMappings(ecx_contextt* context) {
+    if (context == &ecx_context) {
+        return defaultMappings;
+    }
+    std::lock_guard<std::mutex> lock(mappingMutex);
+    return mappingsByLine[context];
+}
+
+const std::vector<PDOManager::SlaveMapping>& PDOManager::mappings(ecx_contextt* context) {
+    return lineMappings(context);
+}
+
+// Sized before the mapping workers start, they only touch their own slave's entry
+void PDOManager::prepareMappings(ecx_contextt* context) {
+    std::vector<SlaveMapping>& table = lineMappings(context);
+    table.clear();
+    table.resize(*context->slavecount + 1);
+}
+
+void PDOManager::resolveMappings(ecx_contextt* context) {
+    std::vector<SlaveMapping>& table = lineMappings(context);
+    for (int slave = 1; slave < (int)table.size(); slave++) {
+        SlaveMapping& mapping = table[slave];
+        const ec_slavet& info = context->slavelist[slave];
+        mapping.rxStartBit = info.Ostartbit;
+        mapping.txStartBit = info.Istartbit;
+        mapping.rxBytes = PdoLayouts::bytes(mapping.rx);
+        mapping.txBytes = PdoLayouts::bytes(mapping.tx);
+        mapping.rxFull = mapping.rxStartBit == 0 && mapping.rx == RxFull::mapping();
+        mapping.txFull = mapping.txStartBit == 0 && mapping.tx == TxFull::mapping();
+        if (mapping.rxFull) {
+            mapping.rxOps.clear();
+        } else {
+            buildCopyOps(mapping.rx, mapping.rxStartBit, RxFull::fields, mapping.rxOps);
+        }
+        if (mapping.txFull) {
+            mapping.txOps.clear();
+        } else {
+            buildCopyOps(mapping.tx, mapping.txStartBit, TxFull::fields, mapping.txOps);
+        }
+        printf("Slave %d: PDO layout %s, %d output + %d input bytes, drive fields %s/%s\n",
+               slave, mapping.layout ? mapping.layout->name.c_str() : "?", mapping.rxBytes, mapping.txBytes,
+               mapping.rxFull ? "full" : std::to_string(mapping.rxOps.size()).c_str(),
+               mapping.txFull ? "full" : std::to_string(mapping.txOps.size()).c_str());
+    }
+}
+
+PdoOffset PDOManager::rxOffset(ecx_contextt* context, int slave, uint16_t index, uint8_t subindex) {
+    const std::vector<SlaveMapping>& table = mappings(context);
+    if (slave <= 0 || slave >= (int)table.size()) {
+        return PdoOffset();
+    }
+    return PdoLayouts::locate(table[slave].rx, index, subindex, table[slave].rxStartBit);
+}
+
+PdoOffset PDOManager::txOffset(ecx_contextt* context, int slave, uint16_t index, uint8_t subindex) {
+    const std::vector<SlaveMapping>& table = mappings(context);
+    if (slave <= 0 || slave >= (int)table.size()) {
+        return PdoOffset();
+    }
+    return PdoLayouts::locate(table[slave].tx, index, subindex, table[slave].txStartBit);
+}
+
+bool PDOManager::supportsMode(uint8_t mode) {
+    // Setpoint objects each mode family needs in the RxPDO, other modes need all of them
+    std::vector<uint16_t> setpoints;
+    switch (mode) {
+        case 1: case 8: setpoints = {cia402::TargetPosition::index}; break;   // PP, CSP
+        case 3: case 9: setpoints = {cia402::TargetVelocity::index}; break;   // PV, CSV
+        case 4: case 10: setpoints = {cia402::TargetTorque::index}; break;    // PT, CST
+        default:
+            setpoints = {cia402::TargetPosition::index, cia402::TargetVelocity::index,
+                         cia402::TargetTorque::index};
+            break;
+    }
+
+    // Drives are the slaves with a controlword, before mapping they get the default layout
+    std::vector<const std::vector<uint32_t>*> drives;
+    for (const SlaveMapping& mapping : defaultMappings) {
+        if (PdoLayouts::locate(mapping.rx, cia402::Controlword::index, 0).valid()) {
+            drives.push_back(&mapping.rx);
+        }
+    }
+    if (drives.empty()) {
+        drives.push_back(&PdoLayouts::getDefault().rx);
+    }
+    for (const std::vector<uint32_t>* rx : drives) {
+        for (uint16_t setpoint : setpoints) {
+            if (!PdoLayouts::locate(*rx, setpoint, 0).valid()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void PDOManager::packRx(const SlaveMapping& mapping, const RxPDO& rx, ec_slavet& slave) {
+    // A slave that came up with less process data than its layout is left alone
+    if (slave.Obytes < (uint32)mapping.rxBytes) {
+        return;
+    }
+    if (mapping.rxFull) {
+        // Constant offsets, each field is a single store
+        uint8_t* out = slave.outputs;
+        RxFull::set<cia402::Controlword>(out, rx.controlword);
+        RxFull::set<cia402::TargetPosition>(out, rx.target_position);
+        RxFull::set<cia402::TargetVelocity>(out, rx.target_velocity);
+        RxFull::set<cia402::TargetTorque>(out, rx.target_torque);
+        RxFull::set<cia402::ModeOfOperation>(out, rx.mode_of_operation);
+        return;
+    }
+    const uint8_t* from = (const uint8_t*)&rx;
+    for (const CopyOp& op : mapping.rxOps) {
+        copyField(slave.outputs + op.pdoOffset, from + op.structOffset, op.size);
+    }
+}
+
+void PDOManager::unpackTx(const SlaveMapping& mapping, const ec_slavet& slave, TxPDO& tx) {
+    if (slave.Ibytes < (uint32)mapping.txBytes) {
+        return;
+    }
+    if (mapping.txFull) {
+        const uint8_t* in = slave.inputs;
+        tx.statusword = TxFull::get<cia402::Statusword>(in);
+        tx.actual_position = TxFull::get<cia402::ActualPosition>(in);
+        tx.actual_velocity = TxFull::get<cia402::ActualVelocity>(in);
+        tx.actual_torque = TxFull::get<cia402::ActualTorque>(in);
+        tx.mode_of_operation_display = TxFull::get<cia402::ModeOfOperationDisplay>(in);
+        return;
+    }
+    uint8_t* to = (uint8_t*)&tx;
+    for (const CopyOp& op : mapping.txOps) {
+        copyField(to + op.structOffset, slave.inputs + op.pdoOffset, op.size);
+    }
+}
+
+void PDOManager::packRx(const RxPDO& rx, int slave) {
+    if (slave < (int)defaultMappings.size()) {
+        packRx(defaultMappings[slave], rx, ec_slave[slave]);
+    }
+}
+
+void PDOManager::unpackTx(int slave, TxPDO& tx) {
+    if (slave < (int)defaultMappings.size()) {
+        unpackTx(defaultMappings[slave], ec_slave[slave], tx);
+    }
+}
+
+// Per line, mapping workers of one line write the flags of different slaves
+uint8_t& PDOManager::caRejected(ecx_contextt* context, int slave) {
+    std::lock_guard<std::mutex> lock(caMutex);
+    std::vector<uint8_t>& flags = caRejectedByLine[context];
+    // The slave list is sized at scan time and does not change during a bring-up
+    if (flags.size() < (size_t)context->maxslave) {
+        flags.resize(context->maxslave, 0);
+    }
+    return flags[slave];
+}
+
+bool PDOManager::supportsCompleteAccess(ecx_contextt* context, int slave) {
+    return !caRejected(context, slave) &&
+           (context->slavelist[slave].mbx_proto & ECT_MBXPROT_COE) &&
+           (context->slavelist[slave].CoEdetails & ECT_COEDET_SDOCA);
+}
+
+bool PDOManager::writeMappingObject(ecx_contextt* context, int slave, uint16_t pdoIndex, const uint32_t* entries, uint8_t count) {
+    BringupProfiler::Scope span("SDO write mapping", "sdo", slave);
+
+    // Upload the whole mapping object (count + entries) in one Complete Access transaction
+    if (supportsCompleteAccess(context, slave)) {
+        ec_PDOdesct mapping;
+        mapping.n = count;
+        mapping.nu1 = 0;
+        for (int i = 0; i < count; i++) {
+            mapping.PDO[i] = htoel(entries[i]);
+        }
+        int size = 2 + count * sizeof(uint32_t);
+        if (ecx_SDOwrite(context, slave, pdoIndex, 0x00, TRUE, size, &mapping, EC_TIMEOUTSAFE) > 0) {
+            return true;
+        }
+        printf("Slave %d rejected CA write of 0x%04X, falling back to single subindex writes\n",
+               slave, pdoIndex);
+        caRejected(context, slave) = true;
+    }
+
+    // Fallback: clear count, write entries one by one, then set count
+    uint8_t zero = 0;
+    if (ecx_SDOwrite(context, slave, pdoIndex, 0x00, FALSE, sizeof(zero), &zero, EC_TIMEOUTSAFE) <= 0) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        uint32_t entry = htoel(entries[i]);
+        if (ecx_SDOwrite(context, slave, pdoIndex, i + 1, FALSE, sizeof(entry), &entry, EC_TIMEOUTSAFE) <= 0) {
+            return false;
+        }
+    }
+    return ecx_SDOwrite(context, slave, pdoIndex, 0x00, FALSE, sizeof(count), &count, EC_TIMEOUTSAFE) > 0;
+}
+
+bool PDOManager::writeAssignObject(ecx_contextt* context, int slave, uint16_t assignIndex, uint16_t pdoIndex) {
+    BringupProfiler::Scope span("SDO write assign", "sdo", slave);
+
+    // Assign a single PDO to the sync manager in one Complete Access transaction
+    if (supportsCompleteAccess(context, slave)) {
+        ec_PDOassignt assign;
+        assign.n = 1;
+        assign.nu1 = 0;
+        assign.index[0] = htoes(pdoIndex);
+        int size = 2 + sizeof(uint16_t);
+        if (ecx_SDOwrite(context, slave, assignIndex, 0x00, TRUE, size, &assign, EC_TIMEOUTSAFE) > 0) {
+            return true;
+        }
+        printf("Slave %d rejected CA write of 0x%04X, falling back to single subindex writes\n",
+               slave, assignIndex);
+        caRejected(context, slave) = true;
+    }
+
+    // Fallback: clear count, write PDO index, then set count
+    uint8_t count = 0;
+    uint16_t index = htoes(pdoIndex);
+    if (ecx_SDOwrite(context, slave, assignIndex, 0x00, FALSE, sizeof(count), &count, EC_TIMEOUTSAFE) <= 0) {
+        return false;
+    }
+    if (ecx_SDOwrite(context, slave, assignIndex, 0x01, FALSE, sizeof(index), &index, EC_TIMEOUTSAFE) <= 0) {
+        return false;
+    }
+    count = 1;
+    return ecx_SDOwrite(context, slave, assignIndex, 0x00, FALSE, sizeof(count), &count, EC_TIMEOUTSAFE) > 0;
+}
+
+bool PDOManager::readMappingObject(ecx_contextt* context, int slave, uint16_t pdoIndex, uint32_t* entries, uint8_t& count) {
+    BringupProfiler::Scope span("SDO read mapping", "sdo", slave);
+
+    // Read the whole mapping object in one Complete Access transaction
+    if (supportsCompleteAccess(context, slave)) {
+        ec_PDOdesct mapping;
+        int size = sizeof(mapping);
+        mapping.n = 0;
+        if (ecx_SDOread(context, slave, pdoIndex, 0x00, TRUE, &size, &mapping, EC_TIMEOUTSAFE) > 0) {
+            count = mapping.n;
+            for (int i = 0; i < count; i++) {
+                entries[i] = etohl(mapping.PDO[i]);
+            }
+            return true;
+        }
+        caRejected(context, slave) = true;
+    }
+
+    // Fallback: read count, then entries one by one
+    int size = sizeof(count);
+    if (ecx_SDOread(context, slave, pdoIndex, 0x00, FALSE, &size, &count, EC_TIMEOUTSAFE) <= 0) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        uint32_t entry = 0;
+        size = sizeof(entry);
+        if (ecx_SDOread(context, slave, pdoIndex, i + 1, FALSE, &size, &entry, EC_TIMEOUTSAFE) <= 0) {
+            return false;
+        }
+        entries[i] = etohl(entry);
+    }
+    return true;
+}
+
+bool PDOManager::readAssignObject(ecx_contextt* context, int slave, uint16_t assignIndex, uint16_t* pdos, uint8_t& count) {
+    BringupProfiler::Scope span("SDO read assign", "sdo", slave);
+
+    // Read the whole assignment object in one Complete Access transaction
+    if (supportsCompleteAccess(context, slave)) {
+        ec_PDOassignt assign;
+        int size = sizeof(assign);
+        assign.n = 0;
+        if (ecx_SDOread(context, slave, assignIndex, 0x00, TRUE, &size, &assign, EC_TIMEOUTSAFE) > 0) {
+            count = assign.n;
+            for (int i = 0; i < count; i++) {
+                pdos[i] = etohs(assign.index[i]);
+            }
+            return true;
+        }
+        caRejected(context, slave) = true;
+    }
+
+    // Fallback: read count, then PDO indexes one by one
+    int size = sizeof(count);
+    if (ecx_SDOread(context, slave, assignIndex, 0x00, FALSE, &size, &count, EC_TIMEOUTSAFE) <= 0) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        uint16_t index = 0;
+        size = sizeof(index);
+        if (ecx_SDOread(context, slave, assignIndex, i + 1, FALSE, &size, &index, EC_TIMEOUTSAFE) <= 0) {
+            return false;
+        }
+        pdos[i] = etohs(index);
+    }
+    return true;
+}
+
+// Assignment and entries as the device runs them, one Complete Access read
+// per object where the device takes it
+bool PDOManager::mappingMatches(ecx_contextt* context, int slave, uint16_t assignIndex, uint16_t pdoIndex,
+                                const std::vector<uint32_t>& entries) {
+    // A direction the layout leaves alone always matches
+    if (entries.empty()) {
+        return true;
+    }
+    uint16_t pdos[256];
+    uint8_t pdoCount = 0;
+    if (!readAssignObject(context, slave, assignIndex, pdos, pdoCount) ||
+        pdoCount != 1 || pdos[0] != pdoIndex) {
+        return false;
+    }
+
+    uint32_t current[256];
+    uint8_t currentCount = 0;
+    if (!readMappingObject(context, slave, pdoIndex, current, currentCount) || currentCount != entries.size()) {
+        return false;
+    }
+    return memcmp(current, entries.data(), currentCount * sizeof(uint32_t)) == 0;
+}
+
+// Entries of every PDO the slave has assigned to a sync manager, in order.
+// Without CoE the fixed PDOs from the SII stand in for the assignment.
+bool PDOManager::readDeviceMapping(ecx_contextt* context, int slave, uint16_t assignIndex,
+                                   std::vector<uint32_t>& entries) {
+    entries.clear();
+    if (!(context->slavelist[slave].mbx_proto & ECT_MBXPROT_COE)) {
+        return readSiiMapping(context, slave, assignIndex == 0x1C12, entries);
+    }
+    uint16_t pdos[256];
+    uint8_t pdoCount = 0;
+    if (!readAssignObject(context, slave, assignIndex, pdos, pdoCount)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < pdoCount; i++) {
+        uint32_t current[256];
+        uint8_t count = 0;
+        if (!readMappingObject(context, slave, pdos[i], current, count)) {
+            entries.clear();
+            return false;
+        }
+        entries.insert(entries.end(), current, current + count);
+    }
+    return true;
+}
+
+// SII RxPDO (outputs) or TxPDO (inputs) category: per PDO an 8 byte header
+// (index, entry count, sync manager, ...) and 8 bytes per entry (index,
+// subindex, name, data type, bit length, flags). PDOs on sync manager 0xFF
+// are not assigned.
+bool PDOManager::readSiiMapping(ecx_contextt* context, int slave, bool outputs, std::vector<uint32_t>& entries) {
+    entries.clear();
+    int16 start = ecx_siifind(context, (uint16)slave, outputs ? ECT_SII_PDO + 1 : ECT_SII_PDO);
+    if (start <= 0) {
+        return false;
+    }
+    auto byte = [context, slave](uint32_t address) { return (uint32_t)ecx_siigetbyte(context, (uint16)slave, (uint16)address); };
+    auto word = [&byte](uint32_t address) { return byte(address) | byte(address + 1) << 8; };
+
+    uint32_t address = (uint32_t)start;
+    uint32_t end = address + 2 + word(address) * 2;
+    address += 2;
+    while (address + 8 <= end) {
+        uint32_t count = byte(address + 2);
+        bool assigned = byte(address + 3) != 0xFF;
+        address += 8;
+        for (uint32_t i = 0; i < count && address + 8 <= end; i++, address += 8) {
+            if (assigned) {
+                entries.push_back(word(address) << 16 | byte(address + 2) << 8 | byte(address + 5));
+            }
+        }
+    }
+    if (context->slavelist[slave].eep_pdi) {
+        ecx_eeprom2pdi(context, (uint16)slave);  // reading took the EEPROM from the PDI
+    }
+    return true;
+}
+
+// What the slave runs: the layout's entries, a direction the layout leaves
+// empty as the device has it. Shared by the cold and the warm path.
+void PDOManager::loadEntries(ecx_contextt* context, int slave, const PdoLayout& layout, SlaveMapping& mapping) {
+    mapping.layout = &layout;
+    mapping.rx = layout.rx;
+    mapping.tx = layout.tx;
+    if (layout.rx.empty()) {
+        readDeviceMapping(context, slave, 0x1C12, mapping.rx);
+    }
+    if (layout.tx.empty()) {
+        readDeviceMapping(context, slave, 0x1C13, mapping.tx);
+    }
+}
+
+PDOManager::SlaveIdentity PDOManager::readIdentity(ecx_contextt* context, int slave) {
+    BringupProfiler::Scope span("SDO read identity", "sdo", slave);
+
+    SlaveIdentity id;
+    id.vendor = context->slavelist[slave].eep_man;
+    id.product = context->slavelist[slave].eep_id;
+    id.revision = context->slavelist[slave].eep_rev;
+    id.serial = 0;
+
+    // Serial number (0x1018:4), left at 0 if the slave does not provide it
+    int size = sizeof(id.serial);
+    if (ecx_SDOread(context, slave, 0x1018, 0x04, FALSE, &size, &id.serial, EC_TIMEOUTSAFE) <= 0) {
+        id.serial = 0;
+    }
+    return id;
+}
+
+std::string PDOManager::identityKey(const SlaveIdentity& id) {
+    char key[64];
+    snprintf(key, sizeof(key), "%08X:%08X:%08X:%08X", id.vendor, id.product, id.revision, id.serial);
+    return key;
+}
+
+uint32_t PDOManager::layoutFingerprint(const PdoLayout& layout) {
+    // FNV-1a over the assignment and mapping entries of both directions
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 16777619u;
+        }
+    };
+    mix(0x1C120000 | layout.rxPdo);
+    for (uint32_t entry : layout.rx) mix(entry);
+    mix(0x1C130000 | layout.txPdo);
+    for (uint32_t entry : layout.tx) mix(entry);
+    return hash;
+}
+
+void PDOManager::setCacheDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheDirectory = directory;
+}
+
+std::string PDOManager::cacheFile(const char* name) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return resolvedCacheDirectory() + "/" + name;
+}
+
+// Caller holds cacheMutex
+std::string PDOManager::cachePath() {
+    return resolvedCacheDirectory() + "/" + MAPPING_CACHE_FILE;
+}
+
+// Caller holds cacheMutex
+const std::string& PDOManager::resolvedCacheDirectory() {
+    if (cacheDirectory.empty()) {
+        char exe[PATH_MAX];
+        ssize_t length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+        if (length > 0) {
+            exe[length] = '\0';
+            std::string path(exe);
+            cacheDirectory = path.substr(0, path.find_last_of('/'));
+        } else {
+            cacheDirectory = ".";
+        }
+    }
+    return cacheDirectory;
+}
+
+void PDOManager::loadMappingCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    mappingCache.clear();
+
+    std::ifstream file(cachePath());
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        MappingCacheEntry entry;
+        if (fields >> key >> std::hex >> entry.fingerprint >> entry.completeAccess) {
+            mappingCache[key] = entry;
+        }
+    }
+    printf("Loaded %zu PDO mapping cache entries\n", mappingCache.size());
+}
+
+void PDOManager::saveMappingCache() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    std::string path = cachePath();
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        printf("Warning: cannot write PDO mapping cache %s\n", path.c_str());
+        return;
+    }
+    for (const auto& item : mappingCache) {
+        file << item.first << " " << std::hex << item.second.fingerprint << " "
+             << item.second.completeAccess << "\n";
+    }
+}
+
+bool PDOManager::configureSlaveMapping(ecx_contextt* context, int slave) {
+    BringupProfiler::Scope span("PDO mapping", "slave", slave);
+
+    SlaveMapping& mapping = lineMappings(context)[slave];
+    const PdoLayout& layout = PdoLayouts::select(context, slave);
+    // A layout may define one direction only, the other one stays as the device has it
+    loadEntries(context, slave, layout, mapping);
+
+    // Nothing to write, the offsets come from the mapping the device runs
+    if (layout.keepsDeviceMapping()) {
+        printf("Slave %d keeps its own PDO mapping (%zu output, %zu input entries)\n",
+               slave, mapping.rx.size(), mapping.tx.size());
+        return true;
+    }
+
+    SlaveIdentity id = readIdentity(context, slave);
+    std::string key = identityKey(id);
+    uint32_t fingerprint = layoutFingerprint(layout);
+
+    MappingCacheEntry cached;
+    bool cacheHit = false;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = mappingCache.find(key);
+        if (it != mappingCache.end()) {
+            cached = it->second;
+            cacheHit = true;
+        }
+    }
+
+    // Do not retry Complete Access on a device that rejected it before
+    if (cacheHit && !cached.completeAccess) {
+        caRejected(context, slave) = true;
+    }
+
+    // This device was left with our layout last time: verify by reading back
+    // and skip the rewrite if nothing changed. Unknown devices are written directly.
+    mapping.fromCache = false;
+    if (cacheHit && cached.fingerprint == fingerprint &&
+        mappingMatches(context, slave, 0x1C12, layout.rxPdo, layout.rx) &&
+        mappingMatches(context, slave, 0x1C13, layout.txPdo, layout.tx)) {
+        printf("PDO mapping of slave %d (%s) is up to date, skipping rewrite\n", slave, key.c_str());
+        mapping.fromCache = true;
+        return true;
+    }
+
+    if (!configureRxPDO(context, slave) || !configureTxPDO(context, slave)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    MappingCacheEntry& entry = mappingCache[key];
+    entry.fingerprint = fingerprint;
+    entry.completeAccess = !caRejected(context, slave);
+    return true;
+}
+
+bool PDOManager::configureRxPDO(ecx_contextt* context, int slave) {
     printf("Configuring RxPDO for slave %d...\n", slave);
-    int retval = 0;
-    uint16_t map_1c12;
-    uint8_t zero_map = 0;
-    uint32_t map_object;
-    uint16_t clear_val = 0x0000;
-
-    // Clear existing mapping
-    retval += ec_SDOwrite(slave, 0x1600, 0x00, FALSE, sizeof(zero_map), &zero_map, EC_TIMEOUTSAFE);
-    
-    // Control word (0x6040:0, 16 bits)
-    map_object = 0x60400010;
-    retval += ec_SDOwrite(slave, 0x1600, 0x01, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-    
-    // Target position (0x607A:0, 32 bits)
-    map_object = 0x607A0020;
-    retval += ec_SDOwrite(slave, 0x1600, 0x02, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-    
-    // Target velocity (0x60FF:0, 32 bits)
-    map_object = 0x60FF0020;
-    retval += ec_SDOwrite(slave, 0x1600, 0x03, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-    
-    // Target torque (0x6071:0, 16 bits)
-    map_object = 0x60710010;
-    retval += ec_SDOwrite(slave, 0x1600, 0x04, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-
-    // Operation mode (0x6060:0, 8 bits)
-    map_object = 0x60600008;
-    retval += ec_SDOwrite(slave, 0x1600, 0x05, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-    
-    // Padding bits (8 bits padding)
-    map_object = 0x00000008;
-    retval += ec_SDOwrite(slave, 0x1600, 0x06, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-    
-    // Set number of mapping objects
-    uint8_t map_count = 6;  // Includes all objects
-    retval += ec_SDOwrite(slave, 0x1600, 0x00, FALSE, sizeof(map_count), &map_count, EC_TIMEOUTSAFE);
-    
-    // Configure RXPDO assignment
-    clear_val = 0x0000;
-    retval += ec_SDOwrite(slave, 0x1c12, 0x00, FALSE, sizeof(clear_val), &clear_val, EC_TIMEOUTSAFE);
-    map_1c12 = 0x1600;
-    retval += ec_SDOwrite(slave, 0x1c12, 0x01, FALSE, sizeof(map_1c12), &map_1c12, EC_TIMEOUTSAFE);
-    map_1c12 = 0x0001;
-    retval += ec_SDOwrite(slave, 0x1c12, 0x00, FALSE, sizeof(map_1c12), &map_1c12, EC_TIMEOUTSAFE);
-
-    if (retval < 0) {
+
+    const PdoLayout& layout = PdoLayouts::select(context, slave);
+    if (layout.rx.empty()) {
+        return true;
+    }
+    if (!writeMappingObject(context, slave, layout.rxPdo, layout.rx.data(), (uint8_t)layout.rx.size()) ||
+        !writeAssignObject(context, slave, 0x1C12, layout.rxPdo)) {
         printf("RxPDO mapping failed for slave %d\n", slave);
         return false;
     }
@@ -67,53 +649,15 @@ bool PDOManager::configureRxPDO(int slave) {
     return true;
 }
 
-bool PDOManager::configureTxPDO(int slave) {
+bool PDOManager::configureTxPDO(ecx_contextt* context, int slave) {
     printf("Configuring TxPDO for slave %d...\n", slave);
-    int retval = 0;
-    uint16_t map_1c13;
-    uint32_t map_object;
-    uint16_t clear_val = 0x0000;
-
-    // Clear existing mapping
-    retval += ec_SDOwrite(slave, 0x1A00, 0x00, FALSE, sizeof(clear_val), &clear_val, EC_TIMEOUTSAFE);
-
-    // Status word (0x6041:0, 16 bits)
-    map_object = 0x60410010;
-    retval += ec_SDOwrite(slave, 0x1A00, 0x01, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-
-    // Actual position (0x6064:0, 32 bits)
-    map_object = 0x60640020;
-    retval += ec_SDOwrite(slave, 0x1A00, 0x02, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-
-    // Actual velocity (0x606C:0, 32 bits)
-    map_object = 0x606C0020;
-    retval += ec_SDOwrite(slave, 0x1A00, 0x03, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-
-    // Actual torque (0x6077:0, 16 bits)
-    map_object = 0x60770010;
-    retval += ec_SDOwrite(slave, 0x1A00, 0x04, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-
-    // Mode display (0x6061:0, 8 bits)
-    map_object = 0x60610008;
-    retval += ec_SDOwrite(slave, 0x1A00, 0x05, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-
-    // Padding (8 bits padding)
-    map_object = 0x00000008;
-    retval += ec_SDOwrite(slave, 0x1A00, 0x06, FALSE, sizeof(map_object), &map_object, EC_TIMEOUTSAFE);
-
-    // Set number of mapping objects
-    uint8_t map_count = 6;  // Updated to 6 objects (including padding)
-    retval += ec_SDOwrite(slave, 0x1A00, 0x00, FALSE, sizeof(map_count), &map_count, EC_TIMEOUTSAFE);
-
-    // Configure TXPDO assignment
-    clear_val = 0x0000;
-    retval += ec_SDOwrite(slave, 0x1C13, 0x00, FALSE, sizeof(clear_val), &clear_val, EC_TIMEOUTSAFE);
-    map_1c13 = 0x1A00;
-    retval += ec_SDOwrite(slave, 0x1C13, 0x01, FALSE, sizeof(map_1c13), &map_1c13, EC_TIMEOUTSAFE);
-    map_1c13 = 0x0001;
-    retval += ec_SDOwrite(slave, 0x1C13, 0x00, FALSE, sizeof(map_1c13), &map_1c13, EC_TIMEOUTSAFE);
-
-    if (retval < 0) {
+
+    const PdoLayout& layout = PdoLayouts::select(context, slave);
+    if (layout.tx.empty()) {
+        return true;
+    }
+    if (!writeMappingObject(context, slave, layout.txPdo, layout.tx.data(), (uint8_t)layout.tx.size()) ||
+        !writeAssignObject(context, slave, 0x1C13, layout.txPdo)) {
         printf("TxPDO mapping failed for slave %d\n", slave);
         return false;
     }
@@ -122,26 +666,184 @@ bool PDOManager::configureTxPDO(int slave) {
 }
 
 bool PDOManager::configureMapping() {
+    return configureMapping(&ecx_context, defaultImage);
+}
+
+bool PDOManager::configureMapping(ecx_contextt* context, ProcessImage& image) {
     printf("Configuring PDO mapping...\n");
-    
-    // Configure PDO for each slave
-    for(int i = 1; i <= ec_slavecount; i++) {
-        if (!PDOManager::configureRxPDO(i)) {
-            return false;
-        }
-        if (!PDOManager::configureTxPDO(i)) {
+    prepareMappings(context);
+    auto start = std::chrono::steady_clock::now();
+
+    // Configure PDO for all slaves concurrently. Each worker owns a whole slave, so the
+    // RxPDO/TxPDO SDO sequence of one slave keeps its order while the mailbox
+    // transactions of different slaves are interleaved on the wire.
+    loadMappingCache();
+
+    std::atomic<int> nextSlave(1);
+    std::atomic<bool> success(true);
+    int workerCount = (*context->slavecount < MAPPING_WORKERS) ? *context->slavecount : MAPPING_WORKERS;
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < workerCount; w++) {
+        workers.emplace_back([context, &nextSlave, &success]() {
+            int slave;
+            while ((slave = nextSlave++) <= *context->slavecount) {
+                if (!PDOManager::configureSlaveMapping(context, slave)) {
+                    success = false;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    double elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    printf("PDO mapping of %d slaves took %.1f ms (%d workers)\n",
+           *context->slavecount, elapsedMs, workerCount);
+
+    if (!success) {
+        return false;
+    }
+    saveMappingCache();
+
+    // Configure the process image, drives and slow IO in their own groups if the line has both
+    {
+        BringupProfiler::Scope span("ec_config_map", "config");
+        TaskGroups::assign(context);
+        if (image.map(context) <= 0) {
+            printf("Failed to allocate the process image\n");
             return false;
         }
     }
-
-    // Configure IOmap
-    ec_config_map(&IOmap);
+    int stale = rewriteStaleMappings(context);
+    if (stale < 0) {
+        return false;
+    }
+    if (stale > 0 && image.map(context) <= 0) {
+        printf("Failed to allocate the process image\n");
+        return false;
+    }
+    resolveMappings(context);
+    TaskGroups::print(context);
+    reportMailboxStatusMapping(context);
     // Give slaves some time to process PDO configuration
-    osal_usleep(100000);  // 100ms
+    {
+        BringupProfiler::Scope span("PDO settle delay", "sleep");
+        osal_usleep(100000);  // 100ms
+    }
     printf("PDO mapping completed successfully\n");
     return true;
 }
 
+bool PDOManager::remapMapping(const std::string& layout) {
+    if (!PdoLayouts::setDefault(layout)) {
+        printf("Remap: unknown PDO layout '%s'\n", layout.c_str());
+        return false;
+    }
+    ecx_contextt* context = &ecx_context;
+    resetFmmus(context);
+    printf("Remapping the drives to PDO layout %s\n", layout.c_str());
+    return configureMapping(context, defaultImage);
+}
+
+// ec_config_map hands out FMMUs from FMMUunused on, start over from the first
+void PDOManager::resetFmmus(ecx_contextt* context) {
+    for (int slave = 1; slave <= *context->slavecount; slave++) {
+        ec_slavet& info = context->slavelist[slave];
+        uint8_t zero[EC_MAXFMMU * sizeof(ec_fmmut)] = {};
+        if (info.FMMUunused) {
+            ecx_FPWR(context->port, info.configadr, ECT_REG_FMMU0, info.FMMUunused * sizeof(ec_fmmut), zero,
+                     EC_TIMEOUTRET3);
+        }
+        info.FMMUunused = 0;
+    }
+}
+
+// Slaves whose rewrite was skipped but whose PDO sizes, as ec_config_map read
+// them, still do not match the layout. Rewrite them and forget their cache
+// entries. Returns how many were rewritten, the image has to be mapped again
+// then, or -1 if a rewrite failed and the line must not run.
+int PDOManager::rewriteStaleMappings(ecx_contextt* context) {
+    std::vector<SlaveMapping>& table = lineMappings(context);
+    int stale = 0;
+    for (int slave = 1; slave < (int)table.size(); slave++) {
+        SlaveMapping& mapping = table[slave];
+        const ec_slavet& info = context->slavelist[slave];
+        if (!mapping.fromCache || (PdoLayouts::bytes(mapping.rx) == (info.Obits + 7) / 8 &&
+                                   PdoLayouts::bytes(mapping.tx) == (info.Ibits + 7) / 8)) {
+            continue;
+        }
+        printf("Slave %d does not run its cached PDO mapping, rewriting it\n", slave);
+        mapping.fromCache = false;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            mappingCache.erase(identityKey(readIdentity(context, slave)));
+        }
+        if (!configureRxPDO(context, slave) || !configureTxPDO(context, slave)) {
+            printf("Error: rewriting the PDO mapping of slave %d failed\n", slave);
+            saveMappingCache();
+            return -1;
+        }
+        stale++;
+    }
+    if (stale) {
+        saveMappingCache();
+        resetFmmus(context);
+    }
+    return stale;
+}
+
+const char* PDOManager::profileForMode(uint8_t mode) {
+    switch (mode) {
+        case 1: case 8: return "csp";   // PP, CSP
+        case 3: case 9: return "csv";   // PV, CSV
+        case 4: case 10: return "cst";  // PT, CST
+        default: return "full";
+    }
+}
+
+bool PDOManager::attachMapping() {
+    return attachMapping(&ecx_context, defaultImage);
+}
+
+bool PDOManager::attachMapping(ecx_contextt* context, ProcessImage& image) {
+    printf("Attaching to running PDO mapping...\n");
+    // A warm start trusts the slaves to run the layouts they were given last time
+    prepareMappings(context);
+    std::vector<SlaveMapping>& table = lineMappings(context);
+    for (int slave = 1; slave <= *context->slavecount; slave++) {
+        loadEntries(context, slave, PdoLayouts::select(context, slave), table[slave]);
+    }
+    {
+        BringupProfiler::Scope span("ec_config_map (attach)", "config");
+        TaskGroups::assign(context);
+        if (image.map(context) <= 0) {
+            printf("Failed to map running PDO layout\n");
+            return false;
+        }
+    }
+    resolveMappings(context);
+    printf("PDO mapping attached\n");
+    TaskGroups::print(context);
+    reportMailboxStatusMapping(context);
+    return true;
+}
+
+// Slaves whose SM1 status rides in the process data are not polled for SDO replies
+void PDOManager::reportMailboxStatusMapping(ecx_contextt* context) {
+    int mapped = 0;
+    for (int slave = 1; slave <= *context->slavecount; slave++) {
+        if (context->slavelist[slave].mbxstatus) {
+            mapped++;
+        } else if (context->slavelist[slave].mbx_rl) {
+            printf("Slave %d: no spare FMMU, mailbox status is polled\n", slave);
+        }
+    }
+    printf("Mailbox status of %d/%d slaves mapped into process data\n", mapped, *context->slavecount);
+}
+
 bool PDOManager::initializePDO() {
     // Initialize RxPDO data
     rxpdo.controlword = 0x0000;        // Initial state: Off
@@ -151,7 +853,7 @@ bool PDOManager::initializePDO() {
 
     // Write initial data to slave
     for (int slave = 1; slave <= ec_slavecount; slave++) {
-        memcpy(ec_slave[slave].outputs, &rxpdo, sizeof(RxPDO));
+        packRx(rxpdo, slave);
     }
 
     return true;
@@ -160,7 +862,7 @@ bool PDOManager::initializePDO() {
 bool PDOManager::readProcessData(TxPDO& out_txpdo) {
     // Read data from first slave
     if (ec_slave[1].state == EC_STATE_OPERATIONAL) {
-        memcpy(&txpdo, ec_slave[1].inputs, sizeof(TxPDO));
+        unpackTx(1, txpdo);
         out_txpdo = txpdo;
         return true;
     }
@@ -170,24 +872,18 @@ bool PDOManager::readProcessData(TxPDO& out_txpdo) {
 bool PDOManager::writeProcessData(const RxPDO& in_rxpdo) {
     if (ec_slave[1].state == EC_STATE_OPERATIONAL) {
         rxpdo = in_rxpdo;
-        memcpy(ec_slave[1].outputs, &rxpdo, sizeof(RxPDO));
+        packRx(rxpdo, 1);
         return true;
     }
     return false;
 }
 
-bool PDOManager::configurePDOs(int slave) {
-    // PDO mapping configuration
-    uint16_t map_1c12[2] = {0x01, 0x1600};
-    uint16_t map_1c13[2] = {0x01, 0x1A00};
-    
-    if (ec_SDOwrite(slave, 0x1c12, 0, FALSE, sizeof(map_1c12), &map_1c12, EC_TIMEOUTRXM) <= 0) {
-        return false;
-    }
-    
-    if (ec_SDOwrite(slave, 0x1c13, 0, FALSE, sizeof(map_1c13), &map_1c13, EC_TIMEOUTRXM) <= 0) {
-        return false;
+bool PDOManager::configurePDOs(ecx_contextt* context, int slave) {
+    // PDO assignment configuration, slaves keeping their own mapping are not touched
+    const PdoLayout& layout = PdoLayouts::select(context, slave);
+    if (layout.keepsDeviceMapping()) {
+        return true;
     }
-    
-    return true;
+    return writeAssignObject(context, slave, 0x1C12, layout.rxPdo) &&
+           writeAssignObject(context, slave, 0x1C13, layout.txPdo);
 }
\ No newline at end of file
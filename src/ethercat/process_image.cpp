@@ -0,0 +1,81 @@
+#include "process_image.h"
+#include "task_groups.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+ProcessImage::~ProcessImage() {
+    release();
+}
+
+int ProcessImage::map(ecx_contextt* context) {
+    // ecx_config_map_group only computes pointers into the IOmap and programs the
+    // slaves' FMMUs, so the scratch pages are never touched and never committed
+    size_t scratchSize = (size_t)context->maxgroup * EC_MAXIOSEGMENTS * EC_MAXLRWDATA;
+    uint8_t* scratch = (uint8_t*)malloc(scratchSize);
+    if (!scratch) {
+        printf("Process image: no memory for a %zu byte scratch map\n", scratchSize);
+        return 0;
+    }
+
+    int used = TaskGroups::map(context, scratch, layout);
+    if (used <= 0 || !allocate((size_t)used)) {
+        free(scratch);
+        return 0;
+    }
+    ecx_config_rebase(context, scratch, used, image);
+    free(scratch);
+
+    printf("Process image: %d bytes at %p (%s, %s layout)\n", used, (void*)image,
+           hugePage ? "hugepage" : "64 byte aligned", TaskGroups::layoutName(layout));
+    return used;
+}
+
+bool ProcessImage::allocate(size_t size) {
+    release();
+
+    if (useHugePages) {
+        size_t length = (size + TAIL + HUGEPAGE_SIZE - 1) & ~(HUGEPAGE_SIZE - 1);
+        void* block = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (block != MAP_FAILED) {
+            image = (uint8_t*)block;
+            allocated = length;
+            hugePage = true;
+        } else {
+            printf("Process image: no hugepage available, using normal pages\n");
+        }
+    }
+    if (!image) {
+        // Round up so the last cache line of the image is not shared with other data
+        size_t length = (size + TAIL + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        void* block = nullptr;
+        if (posix_memalign(&block, ALIGNMENT, length)) {
+            printf("Process image: cannot allocate %zu bytes\n", length);
+            return false;
+        }
+        image = (uint8_t*)block;
+        allocated = length;
+        hugePage = false;
+    }
+    memset(image, 0, allocated);
+    bytes = size;
+    return true;
+}
+
+void ProcessImage::release() {
+    if (!image) {
+        return;
+    }
+    if (hugePage) {
+        munmap(image, allocated);
+    } else {
+        free(image);
+    }
+    image = nullptr;
+    bytes = 0;
+    allocated = 0;
+    hugePage = false;
+}
@@ -0,0 +1,94 @@
+#include "ring_monitor.h"
+
+#include <cstdio>
+
+void RingMonitor::record(int path, bool complete) {
+    if (path < 0 || path >= EC_RXPATHS) {
+        path = EC_RXPATH_LOST;
+    }
+    cycles++;
+    paths[path]++;
+    lastPath.store(path);
+    if (!complete) {
+        lostCycles++;
+    }
+
+    // A lost frame on a closed ring starts a failover as well, the cable may
+    // have been pulled while the frame was on the wire
+    bool down = (path != EC_RXPATH_OK);
+    if (down && !degraded.load()) {
+        breaks++;
+        degraded.store(true);
+        failingOver = true;
+        failoverCycles = 0;
+    } else if (!down && degraded.load()) {
+        restores++;
+        degraded.store(false);
+    }
+
+    if (failingOver) {
+        if (!complete) {
+            failoverCycles++;
+            return;
+        }
+        failingOver = false;
+        lastFailoverCycles.store(failoverCycles);
+        if (failoverCycles > maxFailoverCycles.load()) {
+            maxFailoverCycles.store(failoverCycles);
+        }
+    }
+}
+
+void RingMonitor::reset() {
+    cycles = 0;
+    for (auto& count : paths) {
+        count = 0;
+    }
+    lostCycles = 0;
+    breaks = 0;
+    restores = 0;
+    lastFailoverCycles = 0;
+    maxFailoverCycles = 0;
+    lastPath = EC_RXPATH_OK;
+    degraded = false;
+    failingOver = false;
+    failoverCycles = 0;
+}
+
+RingMonitor::Stats RingMonitor::getStats() const {
+    Stats stats;
+    stats.cycles = cycles.load();
+    for (int path = 0; path < EC_RXPATHS; path++) {
+        stats.paths[path] = paths[path].load();
+    }
+    stats.lostCycles = lostCycles.load();
+    stats.breaks = breaks.load();
+    stats.restores = restores.load();
+    stats.lastFailoverCycles = lastFailoverCycles.load();
+    stats.maxFailoverCycles = maxFailoverCycles.load();
+    stats.lastPath = lastPath.load();
+    return stats;
+}
+
+const char* RingMonitor::pathName(int path) {
+    switch (path) {
+        case EC_RXPATH_OK: return "ring";
+        case EC_RXPATH_PRIMARY: return "primary";
+        case EC_RXPATH_SECONDARY: return "secondary";
+        case EC_RXPATH_SPLIT: return "split";
+        default: return "lost";
+    }
+}
+
+void RingMonitor::print(const char* name) const {
+    Stats stats = getStats();
+    printf("%s: %llu cycles, returned via", name, (unsigned long long)stats.cycles);
+    for (int path = 0; path < EC_RXPATHS; path++) {
+        printf(" %s %llu", pathName(path), (unsigned long long)stats.paths[path]);
+    }
+    printf(", %llu incomplete\n", (unsigned long long)stats.lostCycles);
+    printf("%s: %llu breaks, %llu restores, failover lost %d cycle(s) last, %d max%s\n",
+           name, (unsigned long long)stats.breaks, (unsigned long long)stats.restores,
+           stats.lastFailoverCycles, stats.maxFailoverCycles,
+           stats.maxFailoverCycles > MAX_FAILOVER_CYCLES ? " - exceeds the one cycle budget" : "");
+}
@@ -1,11 +1,13 @@
 #include "sdo_manager.h"
+#include "master_executor.h"
 
 #include <cstdio>
 #include <cstring>  //add memcpy header file
 
 bool SDOManager::writeSDO(uint16_t slave, uint16_t index, uint8_t subindex,
                          int size, void* data, const char* description) {
-    if (ec_SDOwrite(slave, index, subindex, FALSE, size, data, EC_TIMEOUTRXM) <= 0) {
+    // Queued to the RT thread while it owns the port, direct otherwise
+    if (!MasterExecutor::getInstance().sdoWrite(slave, index, subindex, size, data)) {
         char error_msg[256];
         snprintf(error_msg, sizeof(error_msg), 
                     "Failed to set %s (index: 0x%04X:%d)", description, index, subindex);
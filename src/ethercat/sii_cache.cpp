@@ -0,0 +1,166 @@
+#include "sii_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+const char* SIICache::CACHE_FILE = "sii_cache.txt";
+
+void SIICache::attach(const std::string& file) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        path = file;
+        missCount = 0;
+    }
+    load();
+    ec_SIIdefinehook((void*)&SIICache::loadHook, (void*)&SIICache::storeHook);
+}
+
+void SIICache::attach(ecx_contextt* context) {
+    bool loaded;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        loaded = !path.empty();
+        if (!loaded) {
+            path = CACHE_FILE;
+            missCount = 0;
+        }
+    }
+    if (!loaded) {
+        load();
+    }
+    ecx_SIIdefinehook(context, (void*)&SIICache::loadHook, (void*)&SIICache::storeHook);
+}
+
+void SIICache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    dirty = true;
+}
+
+// The checksum is SII word 0x0007, it only covers the configuration area
+// (words 0-6). Strings, SM, FMMU and PDO categories are not checked: an ESI
+// reflashed with the same identity and configuration area is served stale
+// until the cache file is deleted.
+std::string SIICache::key(const ec_siicachet& sii) {
+    char buf[40];
+    snprintf(buf, sizeof(buf), "%08X:%08X:%08X:%04X",
+             (unsigned)sii.man, (unsigned)sii.id, (unsigned)sii.rev, (unsigned)sii.crc);
+    return buf;
+}
+
+// One line per device: key, mailbox details, blockLRW, E-bus current,
+// FMMU functions, start/length/flags of each SM and the name
+bool SIICache::load() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    dirty = false;
+
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string id;
+        unsigned man, devId, rev, crc;
+        unsigned coe, foe, eoe, soe, blockLRW, fmmu[4];
+        int ebus;
+
+        if (!(fields >> id >> std::hex >> coe >> foe >> eoe >> soe >> blockLRW
+                     >> std::dec >> ebus >> std::hex
+                     >> fmmu[0] >> fmmu[1] >> fmmu[2] >> fmmu[3]) ||
+            sscanf(id.c_str(), "%8x:%8x:%8x:%4x", &man, &devId, &rev, &crc) != 4) {
+            continue;
+        }
+
+        ec_siicachet sii;
+        memset(&sii, 0, sizeof(sii));
+        sii.man = man;
+        sii.id = devId;
+        sii.rev = rev;
+        sii.crc = (uint16)crc;
+        sii.CoEdetails = (uint8)coe;
+        sii.FoEdetails = (uint8)foe;
+        sii.EoEdetails = (uint8)eoe;
+        sii.SoEdetails = (uint8)soe;
+        sii.blockLRW = (uint8)blockLRW;
+        sii.Ebuscurrent = (int16)ebus;
+        sii.FMMU0func = (uint8)fmmu[0];
+        sii.FMMU1func = (uint8)fmmu[1];
+        sii.FMMU2func = (uint8)fmmu[2];
+        sii.FMMU3func = (uint8)fmmu[3];
+
+        bool valid = true;
+        for (int sm = 0; sm < EC_MAXSM && valid; sm++) {
+            unsigned start, length, flags;
+            valid = static_cast<bool>(fields >> start >> length >> flags);
+            sii.SM[sm].StartAddr = (uint16)start;
+            sii.SM[sm].SMlength = (uint16)length;
+            sii.SM[sm].SMflags = (uint32)flags;
+        }
+        if (!valid) continue;
+
+        std::string name;
+        std::getline(fields >> std::ws, name);
+        strncpy(sii.name, name.c_str(), EC_MAXNAME);
+
+        entries[key(sii)] = sii;
+    }
+    printf("Loaded %zu SII cache entries\n", entries.size());
+    return !entries.empty();
+}
+
+void SIICache::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    printf("SII cache: %d slaves read from EEPROM, %zu devices cached\n",
+           missCount, entries.size());
+    if (!dirty) return;
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        printf("Warning: cannot write SII cache %s\n", path.c_str());
+        return;
+    }
+    for (const auto& item : entries) {
+        const ec_siicachet& sii = item.second;
+        file << item.first << std::hex
+             << " " << (unsigned)sii.CoEdetails << " " << (unsigned)sii.FoEdetails
+             << " " << (unsigned)sii.EoEdetails << " " << (unsigned)sii.SoEdetails
+             << " " << (unsigned)sii.blockLRW
+             << " " << std::dec << sii.Ebuscurrent << std::hex
+             << " " << (unsigned)sii.FMMU0func << " " << (unsigned)sii.FMMU1func
+             << " " << (unsigned)sii.FMMU2func << " " << (unsigned)sii.FMMU3func;
+        for (int sm = 0; sm < EC_MAXSM; sm++) {
+            file << " " << sii.SM[sm].StartAddr << " " << sii.SM[sm].SMlength
+                 << " " << sii.SM[sm].SMflags;
+        }
+        file << std::dec << " " << sii.name << "\n";
+    }
+    dirty = false;
+}
+
+// Called by ec_config_init with identity and checksum filled in
+int SIICache::loadHook(ecx_contextt* context, uint16 slave, ec_siicachet* sii) {
+    (void)context;
+    (void)slave;
+    SIICache& cache = getInstance();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    auto it = cache.entries.find(key(*sii));
+    if (it == cache.entries.end()) {
+        return 0;
+    }
+    *sii = it->second;
+    return 1;
+}
+
+void SIICache::storeHook(ecx_contextt* context, uint16 slave, const ec_siicachet* sii) {
+    (void)context;
+    SIICache& cache = getInstance();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    cache.entries[key(*sii)] = *sii;
+    cache.dirty = true;
+    cache.missCount++;
+    printf("SII of slave %d (%s) read from EEPROM and cached\n", slave, sii->name);
+}
@@ -0,0 +1,283 @@
+#include "task_groups.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// CiA402 drives run in the fast group. A CoE device whose type cannot be read
+// stays fast as well, slowing down a drive is worse than cycling IO too often.
+bool TaskGroups::isDrive(ecx_contextt* context, int slave) {
+    if (!(context->slavelist[slave].mbx_proto & ECT_MBXPROT_COE)) {
+        return false;
+    }
+    uint32 deviceType = 0;
+    int size = sizeof(deviceType);
+    if (ecx_SDOread(context, slave, 0x1000, 0x00, FALSE, &size, &deviceType, EC_TIMEOUTRXM) <= 0) {
+        return true;
+    }
+    return (etohl(deviceType) & 0xFFFF) == 402;
+}
+
+int TaskGroups::assign(ecx_contextt* context) {
+    int slaveCount = *context->slavecount;
+    std::vector<bool> drive(slaveCount + 1, false);
+    int drives = 0;
+    for (int slave = 1; slave <= slaveCount; slave++) {
+        drive[slave] = isDrive(context, slave);
+        drives += drive[slave] ? 1 : 0;
+    }
+
+    for (int group = 0; group < context->maxgroup; group++) {
+        context->grouplist[group].cycledivisor = 0;
+    }
+    if (drives == 0 || drives == slaveCount || context->maxgroup <= SLOW_GROUP) {
+        for (int slave = 1; slave <= slaveCount; slave++) {
+            context->slavelist[slave].group = 0;
+        }
+        context->grouplist[0].cycledivisor = 1;
+        return 1;
+    }
+
+    for (int slave = 1; slave <= slaveCount; slave++) {
+        context->slavelist[slave].group = drive[slave] ? FAST_GROUP : SLOW_GROUP;
+    }
+    context->grouplist[FAST_GROUP].cycledivisor = 1;
+    context->grouplist[SLOW_GROUP].cycledivisor = SLOW_PERIOD_US / 1000;
+    printf("Task groups: %d drives every cycle, %d slaves in the slow group\n",
+           drives, slaveCount - drives);
+    return 2;
+}
+
+void TaskGroups::setCycle(ecx_contextt* context, int cycleUs) {
+    if (context->maxgroup > SLOW_GROUP && context->grouplist[SLOW_GROUP].cycledivisor && cycleUs > 0) {
+        int divisor = SLOW_PERIOD_US / cycleUs;
+        context->grouplist[SLOW_GROUP].cycledivisor = (uint16)(divisor > 1 ? divisor : 1);
+    }
+}
+
+bool TaskGroups::parseLayout(const char* name, Layout& layout) {
+    for (int candidate = LAYOUT_PACKED; candidate <= LAYOUT_ALIGNED; candidate++) {
+        if (strcmp(name, layoutName((Layout)candidate)) == 0) {
+            layout = (Layout)candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* TaskGroups::layoutName(Layout layout) {
+    switch (layout) {
+        case LAYOUT_OVERLAP: return "overlap";
+        case LAYOUT_ALIGNED: return "aligned";
+        default: return "packed";
+    }
+}
+
+int TaskGroups::mapGroup(ecx_contextt* context, void* IOmap, uint8 group, Layout layout) {
+    switch (layout) {
+        case LAYOUT_OVERLAP: return ecx_config_overlap_map_group(context, IOmap, group);
+        case LAYOUT_ALIGNED: return ecx_config_map_group_aligned(context, IOmap, group);
+        default: return ecx_config_map_group(context, IOmap, group);
+    }
+}
+
+int TaskGroups::map(ecx_contextt* context, void* IOmap, Layout layout) {
+    // Prebuilt frames point into the old image
+    unfreeze(context);
+    if (fastGroup(context) == 0) {
+        return mapGroup(context, IOmap, 0, layout);
+    }
+
+    // Each group gets its own logical address range directly behind the previous one
+    uint32 used = 0;
+    for (int group = 1; group < context->maxgroup; group++) {
+        if (!context->grouplist[group].cycledivisor) continue;
+        context->grouplist[group].logstartaddr = used;
+        used += mapGroup(context, (uint8*)IOmap + used, (uint8)group, layout);
+    }
+    return (int)used;
+}
+
+void TaskGroups::shareDC(ecx_contextt* context) {
+    if (fastGroup(context) == 0 || !context->slavelist[0].hasdc) {
+        return;
+    }
+    // ecx_configdc puts the DC datagram into the group of the reference clock
+    uint16 reference = 0;
+    for (int slave = 1; slave <= *context->slavecount && !reference; slave++) {
+        if (context->slavelist[slave].hasdc) {
+            reference = (uint16)slave;
+        }
+    }
+    for (int group = 0; group < context->maxgroup; group++) {
+        context->grouplist[group].hasdc = FALSE;
+    }
+    context->grouplist[FAST_GROUP].hasdc = TRUE;
+    context->grouplist[FAST_GROUP].DCnext = reference;
+}
+
+uint8 TaskGroups::fastGroup(ecx_contextt* context) {
+    return (context->maxgroup > FAST_GROUP && context->grouplist[FAST_GROUP].cycledivisor) ? FAST_GROUP : 0;
+}
+
+bool TaskGroups::isCycled(ecx_contextt* context, uint8 group) {
+    // Without assign() the line runs as plain group 0
+    if (group == fastGroup(context)) {
+        return true;
+    }
+    return group < context->maxgroup && context->grouplist[group].cycledivisor > 0;
+}
+
+bool TaskGroups::isDue(ecx_contextt* context, uint8 group, uint32_t cycle) {
+    if (group == fastGroup(context)) {
+        return true;
+    }
+    uint16 divisor = context->grouplist[group].cycledivisor;
+    return divisor > 0 && (cycle % divisor) == 0;
+}
+
+int TaskGroups::send(ecx_contextt* context, uint32_t cycle) {
+    int expected = 0;
+    for (int group = 0; group < context->maxgroup; group++) {
+        if (!isDue(context, (uint8)group, cycle)) continue;
+        if (context->grouplist[group].nfrozen) {
+            ecx_send_frozen_processdata_group(context, (uint8)group);
+        } else if (context->grouplist[group].overlapio) {
+            ecx_send_overlap_processdata_group(context, (uint8)group);
+        } else {
+            ecx_send_processdata_group(context, (uint8)group);
+        }
+        expected += (context->grouplist[group].outputsWKC * 2) + context->grouplist[group].inputsWKC;
+    }
+    return expected;
+}
+
+int TaskGroups::freeze(ecx_contextt* context) {
+    int frames = 0;
+    for (int group = 0; group < context->maxgroup; group++) {
+        if (!isCycled(context, (uint8)group)) continue;
+        int built = ecx_freeze_processdata_group(context, (uint8)group);
+        if (!built) {
+            printf("Group %d needs more than %d frames, it is built every cycle\n", group, EC_MAXFROZEN);
+            continue;
+        }
+        // Keep indexes for mailbox and other acyclic frames, ecx_getindex must never run dry
+        if (frames + built > MAX_FROZEN_FRAMES) {
+            ecx_unfreeze_processdata_group(context, (uint8)group);
+            printf("Group %d: %d more frozen frames exceed %d of %d frame indexes, it is built every cycle\n",
+                   group, built, MAX_FROZEN_FRAMES, EC_MAXBUF);
+            continue;
+        }
+        printf("Group %d: %d frozen frame(s)%s\n", group, built,
+               context->grouplist[group].inputalias ? ", inputs read in place" : "");
+        frames += built;
+    }
+    return frames;
+}
+
+void TaskGroups::unfreeze(ecx_contextt* context) {
+    for (int group = 0; group < context->maxgroup; group++) {
+        ecx_unfreeze_processdata_group(context, (uint8)group);
+    }
+}
+
+bool TaskGroups::isFrozen(ecx_contextt* context) {
+    for (int group = 0; group < context->maxgroup; group++) {
+        if (context->grouplist[group].nfrozen) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int TaskGroups::receive(ecx_contextt* context, int timeout) {
+    return ecx_receive_processdata_group(context, fastGroup(context), timeout);
+}
+
+int TaskGroups::expectedWKC(ecx_contextt* context, uint32_t cycle) {
+    int expected = 0;
+    for (int group = 0; group < context->maxgroup; group++) {
+        if (isDue(context, (uint8)group, cycle)) {
+            expected += (context->grouplist[group].outputsWKC * 2) + context->grouplist[group].inputsWKC;
+        }
+    }
+    return expected;
+}
+
+// One frame: Ethernet header, EtherCAT header, the process data datagram and
+// the AL status / DC datagrams riding in the first frame of the group
+void TaskGroups::addFrame(FrameStats& stats, int dataBytes, int extraDatagrams, int extraBytes) {
+    const int ETH_HEADER = 14, ECAT_HEADER = 2, DATAGRAM_OVERHEAD = 10 + 2;
+    const int MIN_FRAME = 60, FCS = 4, PREAMBLE_IFG = 8 + 12;
+    int bytes = ETH_HEADER + ECAT_HEADER + DATAGRAM_OVERHEAD + dataBytes + extraBytes;
+    stats.frames++;
+    stats.datagrams += 1 + extraDatagrams;
+    stats.bytes += bytes;
+    // 100 Mbit/s: 80 ns per byte
+    stats.wireUs += ((bytes < MIN_FRAME ? MIN_FRAME : bytes) + FCS + PREAMBLE_IFG) * 0.08;
+}
+
+TaskGroups::FrameStats TaskGroups::frameStats(ecx_contextt* context, uint8 group) {
+    FrameStats stats = {0, 0, 0, 0.0};
+    const ec_groupt& g = context->grouplist[group];
+    int length = g.overlapio ? (g.Obytes > g.Ibytes ? g.Obytes : g.Ibytes) : g.Obytes + g.Ibytes;
+    if (!length) {
+        return stats;
+    }
+
+    // AL status BRD (2 bytes) and DC FRMW (8 bytes) go into the first frame
+    int firstDatagrams = (g.supervise ? 1 : 0) + (g.hasdc ? 1 : 0);
+    int firstBytes = (g.supervise ? 2 + 12 : 0) + (g.hasdc ? 8 + 12 : 0);
+    if (g.blockLRW) {
+        // Inputs by LRD from the input segment on, then outputs by LWR
+        int remaining = (int)g.Ibytes;
+        for (int segment = g.Isegment; remaining > 0 && segment < g.nsegments; segment++) {
+            int data = (int)g.IOsegment[segment] - (segment == g.Isegment ? g.Ioffset : 0);
+            addFrame(stats, data, firstDatagrams, firstBytes);
+            firstDatagrams = firstBytes = 0;
+            remaining -= data;
+        }
+        remaining = (int)g.Obytes;
+        for (int segment = 0; remaining > 0 && segment < g.nsegments; segment++) {
+            int data = (int)g.IOsegment[segment] < remaining ? (int)g.IOsegment[segment] : remaining;
+            addFrame(stats, data, firstDatagrams, firstBytes);
+            firstDatagrams = firstBytes = 0;
+            remaining -= data;
+        }
+    } else {
+        for (int segment = 0; segment < g.nsegments; segment++) {
+            addFrame(stats, (int)g.IOsegment[segment], firstDatagrams, firstBytes);
+            firstDatagrams = firstBytes = 0;
+        }
+    }
+    return stats;
+}
+
+void TaskGroups::print(ecx_contextt* context) {
+    FrameStats fast = {0, 0, 0, 0.0};
+    FrameStats all = {0, 0, 0, 0.0};
+    for (int group = 0; group < context->maxgroup; group++) {
+        if (!isCycled(context, (uint8)group)) continue;
+        const ec_groupt& g = context->grouplist[group];
+        int slaves = 0;
+        for (int slave = 1; slave <= *context->slavecount; slave++) {
+            if (group == 0 || context->slavelist[slave].group == group) slaves++;
+        }
+        FrameStats frames = frameStats(context, (uint8)group);
+        printf("Group %d: %d slaves, every %d cycle(s), %u output + %u input bytes in %d segment(s)%s%s\n",
+               group, slaves, g.cycledivisor ? g.cycledivisor : 1, g.Obytes, g.Ibytes, g.nsegments,
+               g.hasdc ? ", DC" : "", g.overlapio ? ", overlapped" : "");
+        printf("Group %d: %d frame(s), %d datagram(s), %d bytes, %.1f us on the wire\n",
+               group, frames.frames, frames.datagrams, frames.bytes, frames.wireUs);
+
+        if (group == fastGroup(context)) {
+            fast = frames;
+        }
+        all.frames += frames.frames;
+        all.datagrams += frames.datagrams;
+        all.bytes += frames.bytes;
+        all.wireUs += frames.wireUs;
+    }
+    printf("Cycle wire time: %.1f us (%d frames, %d bytes), %.1f us when every group is due\n",
+           fast.wireUs, fast.frames, fast.bytes, all.wireUs);
+}
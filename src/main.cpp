@@ -1,4 +1,6 @@
 // Standard C/C++ headers
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
@@ -9,6 +11,7 @@
 // POSIX system headers
 #include <pthread.h>
 #include <sched.h>
+#include <semaphore.h>
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -24,6 +27,13 @@
 #include "ethercat_thread.h"
 #include "monitor_window.h"
 #include "sdo_manager.h"
+#include "bringup_profiler.h"
+#include "master_executor.h"
+#include "ethercat_line.h"
+#include "task_groups.h"
+#include "ring_monitor.h"
+#include "axis_state.h"
+#include "cia402_fsm.h"
 
 // Newly added header
 #include "csp_motion_planning.h"
@@ -39,7 +49,6 @@
  */
 
 // Global variables for EtherCAT communication
-char IOmap[4096]; // I/O mapping for EtherCAT
 int expectedWKC;  // Expected Work Counter
 boolean needlf;   // Flag to indicate if a line feed is needed
 volatile int wkc; // Work Counter (volatile to ensure it is updated correctly in multi-threaded context)
@@ -88,6 +97,8 @@ int32_t received_target = 0;
 // Global variables for PDO and shared data
 PDOManager::RxPDO rxpdo;  // Data to be sent to slaves
 PDOManager::TxPDO txpdo;  // Data received from slaves
+static AxisState axisState;  // Aligned per-axis copy of the drives' process data
+static Cia402Fsm driveFsm;   // CiA402 state machine of every axis, RT thread only
 monitor::SharedData sharedData;    // Global shared data instance
 
 // Define planner instance in global scope
@@ -100,6 +111,29 @@ static int communication_error_count = 0;
 static const int MAX_ERROR_COUNT = 10;  // Maximum allowed consecutive errors
 static bool need_reconnect = false;
 
+// Set when bring-up re-attached to a running line, the RT thread then keeps the drive state
+static bool warm_started = false;
+// --frozen-frames: cyclic frames are built once after mapping (TaskGroups::freeze)
+static bool frozen_frames = false;
+// Main thread parks the cyclic exchange, e.g. to remap the drives' PDOs
+static std::atomic<bool> rt_hold{false};
+static std::atomic<bool> rt_held{false};
+
+// Slave supervision: the cyclic frame carries a BRD of AL status, the RT thread
+// raises the alarm and the check thread only then diagnoses slave by slave
+static sem_t supervision_sem;
+static std::atomic<bool> supervision_alarm{false};
+static bool supervision_brd = true;  // false if the BRD did not fit into the frame
+
+static inline bool line_state_ok() {
+    if (!supervision_brd) {
+        return !ec_group[currentgroup].docheckstate;
+    }
+    // OR over all slaves is plain OP only if every slave is in OP without error
+    return ec_group[currentgroup].alstatuswkc == ec_slavecount &&
+           (ec_group[currentgroup].alstatus & 0x1F) == EC_STATE_OPERATIONAL;
+}
+
 // Function: Set the CPU affinity for a thread
 void set_thread_affinity(pthread_t thread, int cpu_core) {
     cpu_set_t cpuset; // CPU set to specify which CPUs the thread can run on
@@ -115,6 +149,201 @@ void set_thread_affinity(pthread_t thread, int cpu_core) {
     }
 }
 
+// Take over the CiA402 state of every drive after a warm start so the first
+// frames do not disable drives that are still holding position. Runs after
+// the axis state is bound, reads go through the executor like any other SDO.
+// False if a drive could not be read, the line then starts like a cold one.
+static bool adopt_drive_state() {
+    MasterExecutor& executor = MasterExecutor::getInstance();
+    int enabled = 0;
+    for (int axis = 0; axis < axisState.count(); axis++) {
+        int slave = axisState.slave(axis);
+        uint16_t statusword = 0;
+        int32_t position = 0;
+        int8_t mode = 0;
+        int size;
+
+        // A missing position or mode would command the drive to 0, adopt all or nothing
+        size = sizeof(statusword);
+        bool ok = executor.sdoRead(slave, 0x6041, 0x00, &size, &statusword);
+        size = sizeof(position);
+        ok = ok && executor.sdoRead(slave, 0x6064, 0x00, &size, &position);
+        size = sizeof(mode);
+        ok = ok && executor.sdoRead(slave, 0x6061, 0x00, &size, &mode);
+        if (!ok) {
+            printf("Warm start: drive %d state could not be read, the drives are not adopted\n", slave);
+            return false;
+        }
+
+        int32_t controlword;
+        switch (statusword & 0x6F) {
+            case 0x27:  // Operation enabled
+                controlword = 0x000F;
+                enabled++;
+                break;
+            case 0x23:  // Switched on
+                controlword = 0x0007;
+                break;
+            case 0x21:  // Ready to switch on
+                controlword = 0x0006;
+                break;
+            default:  // no fault reset, that stays the user's decision
+                controlword = 0x0000;
+                break;
+        }
+        axisState.rx(AxisState::CONTROLWORD)[axis] = controlword;
+        axisState.rx(AxisState::TARGET_POSITION)[axis] = position;
+        axisState.rx(AxisState::TARGET_VELOCITY)[axis] = 0;
+        axisState.rx(AxisState::TARGET_TORQUE)[axis] = 0;
+        axisState.rx(AxisState::MODE)[axis] = mode;
+        axisState.tx(AxisState::STATUSWORD)[axis] = statusword;
+        axisState.tx(AxisState::ACTUAL_POSITION)[axis] = position;
+        axisState.tx(AxisState::MODE_DISPLAY)[axis] = mode;
+        printf("Warm start: drive %d status 0x%04x, mode %d, position %d, controlword 0x%04x\n",
+               slave, statusword, mode, position, controlword);
+    }
+    if (axisState.count() == 0) {
+        return true;
+    }
+
+    // The UI mirrors the last drive
+    int last = axisState.count() - 1;
+    axisState.toTx(last, txpdo);
+    axisState.toRx(last, rxpdo);
+    rxpdo.padding = 0;
+    // Only a line whose drives are all enabled stays enabled, anything else is stepped down
+    if (enabled == axisState.count()) {
+        sharedData.operationMode.store(rxpdo.mode_of_operation);
+        sharedData.modeConfirmed.store(true);
+        sharedData.enableRequested.store(true);
+        sharedData.motorEnabled.store(true);
+        sharedData.targetPosition.store(rxpdo.target_position);
+        lastMotorEnabled = true;
+        motorStateChanged = true;
+    } else if (enabled > 0) {
+        printf("Warm start: %d of %d drives enabled, the others are disabled\n", enabled, axisState.count());
+    }
+    return true;
+}
+
+// Mode change to a mode the drives' PDOs do not carry: park the cyclic
+// exchange, take the line to PRE-OP, assign the profile of the mode through
+// 0x1C12/0x1C13, map the image anew and bring the line back to OP. Main
+// thread, the drives are disabled while a mode change is pending.
+static bool remap_drives(uint8_t mode) {
+    const char* layout = PDOManager::profileForMode(mode);
+    printf("Mode %d is not carried by the drives' PDOs, switching to the %s profile\n", mode, layout);
+    int count = axisState.count();
+
+    inOP = FALSE;  // no recovery while the line leaves OP on purpose
+    rt_hold.store(true);
+    for (int wait = 0; !rt_held.load() && wait < 1000; wait++) {
+        osal_usleep(1000);
+    }
+    if (!rt_held.load()) {
+        // Nothing touched yet, the line stays as it was
+        printf("ERROR: RT thread did not park, PDO remap for mode %d skipped\n", mode);
+        rt_hold.store(false);
+        inOP = TRUE;
+        return false;
+    }
+    bool ok = EtherCATManager::getInstance().setState(EC_STATE_PRE_OP) && PDOManager::remapMapping(layout);
+    if (ok) {
+        TaskGroups::setCycle(&ecx_context, ctime_thread);
+        if (frozen_frames) {
+            TaskGroups::freeze(&ecx_context);
+        }
+        // Same drives, new offsets
+        ok = axisState.bind(&ecx_context, PDOManager::processImage().data()) && axisState.count() == count &&
+             PDOManager::supportsMode(mode) && EtherCATManager::getInstance().setState(EC_STATE_SAFE_OP);
+    }
+    if (!ok) {
+        // The old image may be freed and the axes unbound: the RT thread stays
+        // parked and the line stopped until the application is restarted
+        printf("ERROR: PDO remap for mode %d failed, the line is stopped\n", mode);
+        sharedData.lineStopped.store(true);
+        return false;
+    }
+    // OP needs process data on the wire, the RT thread exchanges again from here
+    rt_hold.store(false);
+    if (!EtherCATManager::getInstance().setState(EC_STATE_OPERATIONAL)) {
+        printf("ERROR: line did not return to OP after the PDO remap for mode %d\n", mode);
+        sharedData.lineStopped.store(true);
+        return false;
+    }
+    inOP = TRUE;
+    printf("Drives remapped to the %s profile\n", layout);
+    return true;
+}
+
+// Cost of each frame wait strategy: latency per frame and CPU burnt while waiting
+static void print_wait_stats() {
+    const char* names[EC_WAIT_MODES] = {"spin", "poll"};
+    for (int mode = 0; mode < EC_WAIT_MODES; mode++) {
+        ec_waitstatt st;
+        ecx_getwaitstats(mode, &st);
+        if (st.frames + st.timeouts == 0) continue;
+        uint64_t waits = st.frames + st.timeouts;
+        printf("Frame wait %s: %llu frames, %llu timeouts, avg %.1f us (max %.1f us), CPU %.0f%% of wait time\n",
+               names[mode], (unsigned long long)st.frames, (unsigned long long)st.timeouts,
+               st.waitns / 1000.0 / waits, st.maxns / 1000.0,
+               st.waitns ? 100.0 * st.cpuns / st.waitns : 0.0);
+    }
+}
+
+// Ring breaks and restores of a cable redundant line, polled by the check thread
+static void report_ring_state() {
+    static bool wasDegraded = false;
+    EtherCATManager& manager = EtherCATManager::getInstance();
+    if (!manager.isRedundant()) return;
+    RingMonitor& ring = manager.getRingMonitor();
+    bool degraded = ring.isDegraded();
+    if (degraded == wasDegraded) return;
+    wasDegraded = degraded;
+
+    RingMonitor::Stats stats = ring.getStats();
+    if (degraded) {
+        printf("WARNING: EtherCAT ring broken, frames return via %s, failover lost %d cycle(s)\n",
+               RingMonitor::pathName(stats.lastPath), stats.lastFailoverCycles);
+    } else {
+        printf("EtherCAT ring closed again\n");
+    }
+}
+
+// Drive state changes queued by the RT thread's state machine, printed by the check thread
+static void report_drive_events() {
+    static uint64_t lastDropped = 0;
+    Cia402Fsm::Event event;
+    while (driveFsm.poll(event)) {
+        int slave = event.axis < axisState.count() ? axisState.slave(event.axis) : 0;
+        switch (event.type) {
+            case Cia402Fsm::Event::TRANSITION:
+                printf("Drive %d: %s -> %s (status 0x%04x, control 0x%04x)\n", slave,
+                       Cia402Fsm::stateName(event.from), Cia402Fsm::stateName(event.to),
+                       event.statusword, event.controlword);
+                break;
+            case Cia402Fsm::Event::SETPOINT_ACKNOWLEDGED:
+                printf("Drive %d: new setpoint acknowledged\n", slave);
+                break;
+            case Cia402Fsm::Event::TARGET_REACHED:
+                printf("Drive %d: target position reached\n", slave);
+                break;
+            case Cia402Fsm::Event::ENABLE_REFUSED:
+                printf("Cannot enable: Operation mode not confirmed\n");
+                break;
+            case Cia402Fsm::Event::ENABLE_LOST:
+                printf("Drive %d: left operation enabled (%s), motor disabled\n", slave,
+                       Cia402Fsm::stateName(event.to));
+                break;
+        }
+    }
+    uint64_t dropped = driveFsm.dropped();
+    if (dropped != lastDropped) {
+        printf("WARNING: %llu drive events dropped\n", (unsigned long long)(dropped - lastDropped));
+        lastDropped = dropped;
+    }
+}
+
 // Function prototype for the EtherCAT test function
 int erob_test();
 
@@ -157,61 +386,120 @@ int erob_test() {
     sharedData.writeIndex.store(0);
     sharedData.readIndex.store(0);
     
+    // Bring-up start time, used to report time-to-SAFE_OP against slave count
+    auto bringupStart = std::chrono::steady_clock::now();
+    BringupProfiler& profiler = BringupProfiler::getInstance();
+    profiler.reset();
+
+    // Bring-up and diagnostics sleep in ppoll while a frame is out, only the RT thread spins
+    ecx_setwaitmode(EC_WAIT_POLL);
+    ecx_enablewaitstats(TRUE);
+
     printf("__________STEP 1___________________\n");
-    if (!EtherCATManager::getInstance().initialize(ifname.c_str())) {
+    BringupProfiler::Scope step1("STEP 1 init and slave scan", "phase");
+    if (!EtherCATManager::getInstance().initialize(ifname, sharedData.secondaryInterface)) {
         printf("Failed to initialize EtherCAT on interface %s\n", ifname.c_str());
         return -1;
     }
-    
-    // Step 2: Check and set slave states
-    printf("__________STEP 2___________________\n");
-    if (!EtherCATManager::getInstance().checkState()) {
-        printf("Failed to set slave states\n");
-        return -1;
-    }
+    step1.end();
+    warm_started = EtherCATManager::getInstance().isWarmStart();
+
+    if (warm_started) {
+        // Warm start: slaves stay in SAFE_OP/OP, only the master side is rebuilt
+        printf("__________STEP 2-5 (warm start)____\n");
+        BringupProfiler::Scope attach("STEP 2-5 warm attach", "phase");
+        if (!PDOManager::attachMapping() || !DCManager::getInstance().attachDC()) {
+            printf("Warm attach failed\n");
+            EtherCATManager::getInstance().endWarmStart();
+            return -1;
+        }
+        EtherCATManager::getInstance().endWarmStart();
+        attach.end();
+    } else {
+        // Step 2: Check and set slave states
+        printf("__________STEP 2___________________\n");
+        BringupProfiler::Scope step2("STEP 2 state check", "phase");
+        if (!EtherCATManager::getInstance().checkState()) {
+            printf("Failed to set slave states\n");
+            return -1;
+        }
+        step2.end();
+
+        // Step 3: Map RXPDO and TXPDO
+        printf("__________STEP 3___________________\n");
+        BringupProfiler::Scope step3("STEP 3 PDO mapping", "phase");
+        if (!PDOManager::configureMapping()) {
+            printf("PDO mapping failed\n");
+            return -1;
+        }
+        step3.end();
 
-    // Step 3: Map RXPDO and TXPDO
-    printf("__________STEP 3___________________\n");
-    if (!PDOManager::configureMapping()) {
-        printf("PDO mapping failed\n");
-        return -1;
-    }
-    
-    // Step 4: Configure Distributed Clock (DC)
-    printf("__________STEP 4___________________\n");
-    printf("Configuring DC...\n");
-    
-    // Configure distributed clock
-    if (!DCManager::getInstance().configureDC()) {
-        printf("Failed to configure DC\n");
-        return -1;
-    }
+        // Step 4: Configure Distributed Clock (DC)
+        printf("__________STEP 4___________________\n");
+        printf("Configuring DC...\n");
+        BringupProfiler::Scope step4("STEP 4 DC configuration", "phase");
 
-    EtherCATManager::getInstance().setState(EC_STATE_PRE_OP);
+        // Configure distributed clock
+        if (!DCManager::getInstance().configureDC()) {
+            printf("Failed to configure DC\n");
+            return -1;
+        }
 
-    // Step 5: Transition to SAFE_OP state
-    printf("__________STEP 5___________________\n");
-    printf("Requesting SAFE_OP state...\n");
-    
-    if (!EtherCATManager::getInstance().setState(EC_STATE_SAFE_OP)) {
-        printf("Failed to reach SAFE_OP state\n");
-        return -1;
+        EtherCATManager::getInstance().setState(EC_STATE_PRE_OP);
+        step4.end();
+
+        // Step 5: Transition to SAFE_OP state
+        printf("__________STEP 5___________________\n");
+        printf("Requesting SAFE_OP state...\n");
+        BringupProfiler::Scope step5("STEP 5 SAFE_OP", "phase");
+
+        if (!EtherCATManager::getInstance().setState(EC_STATE_SAFE_OP)) {
+            printf("Failed to reach SAFE_OP state\n");
+            return -1;
+        }
+        step5.end();
     }
     printf("Successfully reached SAFE_OP state\n");
+    printf("Time to SAFE_OP: %.1f ms for %d slaves\n",
+           std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bringupStart).count(),
+           ec_slavecount);
 
     EtherCATManager::getInstance().getExpectedWKC();
     // Read DC synchronization configuration
     DCManager::getInstance().printDCStatus();
 
     printf("__________STEP 6___________________\n");
+    BringupProfiler::Scope step6("STEP 6 start RT threads", "phase");
     // Start the EtherCAT thread for real-time processing
+    sem_init(&supervision_sem, 0, 0);
+    // Supervision and DC ride in the group that is exchanged every cycle
+    currentgroup = TaskGroups::fastGroup(&ecx_context);
+    TaskGroups::setCycle(&ecx_context, ctime_thread);
+    ec_group[currentgroup].supervise = TRUE;  // AL status BRD in every cyclic frame
+    if (frozen_frames) {
+        TaskGroups::freeze(&ecx_context);
+    }
+    // After freezing, drive inputs may have moved into the receive buffers
+    axisState.bind(&ecx_context, PDOManager::processImage().data());
+    driveFsm.resize(axisState.count());
+    std::vector<int> axisSlaves;
+    for (int axis = 0; axis < axisState.count(); axis++) {
+        axisSlaves.push_back(axisState.slave(axis));
+    }
+    sharedData.modeChange.resize(axisSlaves);
+    if (warm_started && !adopt_drive_state()) {
+        warm_started = false;  // cold initial setpoints, the drives are stepped down
+    }
+    TaskGroups::print(&ecx_context);
     start_ecatthread_thread = TRUE; // Flag to indicate that the EtherCAT thread should start
     osal_thread_create_rt((void*)&thread1, stack64k * 2, (void *)&ecatthread, (void *)&ctime_thread); // Create the real-time EtherCAT thread
     osal_thread_create((void*)&thread2, stack64k * 2, (void *)&ecatcheck, NULL); // Create the EtherCAT check thread
     printf("___________________________________________\n");
+    step6.end();
 
     // Step 7: Transition to OP state
     printf("__________STEP 7___________________\n");
+    BringupProfiler::Scope step7("STEP 7 OP", "phase");
 
   // Send process data to the slaves
     EtherCATManager::getInstance().sendProcessData();
@@ -221,7 +509,19 @@ int erob_test() {
         printf("Failed to reach OPERATIONAL state\n");
         return -1;
     }
+    step7.end();
     printf("Successfully reached OP state\n");
+    if (ec_group[currentgroup].alstatuswkc == 0) {
+        supervision_brd = false;
+        printf("AL status BRD does not fit into the cyclic frame, supervision uses the state check flag\n");
+    }
+    inOP = TRUE;
+    // Lets the next session re-attach without resetting the line
+    EtherCATManager::getInstance().saveLineFingerprint();
+
+    // Bring-up timing: summary on the console, spans as Chrome trace
+    profiler.printSummary();
+    profiler.writeChromeTrace("bringup_trace.json");
 
     // Step 8: Configure servomotor and mode operation
     printf("__________STEP 8___________________\n");
@@ -235,6 +535,15 @@ int erob_test() {
                 printf("Received stop signal, breaking main loop\n");
                 break;
             }
+            // A pending mode change the PDOs cannot carry remaps the drives first,
+            // a stopped line takes no further mode change
+            if (sharedData.modeChange.isPending() && sharedData.lineStopped.load()) {
+                sharedData.modeChange.fail();
+            } else if (sharedData.modeChange.isPending() && !sharedData.motorEnabled.load() &&
+                       !PDOManager::supportsMode(sharedData.modeChange.mode()) &&
+                       !remap_drives(sharedData.modeChange.mode())) {
+                sharedData.modeChange.fail();
+            }
             osal_usleep(100000);
         }
     }
@@ -250,6 +559,7 @@ int erob_test() {
     // Wait for check thread to stop
     if (thread2 != 0) {
         void* thread_result;
+        sem_post(&supervision_sem);
         pthread_join(thread2, &thread_result);
         printf("EtherCAT check thread stopped\n");
     }
@@ -263,6 +573,12 @@ int erob_test() {
 
     osal_usleep(1e6);
 
+    print_wait_stats();
+    if (EtherCATManager::getInstance().isRedundant()) {
+        EtherCATManager::getInstance().getRingMonitor().print("Cable redundancy");
+    }
+    // Frozen frames hold their indexes and point into the image
+    TaskGroups::unfreeze(&ecx_context);
     ec_close();
 
     printf("\nRequesting INIT state for all slaves\n");
@@ -317,33 +633,79 @@ void add_timespec(struct timespec *ts, int64 addtime) {
     }
 }
 
-// Define state machine states
-enum DriveState {
-    STATE_NOT_READY     = 0,
-    STATE_SWITCH_ON_DISABLED = 0x40,
-    STATE_READY_TO_SWITCH_ON = 0x21,
-    STATE_SWITCHED_ON   = 0x23,
-    STATE_OPERATION_ENABLED = 0x27,
-    STATE_FAULT         = 0x08,
-    STATE_FAULT_REACTION = 0x0F,
-    STATE_QUICK_STOP    = 0x07
-};
+// One pass over the slaves, runs on the port owner (RT thread slack when the executor is attached)
+static bool diagnose_slaves() {
+    ec_group[currentgroup].docheckstate = FALSE;
+    ec_readstate();
+    for (int slave = 1; slave <= ec_slavecount; slave++) {
+        if (TaskGroups::isCycled(&ecx_context, ec_slave[slave].group) &&
+            (ec_slave[slave].state != EC_STATE_OPERATIONAL)) {
+            ec_group[currentgroup].docheckstate = TRUE;
+            if (ec_slave[slave].state == (EC_STATE_SAFE_OP + EC_STATE_ERROR)) {
+                printf("ERROR: Slave %d is in SAFE_OP + ERROR, attempting ack.\n", slave);
+                ec_slave[slave].state = (EC_STATE_SAFE_OP + EC_STATE_ACK);
+                ec_writestate(slave);
+            } else if (ec_slave[slave].state == EC_STATE_SAFE_OP) {
+                printf("WARNING: Slave %d is in SAFE_OP, changing to OPERATIONAL.\n", slave);
+                ec_slave[slave].state = EC_STATE_OPERATIONAL;
+                ec_writestate(slave);
+            } else if (ec_slave[slave].state > EC_STATE_NONE) {
+                // Avoid reconfiguring slaves during shutdown
+                if (sharedData.isRunning.load() && ec_reconfig_slave(slave, EC_TIMEOUTMON)) {
+                    ec_slave[slave].islost = FALSE;
+                    printf("MESSAGE: Slave %d reconfigured\n", slave);
+                }
+            } else if (!ec_slave[slave].islost) {
+                ec_statecheck(slave, EC_STATE_OPERATIONAL, EC_TIMEOUTRET);
+                if (!ec_slave[slave].state) {
+                    ec_slave[slave].islost = TRUE;
+                    printf("ERROR: Slave %d lost\n", slave);
+                }
+            }
+        }
+        if (ec_slave[slave].islost) {
+            if (!ec_slave[slave].state) {
+                if (ec_recover_slave(slave, EC_TIMEOUTMON)) {
+                    ec_slave[slave].islost = FALSE;
+                    printf("MESSAGE: Slave %d recovered\n", slave);
+                }
+            } else {
+                ec_slave[slave].islost = FALSE;
+                printf("MESSAGE: Slave %d found\n", slave);
+            }
+        }
+    }
+    return true;
+}
 
 /* 
  * EtherCAT check thread function
- * This function monitors the state of the EtherCAT slaves and attempts to recover 
- * any slaves that are not in the operational state.
+ * This function sleeps until the RT thread reports a bad working counter or AL status,
+ * then checks the slaves one by one and attempts to recover any slaves that are not
+ * in the operational state.
  */
 OSAL_THREAD_FUNC ecatcheck(void *ptr) {
-    int slave; // Variable to hold the current slave index
     (void)ptr; // Not used
     int consecutive_errors = 0;
     const int MAX_CONSECUTIVE_ERRORS = 5;
 
     printf("EtherCAT check thread started\n");
+    ecx_setwaitmode(EC_WAIT_POLL);
 
     while (sharedData.isRunning.load()) {
-        if (inOP && ((wkc < expectedWKC) || ec_group[currentgroup].docheckstate)) {
+        // Sleep until the RT thread sees a bad working counter or AL status
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+        sem_timedwait(&supervision_sem, &deadline);
+        if (!sharedData.isRunning.load()) break;
+        report_ring_state();
+        report_drive_events();
+        if (!supervision_alarm.load()) continue;
+        ec_group[currentgroup].docheckstate = TRUE;
+
+        while (sharedData.isRunning.load() && inOP &&
+               ((wkc < expectedWKC) || ec_group[currentgroup].docheckstate)) {
             if (needlf) {
                 needlf = FALSE;
                 printf("\n");
@@ -365,51 +727,15 @@ OSAL_THREAD_FUNC ecatcheck(void *ptr) {
                 consecutive_errors = 0;
             }
 
-            ec_group[currentgroup].docheckstate = FALSE;
-            ec_readstate();
-            for (slave = 1; slave <= ec_slavecount; slave++) {
-                if ((ec_slave[slave].group == currentgroup) && (ec_slave[slave].state != EC_STATE_OPERATIONAL)) {
-                    ec_group[currentgroup].docheckstate = TRUE;
-                    if (ec_slave[slave].state == (EC_STATE_SAFE_OP + EC_STATE_ERROR)) {
-                        printf("ERROR: Slave %d is in SAFE_OP + ERROR, attempting ack.\n", slave);
-                        ec_slave[slave].state = (EC_STATE_SAFE_OP + EC_STATE_ACK);
-                        ec_writestate(slave);
-                    } else if (ec_slave[slave].state == EC_STATE_SAFE_OP) {
-                        printf("WARNING: Slave %d is in SAFE_OP, changing to OPERATIONAL.\n", slave);
-                        ec_slave[slave].state = EC_STATE_OPERATIONAL;
-                        ec_writestate(slave);
-                    } else if (ec_slave[slave].state > EC_STATE_NONE) {
-                        // Avoid reconfiguring slaves during shutdown
-                        if (sharedData.isRunning.load() && ec_reconfig_slave(slave, EC_TIMEOUTMON)) {
-                            ec_slave[slave].islost = FALSE;
-                            printf("MESSAGE: Slave %d reconfigured\n", slave);
-                        }
-                    } else if (!ec_slave[slave].islost) {
-                        ec_statecheck(slave, EC_STATE_OPERATIONAL, EC_TIMEOUTRET);
-                        if (!ec_slave[slave].state) {
-                            ec_slave[slave].islost = TRUE;
-                            printf("ERROR: Slave %d lost\n", slave);
-                        }
-                    }
-                }
-                if (ec_slave[slave].islost) {
-                    if (!ec_slave[slave].state) {
-                        if (ec_recover_slave(slave, EC_TIMEOUTMON)) {
-                            ec_slave[slave].islost = FALSE;
-                            printf("MESSAGE: Slave %d recovered\n", slave);
-                        }
-                    } else {
-                        ec_slave[slave].islost = FALSE;
-                        printf("MESSAGE: Slave %d found\n", slave);
-                    }
-                }
-            }
+            MasterExecutor::getInstance().call("state check", MasterExecutor::ALL_SLAVES, diagnose_slaves);
             if (!ec_group[currentgroup].docheckstate) {
                 printf("OK: All slaves resumed OPERATIONAL.\n");
+            } else {
+                osal_usleep(10000); // Give the slaves time before the next diagnosis
             }
         }
-        osal_usleep(10000); // Reduce sleep time to 10ms
-        if (!sharedData.isRunning.load()) break;
+        // Re-armed by the RT thread if the aggregate state is still bad
+        supervision_alarm.store(false);
     }
     
     printf("EtherCAT check thread exiting\n");
@@ -445,6 +771,8 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
     }
 
     printf("EtherCAT real-time thread started\n");
+    // Busy-wait for frames, the cycle cannot afford a scheduler wakeup
+    ecx_setwaitmode(EC_WAIT_SPIN);
 
     struct timespec ts, tleft;
     int64 cycletime = *(int *)ptr * 1000;  // Convert to nanoseconds
@@ -460,25 +788,36 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
     toff = 0;
     dorun = 0;
     
-    // Initialize PDO data
-    rxpdo.controlword = 0x0080;
-    rxpdo.target_velocity = 0;
-    rxpdo.mode_of_operation = 9;  // CSV mode (9)
-    rxpdo.target_position = txpdo.actual_position;
-    rxpdo.target_torque = 0;
-    rxpdo.padding = 0;
+    // Initial setpoints of every axis, a warm start keeps the ones adopted from the drives
+    const int axes = axisState.count();
+    const int lastAxis = axes - 1;  // the UI mirrors the last drive on the line
+    if (!warm_started) {
+        axisState.fill(AxisState::CONTROLWORD, 0x0080);
+        axisState.fill(AxisState::TARGET_VELOCITY, 0);
+        axisState.fill(AxisState::MODE, 9);  // CSV mode (9)
+        axisState.copy(AxisState::TARGET_POSITION, AxisState::ACTUAL_POSITION);
+        axisState.fill(AxisState::TARGET_TORQUE, 0);
+        if (axes > 0) {
+            axisState.toRx(lastAxis, rxpdo);
+            rxpdo.padding = 0;
+        }
+    }
 
     // Send initial data
-    for (int slave = 1; slave <= ec_slavecount; slave++) {
-        memcpy(ec_slave[slave].outputs, &rxpdo, sizeof(PDOManager::RxPDO));
-    }
-    ec_send_processdata();
-    wkc = ec_receive_processdata(EC_TIMEOUTRET);  // Ensure first communication succeeds
+    axisState.pack();
+    expectedWKC = TaskGroups::send(&ecx_context, 0);
+    wkc = TaskGroups::receive(&ecx_context, EC_TIMEOUTRET);  // Ensure first communication succeeds
 
     int step = 0;
     int retry_count = 0;
+    int32_t pp_target = 0;  // last PP target handed to the drives
     const int MAX_RETRY = 3;
 
+    // From here on this thread is the only one on the port, a quarter of the cycle goes to queued jobs
+    MasterExecutor& executor = MasterExecutor::getInstance();
+    executor.attach(*(int *)ptr / 4);
+    RingMonitor& ring = EtherCATManager::getInstance().getRingMonitor();
+
     while (sharedData.isRunning.load()) {
         // Wait for the next cycle
         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
@@ -493,169 +832,124 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
 
         dorun++;
 
+        if (start_ecatthread_thread && (rt_hold.load() || rt_held.load())) {
+            if (rt_hold.load()) {
+                if (!rt_held.load()) {
+                    // Collect what is still out, then leave the port to the main thread
+                    TaskGroups::receive(&ecx_context, EC_TIMEOUTRET);
+                    rt_held.store(true);
+                }
+                continue;
+            }
+            // Resume: nothing is out, the image may have moved
+            axisState.pack();
+            expectedWKC = TaskGroups::send(&ecx_context, (uint32_t)dorun);
+            rt_held.store(false);
+            continue;
+        }
+
         if (start_ecatthread_thread) {
-            // Receive process data
-            wkc = ec_receive_processdata(EC_TIMEOUTRET);
+            // Receive process data of every group sent last cycle
+            wkc = TaskGroups::receive(&ecx_context, EC_TIMEOUTRET);
+            ring.record(ec_group[currentgroup].rxpath, wkc >= expectedWKC);
+            if (inOP && (wkc < expectedWKC || !line_state_ok()) && !supervision_alarm.exchange(true)) {
+                sem_post(&supervision_sem);
+            }
 
             if (wkc >= expectedWKC) {
                 retry_count = 0;
                 
-                for (int slave = 1; slave <= ec_slavecount; slave++) {
-                    memcpy(&txpdo, ec_slave[slave].inputs, sizeof(PDOManager::TxPDO));
+                // Control works on the per-axis arrays, txpdo/rxpdo only mirror the last drive for the UI
+                axisState.unpack();
+                const int32_t* actualPosition = axisState.tx(AxisState::ACTUAL_POSITION);
+                const int32_t* actualVelocity = axisState.tx(AxisState::ACTUAL_VELOCITY);
+                if (axes > 0) {
+                    axisState.toTx(lastAxis, txpdo);
                 }
 
                 // Get current status
                 uint16_t status = txpdo.statusword & 0x6F;  // Mask non-status bits
                 
-                // Handle mode switch request (only in non-enabled state)
-                if (sharedData.modeChangeRequested.load() && !sharedData.motorEnabled.load()) {
-                    static int mode_change_timeout = 0;
-                    // Immediately update PDO operation mode
-                    rxpdo.mode_of_operation = sharedData.operationMode.load();
-                    
-                    // Wait for slave to confirm mode switch
-                    if (txpdo.mode_of_operation_display == rxpdo.mode_of_operation) {
-                        sharedData.modeChangeRequested.store(false);
-                        sharedData.modeConfirmed.store(true);
-                        mode_change_timeout = 0;
-                        printf("Operation mode changed and confirmed to %d\n", rxpdo.mode_of_operation);
-                    } else {
-                        // Add timeout detection
-                        if (++mode_change_timeout > 1000) { // About 5-second timeout (assuming 5ms cycle)
-                            printf("Mode change timeout! Requested: %d, Current: %d\n", 
-                                   rxpdo.mode_of_operation, txpdo.mode_of_operation_display);
-                            sharedData.modeChangeRequested.store(false);
-                            mode_change_timeout = 0;
-                        }
-                    }
+                // Mode change transaction pending (only in non-enabled state), confirmed per axis below
+                if (sharedData.modeChange.isPending() && !sharedData.motorEnabled.load()) {
+                    axisState.fill(AxisState::MODE, sharedData.modeChange.mode());
                     
-                    // Maintain safe state during mode switch
-                    rxpdo.target_velocity = 0;
-                    rxpdo.target_position = txpdo.actual_position;
-                    rxpdo.target_torque = 0;
-                    rxpdo.controlword = 0x0006;  // Keep Ready To Switch On state
+                    // Maintain safe state during mode switch, every axis holds where it is
+                    axisState.fill(AxisState::TARGET_VELOCITY, 0);
+                    axisState.copy(AxisState::TARGET_POSITION, AxisState::ACTUAL_POSITION);
+                    axisState.fill(AxisState::TARGET_TORQUE, 0);
+                    driveFsm.commandAll(Cia402Fsm::READY);  // Keep Ready To Switch On state
                 }
                 // Enable sequence (only after mode confirmation)
                 else if (sharedData.enableRequested.load() && !sharedData.motorEnabled.load()) {
                     if (!sharedData.modeConfirmed.load()) {
                         // Ignore enable request if mode is not confirmed
                         sharedData.enableRequested.store(false);
-                        printf("Cannot enable: Operation mode not confirmed\n");
+                        driveFsm.notify(Cia402Fsm::Event::ENABLE_REFUSED, 0);
+                        sem_post(&supervision_sem);
                     } else {
-                        // Normal enable sequence
-                        switch(status) {
-                            case STATE_FAULT:
-                                rxpdo.controlword = 0x0080;  // Fault reset
-                                printf("Fault state, sending reset command\n");
-                                break;
-                                
-                            case STATE_SWITCH_ON_DISABLED:
-                                rxpdo.controlword = 0x0006;  // Shutdown command
-                                printf("Switch on disabled, sending shutdown command\n");
-                                break;
-                                
-                            case STATE_READY_TO_SWITCH_ON:
-                                rxpdo.controlword = 0x0007;  // Switch on command
-                                printf("Ready to switch on, sending switch on command\n");
-                                break;
-                                
-                            case STATE_SWITCHED_ON:
-                                rxpdo.controlword = 0x000F;  // Enable operation command
-                                printf("Switched on, sending enable operation command\n");
-                                break;
-                                
-                            case STATE_OPERATION_ENABLED:
-                                sharedData.motorEnabled.store(true);
-                                printf("Operation enabled successfully\n");
-                                // Detect motor state change, notify UI
-                                if (!lastMotorEnabled) {
-                                    lastMotorEnabled = true;
-                                    motorStateChanged = true;
-                                }
-                                break;
-                                
-                            default:
-                                rxpdo.controlword = 0x0006;  // Try shutdown command
-                                printf("Unknown state (0x%04x), trying shutdown\n", status);
-                                break;
+                        driveFsm.commandAll(Cia402Fsm::ENABLE);
+                        // Enabled once every drive reported operation enabled in the last step
+                        if (driveFsm.allIn(Cia402Fsm::OPERATION_ENABLED)) {
+                            sharedData.motorEnabled.store(true);
+                            // Detect motor state change, notify UI
+                            if (!lastMotorEnabled) {
+                                lastMotorEnabled = true;
+                                motorStateChanged = true;
+                            }
                         }
                     }
                 }
                 // Disable sequence
                 else if (!sharedData.enableRequested.load()) {
-                     switch(status) {
-                        case STATE_OPERATION_ENABLED:
-                            rxpdo.controlword = 0x0007;  // Switch to Switched On state
-                            printf("Disabling operation, switching to Switched On state\n");
-                            break;
-                            
-                        case STATE_SWITCHED_ON:
-                            rxpdo.controlword = 0x0006;  // Switch to Ready To Switch On state
-                            printf("Switching to Ready To Switch On state\n");
-                            break;
-                            
-                        case STATE_READY_TO_SWITCH_ON:
-                            rxpdo.controlword = 0x0000;  // Switch to Switch On Disabled state
-                            sharedData.motorEnabled.store(false);  // Confirm motor disabled
-                            printf("Motor disabled successfully\n");
-                            // Detect motor state change, notify UI
-                            if (lastMotorEnabled) {
-                                lastMotorEnabled = false;
-                                motorStateChanged = true;
-                            }
-                            break;
-                            
-                        default:
-                            rxpdo.controlword = 0x0000;  // Force Switch On Disabled
-                            sharedData.motorEnabled.store(false);
-                            printf("Unknown state while disabling (0x%04x), forcing disable\n", status);
-                            printf("ecatthread running, isRunning=%d\n", sharedData.isRunning.load());
-                            // Detect motor state change, notify UI
-                            if (lastMotorEnabled) {
-                                lastMotorEnabled = false;
-                                motorStateChanged = true;
-                            }
-                            break;
+                    driveFsm.commandAll(Cia402Fsm::DISABLE);
+                    if (driveFsm.nonePowered()) {
+                        sharedData.motorEnabled.store(false);  // Confirm motor disabled
+                        // Detect motor state change, notify UI
+                        if (lastMotorEnabled) {
+                            lastMotorEnabled = false;
+                            motorStateChanged = true;
+                        }
                     }
                 }
                 // Normal operation state
                 else if (sharedData.motorEnabled.load()) {
-                    rxpdo.controlword = 0x000F;
+                    // A drive that faults while running stays in fault until the user enables again
+                    driveFsm.commandAll(Cia402Fsm::HOLD);
+                    if (!driveFsm.allIn(Cia402Fsm::OPERATION_ENABLED)) {
+                        for (int axis = 0; axis < driveFsm.count(); axis++) {
+                            if (driveFsm.state(axis) != Cia402Fsm::OPERATION_ENABLED) {
+                                driveFsm.notify(Cia402Fsm::Event::ENABLE_LOST, axis);
+                            }
+                        }
+                        sem_post(&supervision_sem);
+                        sharedData.enableRequested.store(false);
+                        sharedData.motorEnabled.store(false);
+                        lastMotorEnabled = false;
+                        motorStateChanged = true;
+                    }
                     
-                    // Set target values based on current mode
-                    switch(rxpdo.mode_of_operation) {
+                    // Set target values based on current mode, all axes run the same mode
+                    switch (axes > 0 ? axisState.rx(AxisState::MODE)[0] : 0) {
                         case 1:  // PP mode
                         {
-                            static bool newPositionSet = false;
-                            static int32_t lastPosition = 0;
+                            // The state machine runs the new setpoint handshake
                             int32_t newPosition = sharedData.targetPosition.load();
-
-                            if (newPosition != lastPosition) {
-                                rxpdo.target_position = newPosition;
-                                lastPosition = newPosition;
-                                newPositionSet = true;
-                                printf("New PP mode target position: %d\n", newPosition);
-
-                                // Set control word to start new position motion
-                                rxpdo.controlword = 0x001F;  // bit4=1 indicates new position
-                            } else if (newPositionSet) {
-                                // Check if target position is reached
-                                if (txpdo.statusword & (1 << 10)) {  // bit10=1 indicates target reached
-                                    newPositionSet = false;
-                                    rxpdo.controlword = 0x000F;  // Clear new position flag
-                                    printf("Target position reached\n");
-                                }
+                            if (newPosition != pp_target) {
+                                axisState.fill(AxisState::TARGET_POSITION, newPosition);
+                                pp_target = newPosition;
+                                driveFsm.newSetpointAll();
                             }
                             break;
                         }
                         case 3:  // PV mode
                             // Directly set target velocity, no additional processing needed
-                            rxpdo.target_velocity = sharedData.targetVelocity.load();
+                            axisState.fill(AxisState::TARGET_VELOCITY, sharedData.targetVelocity.load());
                             break;
                         case 4:  // PT mode
-                            rxpdo.target_position = 0;  // Clear position
-                            rxpdo.target_velocity = 0;  // Clear velocity
-                            rxpdo.target_torque = sharedData.targetTorque.load();  // Set target torque
+                            axisState.fill(AxisState::TARGET_POSITION, 0);  // Clear position
+                            axisState.fill(AxisState::TARGET_VELOCITY, 0);  // Clear velocity
+                            axisState.fill(AxisState::TARGET_TORQUE, sharedData.targetTorque.load());  // Set target torque
                             break;
                         case 8:  // CSP mode
                             if (sharedData.motorEnabled.load()) {
@@ -668,8 +962,9 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
                                     params.max_velocity = sharedData.cspMaxVelocity;
                                     params.acceleration = 10000;
                                     params.deceleration = 10000;
-                                    params.current_position = txpdo.actual_position;
-                                    params.current_velocity = txpdo.actual_velocity;
+                                    // One trajectory for the line, started from the mirrored drive
+                                    params.current_position = actualPosition[lastAxis];
+                                    params.current_velocity = actualVelocity[lastAxis];
                                     
                                     planner.init(params);
                                     motion_initialized = true;
@@ -681,7 +976,7 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
                                 auto state = planner.calculateNextState(500);  // 500us cycle
                                 
                                 // Update target position
-                                rxpdo.target_position = state.position;
+                                axisState.fill(AxisState::TARGET_POSITION, state.position);
                                 
                                 // Check if motion is completed
                                 if (state.is_completed) {
@@ -690,18 +985,18 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
                                 }
                             } else {
                                 //printf("Motion not initialized\n");
-                                rxpdo.target_position = txpdo.actual_position;
+                                axisState.copy(AxisState::TARGET_POSITION, AxisState::ACTUAL_POSITION);
                             }
                             break;
                         case 9:  // CSV mode
-                            rxpdo.target_position = 0;
-                            rxpdo.target_velocity = sharedData.targetVelocity.load();
-                            rxpdo.target_torque = 0;
+                            axisState.fill(AxisState::TARGET_POSITION, 0);
+                            axisState.fill(AxisState::TARGET_VELOCITY, sharedData.targetVelocity.load());
+                            axisState.fill(AxisState::TARGET_TORQUE, 0);
                             break;
                         case 10: // CST mode
-                            rxpdo.target_position = 0;
-                            rxpdo.target_velocity = 0;
-                            rxpdo.target_torque = sharedData.targetTorque.load();
+                            axisState.fill(AxisState::TARGET_POSITION, 0);
+                            axisState.fill(AxisState::TARGET_VELOCITY, 0);
+                            axisState.fill(AxisState::TARGET_TORQUE, sharedData.targetTorque.load());
                             break;
                     }
                 }
@@ -730,15 +1025,21 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
                            (txpdo.statusword & 0x0080) ? "Warning " : "");
                 }
                 
-                // Send data to slaves
-                for (int slave = 1; slave <= ec_slavecount; slave++) {
-                    memcpy(ec_slave[slave].outputs, &rxpdo, sizeof(PDOManager::RxPDO));
+                // Send data to slaves, controlwords come from the state machine
+                if (sharedData.modeChange.step(axisState.tx(AxisState::MODE_DISPLAY)) == ModeChange::COMPLETE) {
+                    sharedData.modeConfirmed.store(true);
+                }
+                if (driveFsm.step(axisState.tx(AxisState::STATUSWORD), axisState.rx(AxisState::CONTROLWORD))) {
+                    sem_post(&supervision_sem);  // The check thread reports the events
+                }
+                axisState.pack();
+                if (axes > 0) {
+                    axisState.toRx(lastAxis, rxpdo);
                 }
-
-                // Send process data
-                ec_send_processdata();
 
             } else {
+                // No valid mode display this cycle, but the deadline still runs
+                sharedData.modeChange.step(nullptr);
                 retry_count++;
                 if (retry_count >= MAX_RETRY) {
                     printf("ERROR: Communication failure after %d retries\n", retry_count);
@@ -751,8 +1052,11 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
                 ec_sync(ec_DCtime, cycletime, &toff);
             }
 
-            // Send process data
-            ec_send_processdata();
+            // Send process data, slow groups only on their cycles
+            expectedWKC = TaskGroups::send(&ecx_context, (uint32_t)dorun);
+
+            // Acyclic jobs while the frame is on the wire
+            executor.runSlack();
         }
 
         // Monitor cycle time
@@ -765,6 +1069,7 @@ OSAL_THREAD_FUNC_RT ecatthread(void *ptr) {
         if (!sharedData.isRunning.load()) break;
     }
     
+    executor.detach();
     printf("EtherCAT real-time thread exiting\n");
     return;
 }
@@ -794,6 +1099,55 @@ int main(int argc, char **argv) {
     pthread_setschedparam(pthread_self(), SCHED_FIFO, &ui_param);
     
     printf("Running UI on CPU core 1\n");
+
+    // PDO layouts and per-slave rules from pdo_layouts.txt, shared by every line
+    PdoLayouts::load();
+
+    // Additional lines of a cell controller: --line <ifname>[@cpu], one per NIC.
+    // They are brought up before the UI so their bring-up never overlaps the default line's
+    LineManager& lineManager = LineManager::getInstance();
+    // --hugepages: back the process images with 2 MB hugepages (needs vm.nr_hugepages)
+    // --layout packed|overlap|aligned: IOmap layout, compare the wire time printed per group
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hugepages") == 0) {
+            PDOManager::processImage().setHugePages(true);
+            lineManager.setHugePages(true);
+        } else if (strcmp(argv[i], "--layout") == 0 && i + 1 < argc) {
+            TaskGroups::Layout layout;
+            if (TaskGroups::parseLayout(argv[++i], layout)) {
+                PDOManager::processImage().setLayout(layout);
+                lineManager.setLayout(layout);
+            } else {
+                printf("Unknown IOmap layout '%s', using packed\n", argv[i]);
+            }
+        } else if (strcmp(argv[i], "--frozen-frames") == 0) {
+            frozen_frames = true;
+        } else if (strcmp(argv[i], "--bench-axes") == 0) {
+            // Time the axis state pack/unpack kernels for 1..200 drives and exit
+            AxisState::benchmark();
+            return 0;
+        } else if (strcmp(argv[i], "--bench-fsm") == 0) {
+            // Time one CiA402 state machine step for 1..200 drives and exit
+            Cia402Fsm::benchmark();
+            return 0;
+        } else if (strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+            // Directory of the PDO mapping cache and warm start file, default is next to the executable
+            PDOManager::setCacheDirectory(argv[++i]);
+        } else if (strcmp(argv[i], "--pdo-profile") == 0 && i + 1 < argc) {
+            // full|csp|csv|cst or a layout from pdo_layouts.txt: what drives without a rule get
+            if (!PdoLayouts::setDefault(argv[++i])) {
+                printf("Unknown PDO layout '%s', using full\n", argv[i]);
+            }
+        }
+    }
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--line") == 0) {
+            lineManager.addLine(argv[++i]);
+        }
+    }
+    if (lineManager.size() > 0 && !lineManager.startAll(ctime_thread)) {
+        printf("Warning: not all additional EtherCAT lines are running\n");
+    }
     
     // Create UI window
     MonitorWindow* window = new MonitorWindow(sharedData);
@@ -826,6 +1180,7 @@ int main(int argc, char **argv) {
     // Wait for check thread to stop
     if (thread2 != 0) {
         void* thread_result;
+        sem_post(&supervision_sem);
         int join_result = pthread_join(thread2, &thread_result);
         if (join_result == 0) {
             printf("EtherCAT check thread stopped\n");
@@ -845,6 +1200,7 @@ int main(int argc, char **argv) {
         }
     }
     
+    lineManager.stopAll();
     delete window;
 
     printf("Program exited cleanly\n");
@@ -138,6 +138,13 @@ ComponentManager::NetworkComponents* ComponentManager::createNetworkComponents(Q
         
         interfaceLayout->addWidget(label);
         interfaceLayout->addWidget(networkComps->selector, 1);
+
+        QHBoxLayout* secondaryLayout = new QHBoxLayout();
+        QLabel* secondaryLabel = new QLabel("Redundant port:", parent);
+        networkComps->secondarySelector = new QComboBox(parent);
+        networkComps->secondarySelector->setMinimumWidth(200);
+        secondaryLayout->addWidget(secondaryLabel);
+        secondaryLayout->addWidget(networkComps->secondarySelector, 1);
         
         QHBoxLayout* buttonLayout = new QHBoxLayout();
         networkComps->refreshBtn = new QPushButton("Refresh interface", parent);
@@ -145,6 +152,7 @@ ComponentManager::NetworkComponents* ComponentManager::createNetworkComponents(Q
         
         // Set tooltips
         networkComps->selector->setToolTip("Select the network interface to use for EtherCAT communication");
+        networkComps->secondarySelector->setToolTip("Interface connected to the end of the line to close it into a redundant ring");
         networkComps->refreshBtn->setToolTip("Refresh available network interface list");
         networkComps->confirmBtn->setToolTip("Confirm and connect to the selected network interface");
         
@@ -154,6 +162,7 @@ ComponentManager::NetworkComponents* ComponentManager::createNetworkComponents(Q
         
         // Add to layout
         groupLayout->addLayout(interfaceLayout);
+        groupLayout->addLayout(secondaryLayout);
         groupLayout->addLayout(buttonLayout);
         
         networkComps->layout = groupLayout;
@@ -602,6 +611,7 @@ ComponentManager::TargetComponents* ComponentManager::createTargetComponents(QWi
 void ComponentManager::updateNetworkStatus(bool enabled) {
     if (networkComps) {
         networkComps->selector->setEnabled(enabled);
+        networkComps->secondarySelector->setEnabled(enabled);
         networkComps->refreshBtn->setEnabled(enabled);
         networkComps->confirmBtn->setEnabled(enabled);
     }
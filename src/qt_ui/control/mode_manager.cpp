@@ -78,7 +78,10 @@ void ModeManager::switchToMode(int mode) {
     // Implementation of switching to specified mode
     mainWindow->appendLog(QString("Switching to mode: %1").arg(mode), LogLevel::INFO);
     sharedData.operationMode.store(mode);
-    sharedData.modeChangeRequested.store(true);
+    if (!sharedData.modeChange.begin(mode, MODE_CHANGE_TIMEOUT_MS)) {
+        mainWindow->appendLog("A mode change is still in progress", LogLevel::WARNING);
+        return;
+    }
     mainWindow->appendLog(QString("Mode switch request sent: %1").arg(mode), LogLevel::SUCCESS);
 }
 
@@ -1,6 +1,5 @@
 #include "monitor_window_events.h"
 #include <QMouseEvent>
-#include <QThread>
 #include <QTimer>
 #include <QGuiApplication>
 #include <QScreen>
@@ -38,6 +37,10 @@ MonitorWindowEvents::MonitorWindowEvents(QMainWindow* window,
       logDisplay(logDisplay), lockViewCheckBox(lockViewCheckBox),
       autoYRangeCheckBox(autoYRangeCheckBox), resetViewBtn(resetViewBtn),
       startTime(startTime) {
+    // The mode change runs in the RT thread, the UI only polls for its end
+    modeChangeTimer = new QTimer(this);
+    modeChangeTimer->setInterval(MODE_CHANGE_POLL_MS);
+    connect(modeChangeTimer, &QTimer::timeout, this, &MonitorWindowEvents::pollModeChange);
 }
 
 void MonitorWindowEvents::connectAllSignals() {
@@ -61,6 +64,7 @@ void MonitorWindowEvents::connectAllSignals() {
     connect(ptComps->confirmBtn, &QPushButton::clicked, this, &MonitorWindowEvents::onPTParamsConfirmed);
     connect(cstComps->confirmBtn, &QPushButton::clicked, this, &MonitorWindowEvents::onCSTParamsConfirmed);
     connect(cspComps->confirmBtn, &QPushButton::clicked, this, &MonitorWindowEvents::onCSPParamsConfirmed);
+    connect(this, &MonitorWindowEvents::modeChangeFinished, this, &MonitorWindowEvents::onModeChangeFinished);
     
     // 网络相关
     connect(networkComps->selector, QOverload<int>::of(&QComboBox::currentIndexChanged),
@@ -241,7 +245,7 @@ void MonitorWindowEvents::onModeChanged(int index) {
     
     // 重置所有模式相关状态
     sharedData.modeConfirmed.store(false);
-    sharedData.modeChangeRequested.store(false);
+    sharedData.modeChange.cancel();
     sharedData.ppParamsConfirmed.store(false);
     sharedData.pvParamsConfirmed.store(false);
     sharedData.ptParamsConfirmed.store(false);
@@ -271,10 +275,13 @@ void MonitorWindowEvents::onModeChanged(int index) {
 void MonitorWindowEvents::onModeConfirmClicked() {
     if (!sharedData.motorEnabled.load()) {
         int mode = modeComps->selector->currentData().toInt();
+        // The EtherCAT side first remaps the drives to a profile carrying the mode's setpoint
+        bool remap = !PDOManager::supportsMode((uint8_t)mode);
+        modeChangeTimeoutMs = remap ? MODE_CHANGE_REMAP_TIMEOUT_MS : MODE_CHANGE_TIMEOUT_MS;
         
         // 重置所有相关状态
         sharedData.modeConfirmed.store(false);
-        sharedData.modeChangeRequested.store(false);
+        sharedData.modeChange.cancel();
         sharedData.ppParamsConfirmed.store(false);
         sharedData.pvParamsConfirmed.store(false);
         sharedData.ptParamsConfirmed.store(false);
@@ -286,63 +293,99 @@ void MonitorWindowEvents::onModeConfirmClicked() {
         sharedData.targetVelocity.store(0);
         sharedData.targetTorque.store(0);
         
-        // 通过PDO设置操作模式
+        // 通过PDO设置操作模式, RT线程逐轴确认 0x6061
         sharedData.operationMode.store(mode);
-        sharedData.modeChangeRequested.store(true);
+        if (!sharedData.modeChange.begin(mode, modeChangeTimeoutMs)) {
+            appendLog("A mode change is still in progress", LogLevel::WARNING);
+            return;
+        }
         
+        if (remap) {
+            appendLog(QString("Remapping the drive PDOs to the %1 profile for mode %2")
+                          .arg(PDOManager::profileForMode((uint8_t)mode)).arg(mode));
+        }
         appendLog(QString("Setting all slave operation mode: %1").arg(mode));
         
-        // 等待所有从站切换模式
-        int timeout = 50; // 5秒超时
-        bool allModesChanged = false;
+        // 等待期间禁止再次切换, 结果由 modeChangeFinished 通知
+        modeComps->selector->setEnabled(false);
+        modeComps->confirmBtn->setEnabled(false);
+        modeChangeStarted.start();
+        modeChangeTimer->start();
+    } else {
+        QMessageBox::warning(window, "Warning", "Please disable motor first!");
+    }
+}
+
+void MonitorWindowEvents::pollModeChange() {
+    if (sharedData.modeChange.isPending()) {
+        if (modeChangeStarted.elapsed() < modeChangeTimeoutMs + MODE_CHANGE_GRACE_MS) {
+            return;
+        }
+        // RT thread stalled or gone, give up on our side; an outcome it stored first still wins
+        sharedData.modeChange.cancel();
+    }
+    modeChangeTimer->stop();
+    ModeChange::Status status = sharedData.modeChange.status();
+    if (status == ModeChange::COMPLETE || status == ModeChange::TIMED_OUT) {
+        emit modeChangeFinished(status == ModeChange::COMPLETE);
+    } else if (status == ModeChange::FAILED && sharedData.lineStopped.load()) {
+        // Nothing runs any more, only a restart brings the line back
+        appendLog("EtherCAT line stopped: the drives could not be brought back to OP after the PDO remap, "
+                  "restart the application", LogLevel::ERROR);
+        sharedData.modeConfirmed.store(false);
+        controlComps->enableBtn->setEnabled(false);
+        modeComps->selector->setEnabled(false);
+        modeComps->confirmBtn->setEnabled(false);
+    } else if (status == ModeChange::FAILED ||
+               modeChangeStarted.elapsed() >= modeChangeTimeoutMs + MODE_CHANGE_GRACE_MS) {
+        appendLog(status == ModeChange::FAILED ? "Mode change failed: the drive PDOs could not be remapped"
+                                               : "Mode change not answered by the EtherCAT thread, cancelled",
+                  LogLevel::WARNING);
+        sharedData.modeConfirmed.store(false);
+        modeComps->selector->setEnabled(true);
+        modeComps->confirmBtn->setEnabled(true);
+    }
+    // Otherwise cancelled by a new selection, nothing to report
+}
+
+void MonitorWindowEvents::onModeChangeFinished(bool complete) {
+    int mode = sharedData.modeChange.mode();
+    const ModeChange& change = sharedData.modeChange;
+    
+    if (complete) {
+        sharedData.modeConfirmed.store(true);
+        
+        // 更新界面
+        updateModePanel(mode);
+        QString modeName = modeComps->selector->currentText();
+        QString status = QString("All slaves switched to %1 (Mode: %2) in %3 cycles")
+                             .arg(modeName).arg(mode).arg(change.cycles());
+        updateStatusBar(status, 2000);
+        appendLog(status);
         
-        while (timeout > 0 && !allModesChanged) {
-            allModesChanged = true;
-            // 检查所有从站的模式
-            for (int slave = 1; slave <= ec_slavecount; slave++) {
-                if (txpdo.mode_of_operation_display != mode) {
-                    allModesChanged = false;
-                    break;
-                }
-            }
-            
-            if (allModesChanged) {
-                break;
+        // 启用控制按钮
+        controlComps->enableBtn->setEnabled(true);
+        controlComps->enableBtn->setCheckable(true);
+        modeComps->confirmBtn->setEnabled(false);
+        modeComps->selector->setEnabled(false);
+    } else {
+        // 逐轴报告未确认的从站
+        for (const ModeChange::AxisResult& axis : change.results()) {
+            if (!axis.confirmed) {
+                appendLog(QString("Slave %1 still reports mode %2").arg(axis.slave).arg(axis.display),
+                          LogLevel::WARNING);
             }
-            QThread::msleep(100);
-            timeout--;
         }
+        QString error = "Mode switching timeout for some or all slaves";
+        appendLog("Error: " + error);
+        QMessageBox::warning(window, "Error", error);
         
-        if (allModesChanged) {
-            sharedData.modeConfirmed.store(true);
-            
-            // 更新界面
-            updateModePanel(mode);
-            QString modeName = modeComps->selector->currentText();
-            QString status = QString("All slaves switched to %1 (Mode: %2)").arg(modeName).arg(mode);
-            updateStatusBar(status, 2000);
-            appendLog(status);
-            
-            // 启用控制按钮
-            controlComps->enableBtn->setEnabled(true);
-            controlComps->enableBtn->setCheckable(true);
-            modeComps->confirmBtn->setEnabled(false);
-            modeComps->selector->setEnabled(false);
-        } else {
-            QString error = "Mode switching timeout for some or all slaves";
-            appendLog("Error: " + error);
-            QMessageBox::warning(window, "Error", error);
-            
-            // 重置状态
-            sharedData.modeChangeRequested.store(false);
-            sharedData.modeConfirmed.store(false);
-            
-            // 重新启用模式选择和确认按钮
-            modeComps->selector->setEnabled(true);
-            modeComps->confirmBtn->setEnabled(true);
-        }
-    } else {
-        QMessageBox::warning(window, "Warning", "Please disable motor first!");
+        // 重置状态
+        sharedData.modeConfirmed.store(false);
+        
+        // 重新启用模式选择和确认按钮
+        modeComps->selector->setEnabled(true);
+        modeComps->confirmBtn->setEnabled(true);
     }
 }
 
@@ -567,14 +610,24 @@ void MonitorWindowEvents::onRefreshNetwork() {
 void MonitorWindowEvents::onConfirmNetwork() {
     QString selectedInterface = networkComps->selector->currentData().toString();
     appendLog(QString("User confirmed network interface: %1").arg(selectedInterface), LogLevel::INFO);
+    QString secondaryInterface = networkComps->secondarySelector->currentData().toString();
+    if (secondaryInterface == selectedInterface) {
+        QMessageBox::warning(window, "Warning", "The redundant port must be a different interface!");
+        return;
+    }
+    if (!secondaryInterface.isEmpty()) {
+        appendLog(QString("Cable redundancy: ring closed through %1").arg(secondaryInterface), LogLevel::INFO);
+    }
     
     // 禁用网络相关控件
     networkComps->selector->setEnabled(false);
+    networkComps->secondarySelector->setEnabled(false);
     networkComps->refreshBtn->setEnabled(false);
     networkComps->confirmBtn->setEnabled(false);
     
     // 发送信号初始化EtherCAT线程
     sharedData.selectedInterface = selectedInterface.toStdString();
+    sharedData.secondaryInterface = secondaryInterface.toStdString();
     sharedData.interfaceConfirmed.store(true);
     
     appendLog(QString("Scanning slaves on network interface %1...").arg(selectedInterface), LogLevel::INFO);
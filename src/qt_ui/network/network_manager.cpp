@@ -12,6 +12,8 @@ NetworkManager::NetworkManager(MonitorWindow* parent, ComponentManager::NetworkC
 void NetworkManager::refreshNetworkInterfaces() {
     mainWindow->appendLog("Refreshing network interface list...", LogLevel::INFO);
     networkComps->selector->clear();
+    networkComps->secondarySelector->clear();
+    networkComps->secondarySelector->addItem("None (no redundancy)", QString());
     
     // Get all network interfaces in the system
     QList<QNetworkInterface> interfaces = QNetworkInterface::allInterfaces();
@@ -29,6 +31,7 @@ void NetworkManager::refreshNetworkInterfaces() {
             QString displayText = QString("%1 (%2)").arg(name).arg(description);
             
             networkComps->selector->addItem(displayText, name);
+            networkComps->secondarySelector->addItem(displayText, name);
             found = true;
             interfaceCount++;
             mainWindow->appendLog(QString("Found network interface: %1 (%2)").arg(name).arg(description), LogLevel::SUCCESS);
@@ -86,12 +89,23 @@ void NetworkManager::confirmNetworkInterface(const QString& interfaceName) {
     mainWindow->appendLog(QString("Confirming network interface: %1").arg(interfaceName), LogLevel::INFO);
     
     // Disable network-related controls
+    QString secondary = networkComps->secondarySelector->currentData().toString();
+    if (secondary == interfaceName) {
+        mainWindow->appendLog("Error: The redundant port must be a different interface", LogLevel::ERROR);
+        return;
+    }
+    if (!secondary.isEmpty()) {
+        mainWindow->appendLog(QString("Cable redundancy: ring closed through %1").arg(secondary), LogLevel::INFO);
+    }
+
     networkComps->selector->setEnabled(false);
+    networkComps->secondarySelector->setEnabled(false);
     networkComps->refreshBtn->setEnabled(false);
     networkComps->confirmBtn->setEnabled(false);
     
     // Send signal to initialize EtherCAT thread
     sharedData.selectedInterface = interfaceName.toStdString();
+    sharedData.secondaryInterface = secondary.toStdString();
     sharedData.interfaceConfirmed.store(true);
     
     mainWindow->appendLog(QString("Scanning slaves on network interface %1...").arg(interfaceName), LogLevel::INFO);
@@ -13,6 +13,7 @@ extern "C"
 
 #include "osal_defs.h"
 #include <stdint.h>
+#include <stddef.h>
 
 /* General types */
 #ifndef TRUE
@@ -51,6 +52,8 @@ ec_timet osal_current_time(void);
 void osal_time_diff(ec_timet *start, ec_timet *end, ec_timet *diff);
 int osal_thread_create(void *thandle, int stacksize, void *func, void *param);
 int osal_thread_create_rt(void *thandle, int stacksize, void *func, void *param);
+void *osal_malloc(size_t size);
+void osal_free(void *ptr);
 
 #ifdef __cplusplus
 }
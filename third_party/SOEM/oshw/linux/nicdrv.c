@@ -30,6 +30,7 @@
  * This layer if fully transparent for the higher layers.
  */
 
+#define _GNU_SOURCE
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
@@ -42,6 +43,7 @@
 #include <fcntl.h>
 #include <string.h>
 #include <netpacket/packet.h>
+#include <poll.h>
 #include <pthread.h>
 
 #include "oshw.h"
@@ -72,6 +74,15 @@ const uint16 secMAC[3] = { 0x0404, 0x0404, 0x0404 };
 /** second MAC word is used for identification */
 #define RX_SEC secMAC[1]
 
+/** longest single ppoll sleep in us. Bounds the extra latency when another
+ * thread pulled our frame off the socket and stored it in the rx buffers */
+#define EC_POLLSLICE  100
+
+/** wait strategy of the calling thread */
+static __thread int ec_waitmode = EC_WAIT_SPIN;
+static boolean ec_waitstatsenabled = FALSE;
+static ec_waitstatt ec_waitstats[EC_WAIT_MODES];
+
 static void ecx_clear_rxbufstat(int *rxbufstat)
 {
    int i;
@@ -126,7 +137,6 @@ int ecx_setupnic(ecx_portt *port, const char *ifname, int secondary)
    {
       pthread_mutexattr_init(&mutexattr);
       pthread_mutexattr_setprotocol(&mutexattr  , PTHREAD_PRIO_INHERIT);
-      pthread_mutex_init(&(port->getindex_mutex), &mutexattr);
       pthread_mutex_init(&(port->tx_mutex)      , &mutexattr);
       pthread_mutex_init(&(port->rx_mutex)      , &mutexattr);
       port->sockhandle        = -1;
@@ -212,6 +222,9 @@ void ec_setupheader(void *p)
 }
 
 /** Get new frame identifier index and allocate corresponding rx buffer.
+ * Lock free, a buffer is claimed by swapping its status from empty to
+ * allocated, so a real-time caller never waits for a lower priority thread
+ * that is allocating at the same time.
  * @param[in] port        = port context struct
  * @return new index.
  */
@@ -219,19 +232,24 @@ uint8 ecx_getindex(ecx_portt *port)
 {
    uint8 idx;
    uint8 cnt;
+   int expected;
 
-   pthread_mutex_lock( &(port->getindex_mutex) );
-
-   idx = port->lastidx + 1;
+   idx = __atomic_load_n(&(port->lastidx), __ATOMIC_RELAXED) + 1;
    /* index can't be larger than buffer array */
    if (idx >= EC_MAXBUF)
    {
       idx = 0;
    }
    cnt = 0;
-   /* try to find unused index */
-   while ((port->rxbufstat[idx] != EC_BUF_EMPTY) && (cnt < EC_MAXBUF))
+   /* try to claim unused index */
+   while (cnt < EC_MAXBUF)
    {
+      expected = EC_BUF_EMPTY;
+      if (__atomic_compare_exchange_n(&(port->rxbufstat[idx]), &expected, EC_BUF_ALLOC,
+                                      FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      {
+         break;
+      }
       idx++;
       cnt++;
       if (idx >= EC_MAXBUF)
@@ -239,12 +257,18 @@ uint8 ecx_getindex(ecx_portt *port)
          idx = 0;
       }
    }
-   port->rxbufstat[idx] = EC_BUF_ALLOC;
+   /* all buffers busy, reuse as before but never a frozen process data frame */
+   if (cnt >= EC_MAXBUF)
+   {
+      for (cnt = 0; (cnt < EC_MAXBUF) && (port->rxbufstat[idx] == EC_BUF_FROZEN); cnt++)
+      {
+         idx = (idx + 1 < EC_MAXBUF) ? idx + 1 : 0;
+      }
+      __atomic_store_n(&(port->rxbufstat[idx]), EC_BUF_ALLOC, __ATOMIC_RELAXED);
+   }
    if (port->redstate != ECT_RED_NONE)
       port->redport->rxbufstat[idx] = EC_BUF_ALLOC;
-   port->lastidx = idx;
-
-   pthread_mutex_unlock( &(port->getindex_mutex) );
+   __atomic_store_n(&(port->lastidx), idx, __ATOMIC_RELAXED);
 
    return idx;
 }
@@ -256,7 +280,8 @@ uint8 ecx_getindex(ecx_portt *port)
  */
 void ecx_setbufstat(ecx_portt *port, uint8 idx, int bufstat)
 {
-   port->rxbufstat[idx] = bufstat;
+   /* release, pairs with the claim in ecx_getindex */
+   __atomic_store_n(&(port->rxbufstat[idx]), bufstat, __ATOMIC_RELEASE);
    if (port->redstate != ECT_RED_NONE)
       port->redport->rxbufstat[idx] = bufstat;
 }
@@ -452,6 +477,67 @@ int ecx_inframe(ecx_portt *port, uint8 idx, int stacknumber)
    return rval;
 }
 
+/** Sleep until a socket of the port is readable, at most until the timer
+ * expires and never longer than EC_POLLSLICE.
+ * @param[in] port        = port context struct
+ * @param[in] timer       = absolute timeout time
+ */
+static void ecx_pollsockets(ecx_portt *port, osal_timert *timer)
+{
+   struct pollfd fds[2];
+   struct timespec now, slice;
+   int64 leftns;
+   nfds_t n = 1;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   leftns = ((int64)timer->stop_time.sec - now.tv_sec) * 1000000000LL +
+            ((int64)timer->stop_time.usec * 1000 - now.tv_nsec);
+   if (leftns <= 0)
+   {
+      return;
+   }
+   if (leftns > EC_POLLSLICE * 1000LL)
+   {
+      leftns = EC_POLLSLICE * 1000LL;
+   }
+   slice.tv_sec = 0;
+   slice.tv_nsec = (long)leftns;
+   fds[0].fd = port->sockhandle;
+   fds[0].events = POLLIN;
+   if (port->redstate != ECT_RED_NONE)
+   {
+      fds[1].fd = port->redport->sockhandle;
+      fds[1].events = POLLIN;
+      n = 2;
+   }
+   ppoll(fds, n, &slice, NULL);
+}
+
+static uint64 ecx_clockns(clockid_t clock)
+{
+   struct timespec ts;
+
+   clock_gettime(clock, &ts);
+   return (uint64)ts.tv_sec * 1000000000ULL + (uint64)ts.tv_nsec;
+}
+
+/** Add one frame wait to the statistics of the calling thread's strategy. */
+static void ecx_addwaitstat(uint64 waitns, uint64 cpuns, boolean received)
+{
+   ec_waitstatt *st = &ec_waitstats[ec_waitmode];
+   uint64 max;
+
+   __atomic_fetch_add(received ? &st->frames : &st->timeouts, 1, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&st->waitns, waitns, __ATOMIC_RELAXED);
+   __atomic_fetch_add(&st->cpuns, cpuns, __ATOMIC_RELAXED);
+   max = __atomic_load_n(&st->maxns, __ATOMIC_RELAXED);
+   while (received && (waitns > max) &&
+          !__atomic_compare_exchange_n(&st->maxns, &max, waitns, FALSE,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+   {
+   }
+}
+
 /** Blocking redundant receive frame function. If redundant mode is not active then
  * it skips the secondary stack and redundancy functions. In redundant mode it waits
  * for both (primary and secondary) frames to come in. The result goes in an decision
@@ -470,7 +556,15 @@ static int ecx_waitinframe_red(ecx_portt *port, uint8 idx, osal_timert *timer)
    int wkc  = EC_NOFRAME;
    int wkc2 = EC_NOFRAME;
    int primrx, secrx;
+   int path = EC_RXPATH_OK;
+
+   uint64 startns = 0, startcpu = 0;
 
+   if (ec_waitstatsenabled)
+   {
+      startns = ecx_clockns(CLOCK_MONOTONIC);
+      startcpu = ecx_clockns(CLOCK_THREAD_CPUTIME_ID);
+   }
    /* if not in redundant mode then always assume secondary is OK */
    if (port->redstate == ECT_RED_NONE)
       wkc2 = 0;
@@ -486,8 +580,18 @@ static int ecx_waitinframe_red(ecx_portt *port, uint8 idx, osal_timert *timer)
          if (wkc2 <= EC_NOFRAME)
             wkc2 = ecx_inframe(port, idx, 1);
       }
+      /* sleep instead of spinning if this thread asked for it */
+      if ((ec_waitmode == EC_WAIT_POLL) && ((wkc <= EC_NOFRAME) || (wkc2 <= EC_NOFRAME)))
+      {
+         ecx_pollsockets(port, timer);
+      }
    /* wait for both frames to arrive or timeout */
    } while (((wkc <= EC_NOFRAME) || (wkc2 <= EC_NOFRAME)) && !osal_timer_is_expired(timer));
+   if (ec_waitstatsenabled)
+   {
+      ecx_addwaitstat(ecx_clockns(CLOCK_MONOTONIC) - startns,
+                      ecx_clockns(CLOCK_THREAD_CPUTIME_ID) - startcpu, (wkc > EC_NOFRAME));
+   }
    /* only do redundant functions when in redundant mode */
    if (port->redstate != ECT_RED_NONE)
    {
@@ -506,6 +610,11 @@ static int ecx_waitinframe_red(ecx_portt *port, uint8 idx, osal_timert *timer)
          memcpy(&(port->rxbuf[idx]), &(port->redport->rxbuf[idx]), port->txbuflength[idx] - ETH_HEADERSIZE);
          wkc = wkc2;
       }
+      else if (primrx == RX_PRIM)
+      {
+         /* frame passed all slaves and was returned by the last one */
+         path = EC_RXPATH_PRIMARY;
+      }
       /* primary socket got nothing or primary frame, and secondary socket got secondary frame */
       /* we need to resend TX packet */
       if ( ((primrx == 0) && (secrx == RX_SEC)) ||
@@ -533,8 +642,10 @@ static int ecx_waitinframe_red(ecx_portt *port, uint8 idx, osal_timert *timer)
             memcpy(&(port->rxbuf[idx]), &(port->redport->rxbuf[idx]), port->txbuflength[idx] - ETH_HEADERSIZE);
             wkc = wkc2;
          }
+         path = (primrx == RX_PRIM) ? EC_RXPATH_SPLIT : EC_RXPATH_SECONDARY;
       }
    }
+   port->rxpath[idx] = (wkc > EC_NOFRAME) ? path : EC_RXPATH_LOST;
 
    /* return WKC or EC_NOFRAME */
    return wkc;
@@ -597,6 +708,52 @@ int ecx_srconfirm(ecx_portt *port, uint8 idx, int timeout)
    return wkc;
 }
 
+/** Select the frame wait strategy of the calling thread.
+ * @param[in] mode        = EC_WAIT_SPIN or EC_WAIT_POLL
+ */
+void ecx_setwaitmode(int mode)
+{
+   if ((mode >= 0) && (mode < EC_WAIT_MODES))
+   {
+      ec_waitmode = mode;
+   }
+}
+
+/** Frame wait strategy of the calling thread.
+ * @return EC_WAIT_SPIN or EC_WAIT_POLL
+ */
+int ecx_getwaitmode(void)
+{
+   return ec_waitmode;
+}
+
+/** Switch collection of frame wait statistics on or off. Costs two clock
+ * reads per frame wait while on.
+ * @param[in] enable      = TRUE to collect
+ */
+void ecx_enablewaitstats(boolean enable)
+{
+   ec_waitstatsenabled = enable;
+}
+
+/** Copy the frame wait statistics of one strategy.
+ * @param[in]  mode       = EC_WAIT_SPIN or EC_WAIT_POLL
+ * @param[out] stats      = statistics
+ */
+void ecx_getwaitstats(int mode, ec_waitstatt *stats)
+{
+   memset(stats, 0, sizeof(*stats));
+   if ((mode < 0) || (mode >= EC_WAIT_MODES))
+   {
+      return;
+   }
+   stats->frames = __atomic_load_n(&ec_waitstats[mode].frames, __ATOMIC_RELAXED);
+   stats->timeouts = __atomic_load_n(&ec_waitstats[mode].timeouts, __ATOMIC_RELAXED);
+   stats->waitns = __atomic_load_n(&ec_waitstats[mode].waitns, __ATOMIC_RELAXED);
+   stats->cpuns = __atomic_load_n(&ec_waitstats[mode].cpuns, __ATOMIC_RELAXED);
+   stats->maxns = __atomic_load_n(&ec_waitstats[mode].maxns, __ATOMIC_RELAXED);
+}
+
 #ifdef EC_VER1
 int ec_setupnic(const char *ifname, int secondary)
 {
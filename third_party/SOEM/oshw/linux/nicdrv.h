@@ -52,6 +52,23 @@ typedef struct
    ec_bufT tempinbuf;
 } ecx_redportt;
 
+/** path a frame took back to the master, ordered from healthy to lost */
+enum
+{
+   /** single port operation or redundant ring closed, frame passed all slaves */
+   EC_RXPATH_OK = 0,
+   /** ring broken at the secondary side, frame came back on the primary port */
+   EC_RXPATH_PRIMARY,
+   /** ring broken at the primary side, frame resent and received on the secondary port */
+   EC_RXPATH_SECONDARY,
+   /** ring broken in between, both halves answered and the frame was resent
+    *  through the secondary half to pass all slaves */
+   EC_RXPATH_SPLIT,
+   /** no frame came back */
+   EC_RXPATH_LOST,
+   EC_RXPATHS
+};
+
 /** pointer structure to buffers, vars and mutexes for port instantiation */
 typedef struct
 {
@@ -79,13 +96,39 @@ typedef struct
    uint8 lastidx;
    /** current redundancy state */
    int redstate;
+   /** EC_RXPATH_* of the last frame received per index */
+   int rxpath[EC_MAXBUF];
    /** pointer to redundancy port and buffers */
    ecx_redportt *redport;
-   pthread_mutex_t getindex_mutex;
    pthread_mutex_t tx_mutex;
    pthread_mutex_t rx_mutex;
 } ecx_portt;
 
+/** frame wait strategies, chosen per calling thread */
+enum
+{
+   /** spin on the socket until the frame is in, lowest latency, for the RT thread */
+   EC_WAIT_SPIN = 0,
+   /** sleep in ppoll until the socket is readable or the deadline passes */
+   EC_WAIT_POLL,
+   EC_WAIT_MODES
+};
+
+/** frame wait statistics of one wait strategy */
+typedef struct
+{
+   /** waits that got their frame */
+   uint64 frames;
+   /** waits that ran into the deadline */
+   uint64 timeouts;
+   /** wall time spent waiting in ns */
+   uint64 waitns;
+   /** thread CPU time spent waiting in ns */
+   uint64 cpuns;
+   /** longest wait that got its frame in ns */
+   uint64 maxns;
+} ec_waitstatt;
+
 extern const uint16 priMAC[3];
 extern const uint16 secMAC[3];
 
@@ -112,6 +155,10 @@ int ecx_outframe(ecx_portt *port, uint8 idx, int sock);
 int ecx_outframe_red(ecx_portt *port, uint8 idx);
 int ecx_waitinframe(ecx_portt *port, uint8 idx, int timeout);
 int ecx_srconfirm(ecx_portt *port, uint8 idx,int timeout);
+void ecx_setwaitmode(int mode);
+int ecx_getwaitmode(void);
+void ecx_enablewaitstats(boolean enable);
+void ecx_getwaitstats(int mode, ec_waitstatt *stats);
 
 #ifdef __cplusplus
 }
@@ -537,6 +537,126 @@ int ecx_SDOwrite(ecx_contextt *context, uint16 Slave, uint16 Index, uint8 SubInd
    return wkc;
 }
 
+/** CoE expedited SDO transfer, non-blocking start.
+ *
+ * Places an expedited download (write, 1 to 4 bytes) or upload (read) request
+ * in the slave mailbox and returns without waiting for the reply. The reply is
+ * collected with ecx_SDOexp_poll, so a cyclic loop can spread the transfer
+ * over several cycles.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index to access
+ * @param[in]  subindex   = Subindex to access
+ * @param[in]  psize      = Size in bytes of p for a download, 0 for an upload
+ * @param[in]  p          = Pointer to parameter buffer for a download
+ * @return Workcounter of the mailbox write, 0 if the slave mailbox is still busy
+ */
+int ecx_SDOexp_start(ecx_contextt *context, uint16 slave, uint16 index, uint8 subindex,
+                     int psize, const void *p)
+{
+   ec_SDOt *SDOp;
+   ec_mbxbuft MbxIn, MbxOut;
+   uint8 cnt;
+
+   if ((psize < 0) || (psize > 4))
+   {
+      return 0;
+   }
+   ec_clearmbx(&MbxIn);
+   /* Empty slave out mailbox if something is in. Timeout set to 0 */
+   ecx_mbxreceive(context, slave, (ec_mbxbuft *)&MbxIn, 0);
+   ec_clearmbx(&MbxOut);
+   SDOp = (ec_SDOt *)&MbxOut;
+   SDOp->MbxHeader.length = htoes(0x000a);
+   SDOp->MbxHeader.address = htoes(0x0000);
+   SDOp->MbxHeader.priority = 0x00;
+   cnt = ec_nextmbxcnt(context->slavelist[slave].mbx_cnt);
+   SDOp->MbxHeader.mbxtype = ECT_MBXT_COE + MBX_HDR_SET_CNT(cnt); /* CoE */
+   SDOp->CANOpen = htoes(0x000 + (ECT_COES_SDOREQ << 12)); /* number 9bits service upper 4 bits (SDO request) */
+   if (psize)
+   {
+      SDOp->Command = ECT_SDO_DOWN_EXP | (((4 - psize) << 2) & 0x0c); /* expedited SDO download transfer */
+      memcpy(&SDOp->ldata[0], p, psize);
+   }
+   else
+   {
+      SDOp->Command = ECT_SDO_UP_REQ; /* upload request normal */
+      SDOp->ldata[0] = 0;
+   }
+   SDOp->Index = htoes(index);
+   SDOp->SubIndex = subindex;
+   /* only a single try, the caller retries in its next cycle */
+   if (ecx_mbxsend(context, slave, (ec_mbxbuft *)&MbxOut, 0) <= 0)
+   {
+      return 0;
+   }
+   context->slavelist[slave].mbx_cnt = cnt;
+   return 1;
+}
+
+/** CoE expedited SDO transfer, non-blocking completion.
+ *
+ * Checks once for the reply to a request placed with ecx_SDOexp_start.
+ * When the read mailbox status is mapped into the process data this costs
+ * no datagram until the reply is there.
+ *
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index of the request
+ * @param[in]  subindex   = Subindex of the request
+ * @param[in,out] psize   = NULL for a download, else size in bytes of p, returns bytes read
+ * @param[out] p          = Pointer to parameter buffer for an upload
+ * @return 1 when the transfer completed, 0 if there is no reply yet, -1 on abort
+ * or unexpected reply
+ */
+int ecx_SDOexp_poll(ecx_contextt *context, uint16 slave, uint16 index, uint8 subindex,
+                    int *psize, void *p)
+{
+   ec_SDOt *aSDOp;
+   ec_mbxbuft MbxIn;
+   uint16 bytesize;
+
+   ec_clearmbx(&MbxIn);
+   if (ecx_mbxreceive(context, slave, (ec_mbxbuft *)&MbxIn, 0) <= 0)
+   {
+      return 0;
+   }
+   aSDOp = (ec_SDOt *)&MbxIn;
+   if (((aSDOp->MbxHeader.mbxtype & 0x0f) != ECT_MBXT_COE) ||
+       ((etohs(aSDOp->CANOpen) >> 12) != ECT_COES_SDORES) ||
+       (etohs(aSDOp->Index) != index) || (aSDOp->SubIndex != subindex))
+   {
+      if (aSDOp->Command == ECT_SDO_ABORT) /* SDO abort frame received */
+      {
+         ecx_SDOerror(context, slave, index, subindex, etohl(aSDOp->ldata[0]));
+      }
+      else
+      {
+         ecx_packeterror(context, slave, index, subindex, 1); /* Unexpected frame returned */
+      }
+      return -1;
+   }
+   if (psize == NULL)
+   {
+      return 1;
+   }
+   if ((aSDOp->Command & 0x02) == 0)
+   {
+      ecx_packeterror(context, slave, index, subindex, 1); /* only expedited replies handled here */
+      return -1;
+   }
+   bytesize = 4 - ((aSDOp->Command >> 2) & 0x03);
+   if (*psize < bytesize)
+   {
+      ecx_packeterror(context, slave, index, subindex, 3); /*  data container too small for type */
+      return -1;
+   }
+   memcpy(p, &aSDOp->ldata[0], bytesize);
+   *psize = bytesize;
+   return 1;
+}
+
 /** CoE RxPDO write, blocking.
  *
  * A RxPDO download request is issued.
@@ -1370,6 +1490,36 @@ int ec_SDOwrite(uint16 Slave, uint16 Index, uint8 SubIndex,
    return ecx_SDOwrite(&ecx_context, Slave, Index, SubIndex, CA, psize, p, Timeout);
 }
 
+/** CoE expedited SDO transfer, non-blocking start.
+ *
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index to access
+ * @param[in]  subindex   = Subindex to access
+ * @param[in]  psize      = Size in bytes of p for a download, 0 for an upload
+ * @param[in]  p          = Pointer to parameter buffer for a download
+ * @return Workcounter of the mailbox write, 0 if the slave mailbox is still busy
+ * @see ecx_SDOexp_start
+ */
+int ec_SDOexp_start(uint16 slave, uint16 index, uint8 subindex, int psize, const void *p)
+{
+   return ecx_SDOexp_start(&ecx_context, slave, index, subindex, psize, p);
+}
+
+/** CoE expedited SDO transfer, non-blocking completion.
+ *
+ * @param[in]  slave      = Slave number
+ * @param[in]  index      = Index of the request
+ * @param[in]  subindex   = Subindex of the request
+ * @param[in,out] psize   = NULL for a download, else size in bytes of p, returns bytes read
+ * @param[out] p          = Pointer to parameter buffer for an upload
+ * @return 1 when the transfer completed, 0 if there is no reply yet, -1 on abort
+ * @see ecx_SDOexp_poll
+ */
+int ec_SDOexp_poll(uint16 slave, uint16 index, uint8 subindex, int *psize, void *p)
+{
+   return ecx_SDOexp_poll(&ecx_context, slave, index, subindex, psize, p);
+}
+
 /** CoE RxPDO write, blocking.
  *
  * A RxPDO download request is issued.
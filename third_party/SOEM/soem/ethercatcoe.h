@@ -64,6 +64,8 @@ int ec_SDOread(uint16 slave, uint16 index, uint8 subindex,
                boolean CA, int *psize, void *p, int timeout);
 int ec_SDOwrite(uint16 Slave, uint16 Index, uint8 SubIndex,
                 boolean CA, int psize, const void *p, int Timeout);
+int ec_SDOexp_start(uint16 slave, uint16 index, uint8 subindex, int psize, const void *p);
+int ec_SDOexp_poll(uint16 slave, uint16 index, uint8 subindex, int *psize, void *p);
 int ec_RxPDO(uint16 Slave, uint16 RxPDOnumber , int psize, const void *p);
 int ec_TxPDO(uint16 slave, uint16 TxPDOnumber , int *psize, void *p, int timeout);
 int ec_readPDOmap(uint16 Slave, uint32 *Osize, uint32 *Isize);
@@ -79,6 +81,10 @@ int ecx_SDOread(ecx_contextt *context, uint16 slave, uint16 index, uint8 subinde
                 boolean CA, int *psize, void *p, int timeout);
 int ecx_SDOwrite(ecx_contextt *context, uint16 Slave, uint16 Index, uint8 SubIndex,
                  boolean CA, int psize, const void *p, int Timeout);
+int ecx_SDOexp_start(ecx_contextt *context, uint16 slave, uint16 index, uint8 subindex,
+                     int psize, const void *p);
+int ecx_SDOexp_poll(ecx_contextt *context, uint16 slave, uint16 index, uint8 subindex,
+                    int *psize, void *p);
 int ecx_RxPDO(ecx_contextt *context, uint16 Slave, uint16 RxPDOnumber , int psize, const void *p);
 int ecx_TxPDO(ecx_contextt *context, uint16 slave, uint16 TxPDOnumber , int *psize, void *p, int timeout);
 int ecx_readPDOmap(ecx_contextt *context, uint16 Slave, uint32 *Osize, uint32 *Isize);
@@ -12,6 +12,7 @@
  */
 
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include "osal.h"
 #include "oshw.h"
@@ -36,6 +37,27 @@ ecx_mapt_t ecx_mapt[EC_MAX_MAPT];
 OSAL_THREAD_HANDLE ecx_threadh[EC_MAX_MAPT];
 #endif
 
+/** max number of slaves whose SII is read in one interleaved pass */
+#define EC_MAXSIIPREFETCH 8
+
+/** SII image of one slave read ahead of parsing */
+typedef struct
+{
+   uint16 slave;
+   /** next word address to read */
+   uint16 addr;
+   /** word address of current category header */
+   uint16 hdr;
+   /** word address behind current category body */
+   uint16 end;
+   boolean done;
+   uint8  buf[EC_MAXEEPBUF];
+   uint32 map[EC_MAXEEPBITMAP];
+} ecx_siiprefetcht;
+
+static ecx_siiprefetcht ecx_siiprefetch[EC_MAXSIIPREFETCH];
+static int ecx_siiprefetchn;
+
 #ifdef EC_VER1
 /** Slave configuration structure */
 typedef const struct
@@ -107,6 +129,8 @@ void ecx_init_context(ecx_contextt *context)
    /* clean ec_slave array */
    memset(context->slavelist, 0x00, sizeof(ec_slavet) * context->maxslave);
    memset(context->grouplist, 0x00, sizeof(ec_groupt) * context->maxgroup);
+   /* the groups above no longer hold frozen frames, neither do their indexes */
+   context->idxstack->frozen = 0;
    /* clear slave eeprom cache, does not actually read any eeprom */
    ecx_siigetbyte(context, 0, EC_MAXEEPBUF);
    for(lp = 0; lp < context->maxgroup; lp++)
@@ -116,20 +140,70 @@ void ecx_init_context(ecx_contextt *context)
    }
 }
 
+/** Count the slaves on the line without touching their state.
+ * Used to size the slave list before ecx_config_init().
+ *
+ * @param[in]  context = context struct
+ * @return number of slaves responding, <= 0 if none
+ */
+int ecx_countslaves(ecx_contextt *context)
+{
+   uint16 w;
+   return ecx_BRD(context->port, 0x0000, ECT_REG_TYPE, sizeof(w), &w, EC_TIMEOUTSAFE);
+}
+
+/** Move the process data pointers of all slaves and groups from one IOmap to
+ * another after the mapping has been copied or redone at the new location.
+ * The mapping functions only do pointer arithmetic on pIOmap, so a layout
+ * mapped into a scratch buffer can be moved to an exactly sized one.
+ *
+ * @param[in]  context  = context struct
+ * @param[in]  oldIOmap = IOmap the groups were mapped into
+ * @param[in]  size     = bytes of oldIOmap in use
+ * @param[in]  newIOmap = IOmap to use from now on
+ */
+void ecx_config_rebase(ecx_contextt *context, void *oldIOmap, int size, void *newIOmap)
+{
+   uint8 *from = (uint8 *)oldIOmap;
+   uint8 *to = (uint8 *)newIOmap;
+   int lp;
+
+#define EC_REBASE(ptr) \
+   if ((ptr) && ((uint8 *)(ptr) >= from) && ((uint8 *)(ptr) < from + size)) \
+      (ptr) = to + ((uint8 *)(ptr) - from)
+
+   for (lp = 0; lp <= *(context->slavecount); lp++)
+   {
+      EC_REBASE(context->slavelist[lp].outputs);
+      EC_REBASE(context->slavelist[lp].inputs);
+      EC_REBASE(context->slavelist[lp].mbxstatus);
+   }
+   for (lp = 0; lp < context->maxgroup; lp++)
+   {
+      EC_REBASE(context->grouplist[lp].outputs);
+      EC_REBASE(context->grouplist[lp].inputs);
+   }
+#undef EC_REBASE
+}
+
 int ecx_detect_slaves(ecx_contextt *context)
 {
    uint8  b;
    uint16 w;
    int    wkc;
 
-   /* make special pre-init register writes to enable MAC[1] local administered bit *
-    * setting for old netX100 slaves */
-   b = 0x00;
-   ecx_BWR(context->port, 0x0000, ECT_REG_DLALIAS, sizeof(b), &b, EC_TIMEOUTRET3);     /* Ignore Alias register */
-   b = EC_STATE_INIT | EC_STATE_ACK;
-   ecx_BWR(context->port, 0x0000, ECT_REG_ALCTL, sizeof(b), &b, EC_TIMEOUTRET3);       /* Reset all slaves to Init */
-   /* netX100 should now be happy */
-   ecx_BWR(context->port, 0x0000, ECT_REG_ALCTL, sizeof(b), &b, EC_TIMEOUTRET3);       /* Reset all slaves to Init */
+   /* warm start keeps slaves in their current state */
+   if (!context->warmstart)
+   {
+      /* make special pre-init register writes to enable MAC[1] local administered bit *
+       * setting for old netX100 slaves */
+      b = 0x00;
+      ecx_BWR(context->port, 0x0000, ECT_REG_DLALIAS, sizeof(b), &b, EC_TIMEOUTRET3);     /* Ignore Alias register */
+      b = EC_STATE_INIT | EC_STATE_ACK;
+      ecx_BWR(context->port, 0x0000, ECT_REG_ALCTL, sizeof(b), &b, EC_TIMEOUTRET3);       /* Reset all slaves to Init */
+      /* netX100 should now be happy */
+      ecx_BWR(context->port, 0x0000, ECT_REG_ALCTL, sizeof(b), &b, EC_TIMEOUTRET3);       /* Reset all slaves to Init */
+   }
    wkc = ecx_BRD(context->port, 0x0000, ECT_REG_TYPE, sizeof(w), &w, EC_TIMEOUTSAFE);  /* detect number of slaves */
    if (wkc > 0)
    {
@@ -148,6 +222,17 @@ int ecx_detect_slaves(ecx_contextt *context)
    return wkc;
 }
 
+/* Hand the EEPROM of all slaves to the master, the only register write a warm start needs */
+static void ecx_eeprom_to_master_all(ecx_contextt *context)
+{
+   uint8 b;
+
+   b = 2;
+   ecx_BWR(context->port, 0x0000, ECT_REG_EEPCFG      , sizeof(b) , &b, EC_TIMEOUTRET3);     /* force Eeprom from PDI */
+   b = 0;
+   ecx_BWR(context->port, 0x0000, ECT_REG_EEPCFG      , sizeof(b) , &b, EC_TIMEOUTRET3);     /* set Eeprom to master */
+}
+
 static void ecx_set_slaves_to_default(ecx_contextt *context)
 {
    uint8 b;
@@ -172,10 +257,7 @@ static void ecx_set_slaves_to_default(ecx_contextt *context)
    ecx_BWR(context->port, 0x0000, ECT_REG_DLALIAS     , sizeof(b) , &b, EC_TIMEOUTRET3);     /* Ignore Alias register */
    b = EC_STATE_INIT | EC_STATE_ACK;
    ecx_BWR(context->port, 0x0000, ECT_REG_ALCTL       , sizeof(b) , &b, EC_TIMEOUTRET3);     /* Reset all slaves to Init */
-   b = 2;
-   ecx_BWR(context->port, 0x0000, ECT_REG_EEPCFG      , sizeof(b) , &b, EC_TIMEOUTRET3);     /* force Eeprom from PDI */
-   b = 0;
-   ecx_BWR(context->port, 0x0000, ECT_REG_EEPCFG      , sizeof(b) , &b, EC_TIMEOUTRET3);     /* set Eeprom to master */
+   ecx_eeprom_to_master_all(context);
 }
 
 #ifdef EC_VER1
@@ -299,103 +381,353 @@ static int ecx_lookup_prev_sii(ecx_contextt *context, uint16 slave)
    return 0;
 }
 
-/** Enumerate and init all slaves.
- *
- * @param[in] context      = context struct
- * @param[in] usetable     = TRUE when using configtable to init slaves, FALSE otherwise
- * @return Workcounter of slave discover datagram = number of slaves found
+/** Check SII cache of application for slave identity and checksum.
+ *  @param[in]  context = context struct
+ *  @param[in]  slave   = slave number
+ *  @param[out] sii     = cached SII data
+ *  @return 1 if found in cache
  */
-int ecx_config_init(ecx_contextt *context, uint8 usetable)
+static int ecx_lookup_sii_cache(ecx_contextt *context, uint16 slave, ec_siicachet *sii)
 {
-   uint16 slave, ADPh, configadr, ssigen;
-   uint16 topology, estat;
-   int16 topoc, slavec, aliasadr;
-   uint8 b,h;
-   uint8 SMc;
-   uint32 eedat;
-   int wkc, cindex, nSM;
-   uint16 val16;
+   if (context->SIIloadhook == NULL)
+   {
+      return 0;
+   }
+   memset(sii, 0x00, sizeof(ec_siicachet));
+   sii->man = context->slavelist[slave].eep_man;
+   sii->id  = context->slavelist[slave].eep_id;
+   sii->rev = context->slavelist[slave].eep_rev;
+   sii->crc = context->slavelist[slave].eep_crc;
+   return context->SIIloadhook(context, slave, sii);
+}
 
-   EC_PRINT("ec_config_init %d\n",usetable);
-   ecx_init_context(context);
-   wkc = ecx_detect_slaves(context);
-   if (wkc > 0)
+/** Copy SII data from application cache to slave.
+ *  @param[in]  context = context struct
+ *  @param[in]  slave   = slave number
+ *  @return 1 if copied
+ */
+static int ecx_load_sii_cache(ecx_contextt *context, uint16 slave)
+{
+   ec_siicachet sii;
+
+   if (!ecx_lookup_sii_cache(context, slave, &sii))
    {
-      ecx_set_slaves_to_default(context);
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      return 0;
+   }
+   context->slavelist[slave].CoEdetails = sii.CoEdetails;
+   context->slavelist[slave].FoEdetails = sii.FoEdetails;
+   context->slavelist[slave].EoEdetails = sii.EoEdetails;
+   context->slavelist[slave].SoEdetails = sii.SoEdetails;
+   if (sii.blockLRW > 0)
+   {
+      context->slavelist[slave].blockLRW = 1;
+      context->slavelist[0].blockLRW++;
+   }
+   context->slavelist[slave].Ebuscurrent = sii.Ebuscurrent;
+   context->slavelist[0].Ebuscurrent += context->slavelist[slave].Ebuscurrent;
+   memcpy(context->slavelist[slave].name, sii.name, EC_MAXNAME + 1);
+   context->slavelist[slave].name[EC_MAXNAME] = 0;
+   memcpy(context->slavelist[slave].SM, sii.SM, sizeof(sii.SM));
+   context->slavelist[slave].FMMU0func = sii.FMMU0func;
+   context->slavelist[slave].FMMU1func = sii.FMMU1func;
+   context->slavelist[slave].FMMU2func = sii.FMMU2func;
+   context->slavelist[slave].FMMU3func = sii.FMMU3func;
+   EC_PRINT("SII slave %d from cache.\n", slave);
+   return 1;
+}
+
+/** Hand freshly parsed SII data of slave to application cache.
+ *  @param[in]  context = context struct
+ *  @param[in]  slave   = slave number
+ */
+static void ecx_store_sii_cache(ecx_contextt *context, uint16 slave)
+{
+   ec_siicachet sii;
+
+   if (context->SIIstorehook == NULL)
+   {
+      return;
+   }
+   memset(&sii, 0x00, sizeof(sii));
+   sii.man = context->slavelist[slave].eep_man;
+   sii.id  = context->slavelist[slave].eep_id;
+   sii.rev = context->slavelist[slave].eep_rev;
+   sii.crc = context->slavelist[slave].eep_crc;
+   sii.CoEdetails = context->slavelist[slave].CoEdetails;
+   sii.FoEdetails = context->slavelist[slave].FoEdetails;
+   sii.EoEdetails = context->slavelist[slave].EoEdetails;
+   sii.SoEdetails = context->slavelist[slave].SoEdetails;
+   sii.blockLRW = context->slavelist[slave].blockLRW;
+   sii.Ebuscurrent = context->slavelist[slave].Ebuscurrent;
+   memcpy(sii.name, context->slavelist[slave].name, EC_MAXNAME + 1);
+   memcpy(sii.SM, context->slavelist[slave].SM, sizeof(sii.SM));
+   sii.FMMU0func = context->slavelist[slave].FMMU0func;
+   sii.FMMU1func = context->slavelist[slave].FMMU1func;
+   sii.FMMU2func = context->slavelist[slave].FMMU2func;
+   sii.FMMU3func = context->slavelist[slave].FMMU3func;
+   context->SIIstorehook(context, slave, &sii);
+}
+
+/** Check if SII of slave must be parsed, i.e. it is not in the application
+ *  cache and no earlier slave has the same identity.
+ *  @param[in]  context = context struct
+ *  @param[in]  slave   = slave number
+ *  @return 1 if SII must be read from slave
+ */
+static int ecx_sii_needed(ecx_contextt *context, uint16 slave)
+{
+   ec_siicachet sii;
+   uint16 i;
+
+   for (i = 1; i < slave; i++)
+   {
+      if ((context->slavelist[i].eep_man == context->slavelist[slave].eep_man) &&
+          (context->slavelist[i].eep_id  == context->slavelist[slave].eep_id ) &&
+          (context->slavelist[i].eep_rev == context->slavelist[slave].eep_rev))
       {
-         ADPh = (uint16)(1 - slave);
-         val16 = ecx_APRDw(context->port, ADPh, ECT_REG_PDICTL, EC_TIMEOUTRET3); /* read interface type of slave */
-         context->slavelist[slave].Itype = etohs(val16);
-         /* a node offset is used to improve readability of network frames */
-         /* this has no impact on the number of addressable slaves (auto wrap around) */
-         ecx_APWRw(context->port, ADPh, ECT_REG_STADR, htoes(slave + EC_NODEOFFSET) , EC_TIMEOUTRET3); /* set node address of slave */
-         if (slave == 1)
-         {
-            b = 1; /* kill non ecat frames for first slave */
-         }
-         else
-         {
-            b = 0; /* pass all frames for following slaves */
-         }
-         ecx_APWRw(context->port, ADPh, ECT_REG_DLCTL, htoes(b), EC_TIMEOUTRET3); /* set non ecat frame behaviour */
-         configadr = ecx_APRDw(context->port, ADPh, ECT_REG_STADR, EC_TIMEOUTRET3);
-         configadr = etohs(configadr);
-         context->slavelist[slave].configadr = configadr;
-         ecx_FPRD(context->port, configadr, ECT_REG_ALIAS, sizeof(aliasadr), &aliasadr, EC_TIMEOUTRET3);
-         context->slavelist[slave].aliasadr = etohs(aliasadr);
-         ecx_FPRD(context->port, configadr, ECT_REG_EEPSTAT, sizeof(estat), &estat, EC_TIMEOUTRET3);
-         estat = etohs(estat);
-         if (estat & EC_ESTAT_R64) /* check if slave can read 8 byte chunks */
+         return 0;
+      }
+   }
+   return !ecx_lookup_sii_cache(context, slave, &sii);
+}
+
+/** SII categories used by ecx_config_init */
+static boolean ecx_sii_wanted(uint16 cat)
+{
+   return (cat == ECT_SII_STRING) || (cat == ECT_SII_GENERAL) ||
+          (cat == ECT_SII_FMMU) || (cat == ECT_SII_SM);
+}
+
+/** Store a chunk of EEPROM data in prefetch buffer and advance category walk.
+ *  @param[in]  pf      = prefetch entry
+ *  @param[in]  data    = EEPROM data read at pf->addr
+ *  @param[in]  cnt     = number of bytes in data
+ */
+static void ecx_sii_prefetch_store(ecx_siiprefetcht *pf, const uint8 *data, int cnt)
+{
+   uint16 cat, len, mapw, mapb;
+   uint32 badr, end;
+   int lp;
+
+   badr = (uint32)pf->addr << 1;
+   if ((cnt == 0) || (badr + cnt > EC_MAXEEPBUF))
+   {
+      pf->done = TRUE;
+      return;
+   }
+   memcpy(&pf->buf[badr], data, cnt);
+   for (lp = 0; lp < cnt; lp++)
+   {
+      mapw = (badr + lp) >> 5;
+      mapb = (uint16)((badr + lp) - (mapw << 5));
+      pf->map[mapw] |= (1U << mapb);
+   }
+   if (pf->addr == pf->hdr)
+   {
+      /* category header, decide to read body or skip it */
+      cat = pf->buf[badr] + (pf->buf[badr + 1] << 8);
+      len = pf->buf[badr + 2] + (pf->buf[badr + 3] << 8);
+      if (cat == ECT_SII_END)
+      {
+         pf->done = TRUE;
+         return;
+      }
+      /* computed wide, a corrupt length must not wrap back into the image */
+      end = (uint32)pf->hdr + 2 + len;
+      if ((end << 1) > EC_MAXEEPBUF)
+      {
+         pf->done = TRUE;
+         return;
+      }
+      pf->end = (uint16)end;
+      if (!ecx_sii_wanted(cat))
+      {
+         pf->hdr = pf->end;
+         pf->addr = pf->end;
+      }
+      else
+      {
+         pf->addr += (uint16)(cnt >> 1);
+      }
+   }
+   else
+   {
+      pf->addr += (uint16)(cnt >> 1);
+   }
+   /* body complete, continue at next header */
+   if ((pf->addr != pf->hdr) && (pf->addr >= pf->end))
+   {
+      pf->hdr = pf->end;
+      pf->addr = pf->end;
+   }
+   if (((uint32)pf->hdr << 1) + 4 > EC_MAXEEPBUF)
+   {
+      pf->done = TRUE;
+   }
+}
+
+/** Read the SII categories needed by ecx_config_init for the next slaves
+ *  still to be parsed, starting at slave. EEPROM reads of all slaves in the
+ *  batch share frames so the EEPROM load time of the slaves overlaps.
+ *  @param[in]  context = context struct
+ *  @param[in]  slave   = first slave of batch
+ */
+static void ecx_sii_prefetch_batch(ecx_contextt *context, uint16 slave)
+{
+   uint8 data[8];
+   uint16 slavelst[EC_MAXSIIPREFETCH];
+   uint16 addrlst[EC_MAXSIIPREFETCH];
+   uint64 datalst[EC_MAXSIIPREFETCH];
+   int map[EC_MAXSIIPREFETCH];
+   int i, cnt, active;
+   ecx_siiprefetcht *pf;
+
+   ecx_siiprefetchn = 0;
+   while ((slave <= *(context->slavecount)) && (ecx_siiprefetchn < EC_MAXSIIPREFETCH))
+   {
+      if ((ecx_siiprefetchn == 0) || ecx_sii_needed(context, slave))
+      {
+         pf = &ecx_siiprefetch[ecx_siiprefetchn++];
+         pf->slave = slave;
+         pf->addr = ECT_SII_START;
+         pf->hdr = ECT_SII_START;
+         pf->end = ECT_SII_START;
+         pf->done = FALSE;
+         memset(pf->map, 0x00, sizeof(pf->map));
+      }
+      slave++;
+   }
+   do
+   {
+      active = 0;
+      for (i = 0; i < ecx_siiprefetchn; i++)
+      {
+         pf = &ecx_siiprefetch[i];
+         if (!pf->done)
          {
-            context->slavelist[slave].eep_8byte = 1;
+            map[active] = i;
+            slavelst[active] = pf->slave;
+            addrlst[active++] = pf->addr;
          }
-         ecx_readeeprom1(context, slave, ECT_SII_MANUF); /* Manuf */
       }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      if (active > 0)
       {
-         eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* Manuf */
-         context->slavelist[slave].eep_man = etohl(eedat);
-         ecx_readeeprom1(context, slave, ECT_SII_ID); /* ID */
+         ecx_readeeprom_multi(context, active, slavelst, addrlst, datalst, EC_TIMEOUTEEP);
       }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      for (i = 0; i < active; i++)
       {
-         eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* ID */
-         context->slavelist[slave].eep_id = etohl(eedat);
-         ecx_readeeprom1(context, slave, ECT_SII_REV); /* revision */
+         pf = &ecx_siiprefetch[map[i]];
+         cnt = context->slavelist[pf->slave].eep_8byte ? 8 : 4;
+         put_unaligned64(datalst[i], data);
+         ecx_sii_prefetch_store(pf, data, cnt);
       }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+   }
+   while (active > 0);
+}
+
+/** Load prefetched SII image of slave into the EEPROM cache, reading
+ *  the next batch first when slave is not prefetched yet.
+ *  @param[in]  context = context struct
+ *  @param[in]  slave   = slave number
+ */
+static void ecx_sii_prefetch(ecx_contextt *context, uint16 slave)
+{
+   int i;
+
+   for (i = 0; (i < ecx_siiprefetchn) && (ecx_siiprefetch[i].slave != slave); i++);
+   if (i == ecx_siiprefetchn)
+   {
+      ecx_sii_prefetch_batch(context, slave);
+      i = 0;
+   }
+   memcpy(context->esibuf, ecx_siiprefetch[i].buf, EC_MAXEEPBUF);
+   memcpy(context->esimap, ecx_siiprefetch[i].map, EC_MAXEEPBITMAP * sizeof(uint32));
+   context->esislave = slave;
+}
+
+/** number of slaves handled per discovery frame */
+#define EC_DISCOVERCHUNK  16
+
+/** Assign node addresses and read the ESC registers needed for configuration.
+ *  Registers of many slaves are read in batched frames.
+ *  @param[in]  context = context struct
+ */
+static void ecx_config_discover(ecx_contextt *context)
+{
+   ec_batchdgt dg[EC_DISCOVERCHUNK * 6];
+   uint16 reg[EC_DISCOVERCHUNK][6];
+   uint16 stadr[EC_DISCOVERCHUNK];
+   uint16 dlctl[EC_DISCOVERCHUNK];
+   uint16 first, last, slave, ADPh, topology;
+   int i, cnt;
+   uint8 b, h;
+
+   for (first = 1; first <= *(context->slavecount); first += EC_DISCOVERCHUNK)
+   {
+      last = first + EC_DISCOVERCHUNK - 1;
+      if (last > *(context->slavecount))
       {
-         eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* revision */
-         context->slavelist[slave].eep_rev = etohl(eedat);
-         ecx_readeeprom1(context, slave, ECT_SII_RXMBXADR); /* write mailbox address + mailboxsize */
+         last = (uint16)*(context->slavecount);
       }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      /* interface type, node address and non ecat frame behaviour */
+      cnt = 0;
+      for (slave = first; slave <= last; slave++)
       {
-         eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* write mailbox address and mailboxsize */
-         context->slavelist[slave].mbx_wo = (uint16)LO_WORD(etohl(eedat));
-         context->slavelist[slave].mbx_l = (uint16)HI_WORD(etohl(eedat));
-         if (context->slavelist[slave].mbx_l > 0)
+         i = slave - first;
+         ADPh = (uint16)(1 - slave);
+         /* a node offset is used to improve readability of network frames */
+         /* this has no impact on the number of addressable slaves (auto wrap around) */
+         stadr[i] = htoes(slave + EC_NODEOFFSET);
+         /* kill non ecat frames for first slave, pass all frames for following slaves */
+         dlctl[i] = htoes((slave == 1) ? 1 : 0);
+         dg[cnt].com = EC_CMD_APRD; dg[cnt].ADP = ADPh; dg[cnt].ADO = ECT_REG_PDICTL;
+         dg[cnt].length = sizeof(uint16); dg[cnt++].data = &reg[i][0];
+         dg[cnt].com = EC_CMD_APWR; dg[cnt].ADP = ADPh; dg[cnt].ADO = ECT_REG_STADR;
+         dg[cnt].length = sizeof(uint16); dg[cnt++].data = &stadr[i];
+         dg[cnt].com = EC_CMD_APWR; dg[cnt].ADP = ADPh; dg[cnt].ADO = ECT_REG_DLCTL;
+         dg[cnt].length = sizeof(uint16); dg[cnt++].data = &dlctl[i];
+      }
+      ecx_batch(context, cnt, dg, EC_TIMEOUTRET3);
+      cnt = 0;
+      for (slave = first; slave <= last; slave++)
+      {
+         i = slave - first;
+         context->slavelist[slave].Itype = etohs(reg[i][0]);
+         stadr[i] = 0;
+         dg[cnt].com = EC_CMD_APRD; dg[cnt].ADP = (uint16)(1 - slave); dg[cnt].ADO = ECT_REG_STADR;
+         dg[cnt].length = sizeof(uint16); dg[cnt++].data = &stadr[i];
+      }
+      ecx_batch(context, cnt, dg, EC_TIMEOUTRET3);
+      /* alias, eeprom read size, DC support, topology, physical type and FMMU count */
+      cnt = 0;
+      for (slave = first; slave <= last; slave++)
+      {
+         i = slave - first;
+         context->slavelist[slave].configadr = etohs(stadr[i]);
+         memset(reg[i], 0x00, sizeof(reg[i]));
+         dg[cnt].ADO = ECT_REG_ALIAS;   dg[cnt++].data = &reg[i][0];
+         dg[cnt].ADO = ECT_REG_EEPSTAT; dg[cnt++].data = &reg[i][1];
+         dg[cnt].ADO = ECT_REG_ESCSUP;  dg[cnt++].data = &reg[i][2];
+         dg[cnt].ADO = ECT_REG_DLSTAT;  dg[cnt++].data = &reg[i][3];
+         dg[cnt].ADO = ECT_REG_PORTDES; dg[cnt++].data = &reg[i][4];
+         dg[cnt].ADO = ECT_REG_FMMUSUP; dg[cnt++].data = &reg[i][5];
+         for (h = 6; h > 0; h--)
          {
-            ecx_readeeprom1(context, slave, ECT_SII_TXMBXADR); /* read mailbox offset */
+            dg[cnt - h].com = EC_CMD_FPRD;
+            dg[cnt - h].ADP = context->slavelist[slave].configadr;
+            dg[cnt - h].length = sizeof(uint16);
          }
       }
-      for (slave = 1; slave <= *(context->slavecount); slave++)
+      ecx_batch(context, cnt, dg, EC_TIMEOUTRET3);
+      for (slave = first; slave <= last; slave++)
       {
-         if (context->slavelist[slave].mbx_l > 0)
+         i = slave - first;
+         context->slavelist[slave].aliasadr = etohs(reg[i][0]);
+         if (etohs(reg[i][1]) & EC_ESTAT_R64) /* check if slave can read 8 byte chunks */
          {
-            eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP); /* read mailbox offset */
-            context->slavelist[slave].mbx_ro = (uint16)LO_WORD(etohl(eedat)); /* read mailbox offset */
-            context->slavelist[slave].mbx_rl = (uint16)HI_WORD(etohl(eedat)); /*read mailbox length */
-            if (context->slavelist[slave].mbx_rl == 0)
-            {
-               context->slavelist[slave].mbx_rl = context->slavelist[slave].mbx_l;
-            }
-            ecx_readeeprom1(context, slave, ECT_SII_MBXPROTO);
+            context->slavelist[slave].eep_8byte = 1;
          }
-         configadr = context->slavelist[slave].configadr;
-         val16 = ecx_FPRDw(context->port, configadr, ECT_REG_ESCSUP, EC_TIMEOUTRET3);
-         if ((etohs(val16) & 0x04) > 0)  /* Support DC? */
+         if ((etohs(reg[i][2]) & 0x04) > 0)  /* Support DC? */
          {
             context->slavelist[slave].hasdc = TRUE;
          }
@@ -403,8 +735,7 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
          {
             context->slavelist[slave].hasdc = FALSE;
          }
-         topology = ecx_FPRDw(context->port, configadr, ECT_REG_DLSTAT, EC_TIMEOUTRET3); /* extract topology from DL status */
-         topology = etohs(topology);
+         topology = etohs(reg[i][3]); /* extract topology from DL status */
          h = 0;
          b = 0;
          if ((topology & 0x0300) == 0x0200) /* port0 open and communication established */
@@ -428,10 +759,131 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
             b |= 0x08;
          }
          /* ptype = Physical type*/
-         val16 = ecx_FPRDw(context->port, configadr, ECT_REG_PORTDES, EC_TIMEOUTRET3);
-         context->slavelist[slave].ptype = LO_BYTE(etohs(val16));
+         context->slavelist[slave].ptype = LO_BYTE(etohs(reg[i][4]));
+         context->slavelist[slave].FMMUsupported = LO_BYTE(etohs(reg[i][5]));
          context->slavelist[slave].topology = h;
          context->slavelist[slave].activeports = b;
+      }
+   }
+}
+
+/** Store EEPROM identity and mailbox words read by ecx_config_readeeprom.
+ *  @param[in]  sl      = slave struct
+ *  @param[in]  eeproma = (WORD) EEPROM address that was read
+ *  @param[in]  eedat   = EEPROM data
+ */
+static void ecx_config_storeeeprom(ec_slavet *sl, uint16 eeproma, uint32 eedat)
+{
+   switch (eeproma)
+   {
+      case ECT_SII_MANUF:
+         sl->eep_man = eedat;
+         break;
+      case ECT_SII_ID:
+         sl->eep_id = eedat;
+         break;
+      case ECT_SII_REV:
+         sl->eep_rev = eedat;
+         break;
+      case ECT_SII_CRC:
+         sl->eep_crc = (uint16)LO_WORD(eedat);
+         break;
+      case ECT_SII_RXMBXADR: /* write mailbox address and mailboxsize */
+         sl->mbx_wo = (uint16)LO_WORD(eedat);
+         sl->mbx_l = (uint16)HI_WORD(eedat);
+         break;
+      case ECT_SII_TXMBXADR: /* read mailbox offset and length */
+         sl->mbx_ro = (uint16)LO_WORD(eedat);
+         sl->mbx_rl = (uint16)HI_WORD(eedat);
+         if (sl->mbx_rl == 0)
+         {
+            sl->mbx_rl = sl->mbx_l;
+         }
+         break;
+      case ECT_SII_MBXPROTO:
+         sl->mbx_proto = (uint16)eedat;
+         break;
+      default:
+         break;
+   }
+}
+
+/** Read one EEPROM word pair of all slaves, EEPROM accesses of the slaves
+ *  overlap in batched frames.
+ *  @param[in]  context = context struct
+ *  @param[in]  eeproma = (WORD) EEPROM address
+ *  @param[in]  mbxonly = only read slaves with a mailbox
+ */
+static void ecx_config_readeeprom(ecx_contextt *context, uint16 eeproma, boolean mbxonly)
+{
+   uint16 slavelst[EC_MAXBATCH];
+   uint16 addrlst[EC_MAXBATCH];
+   uint64 datalst[EC_MAXBATCH];
+   uint16 slave;
+   int i, n;
+
+   n = 0;
+   for (slave = 1; slave <= *(context->slavecount); slave++)
+   {
+      if (!mbxonly || (context->slavelist[slave].mbx_l > 0))
+      {
+         slavelst[n] = slave;
+         addrlst[n++] = eeproma;
+      }
+      if ((n == EC_MAXBATCH) || ((slave == *(context->slavecount)) && (n > 0)))
+      {
+         ecx_readeeprom_multi(context, n, slavelst, addrlst, datalst, EC_TIMEOUTEEP);
+         for (i = 0; i < n; i++)
+         {
+            ecx_config_storeeeprom(&context->slavelist[slavelst[i]], eeproma,
+                                   etohl((uint32)datalst[i]));
+         }
+         n = 0;
+      }
+   }
+}
+
+/** Enumerate and init all slaves.
+ *
+ * @param[in] context      = context struct
+ * @param[in] usetable     = TRUE when using configtable to init slaves, FALSE otherwise
+ * @return Workcounter of slave discover datagram = number of slaves found
+ */
+int ecx_config_init(ecx_contextt *context, uint8 usetable)
+{
+   uint16 slave, configadr, ssigen;
+   uint16 topology;
+   int16 topoc, slavec;
+   uint8 SMc;
+   int wkc, cindex, nSM;
+
+   EC_PRINT("ec_config_init %d\n",usetable);
+   ecx_init_context(context);
+   wkc = ecx_detect_slaves(context);
+   if (wkc > 0)
+   {
+      if (!context->warmstart)
+      {
+         ecx_set_slaves_to_default(context);
+      }
+      else
+      {
+         /* the PDI may own the EEPROM, the SII reads below need it */
+         ecx_eeprom_to_master_all(context);
+      }
+      ecx_config_discover(context);
+      /* identity and mailbox layout from EEPROM, all slaves read in parallel */
+      ecx_config_readeeprom(context, ECT_SII_MANUF, FALSE);
+      ecx_config_readeeprom(context, ECT_SII_ID, FALSE);
+      ecx_config_readeeprom(context, ECT_SII_REV, FALSE);
+      ecx_config_readeeprom(context, ECT_SII_CRC, FALSE);
+      ecx_config_readeeprom(context, ECT_SII_RXMBXADR, FALSE);
+      ecx_config_readeeprom(context, ECT_SII_TXMBXADR, TRUE);
+      ecx_config_readeeprom(context, ECT_SII_MBXPROTO, TRUE);
+      ecx_siiprefetchn = 0;
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         configadr = context->slavelist[slave].configadr;
          /* 0=no links, not possible             */
          /* 1=1 link  , end of line              */
          /* 2=2 links , one before and one after */
@@ -468,7 +920,10 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
             }
             while (slavec > 0);
          }
-         (void)ecx_statecheck(context, slave, EC_STATE_INIT,  EC_TIMEOUTSTATE); //* check state change Init */
+         if (!context->warmstart)
+         {
+            (void)ecx_statecheck(context, slave, EC_STATE_INIT,  EC_TIMEOUTSTATE); //* check state change Init */
+         }
 
          /* set default mailbox configuration if slave has mailbox */
          if (context->slavelist[slave].mbx_l>0)
@@ -483,8 +938,6 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
             context->slavelist[slave].SM[1].StartAddr = htoes(context->slavelist[slave].mbx_ro);
             context->slavelist[slave].SM[1].SMlength = htoes(context->slavelist[slave].mbx_rl);
             context->slavelist[slave].SM[1].SMflags = htoel(EC_DEFAULTMBXSM1);
-            eedat = ecx_readeeprom2(context, slave, EC_TIMEOUTEEP);
-            context->slavelist[slave].mbx_proto = (uint16)etohl(eedat);
          }
          cindex = 0;
          /* use configuration table ? */
@@ -493,8 +946,9 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
             cindex = ecx_config_from_table(context, slave);
          }
          /* slave not in configuration table, find out via SII */
-         if (!cindex && !ecx_lookup_prev_sii(context, slave))
+         if (!cindex && !ecx_lookup_prev_sii(context, slave) && !ecx_load_sii_cache(context, slave))
          {
+            ecx_sii_prefetch(context, slave);
             ssigen = ecx_siifind(context, slave, ECT_SII_GENERAL);
             /* SII general section */
             if (ssigen)
@@ -562,6 +1016,7 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
                   context->slavelist[slave].FMMU3func = context->eepFMMU->FMMU3;
                }
             }
+            ecx_store_sii_cache(context, slave);
          }
 
          if (context->slavelist[slave].mbx_l > 0)
@@ -584,13 +1039,16 @@ int ecx_config_init(ecx_contextt *context, uint8 usetable)
             }
             /* program SM0 mailbox in and SM1 mailbox out for slave */
             /* writing both SM in one datagram will solve timing issue in old NETX */
-            ecx_FPWR(context->port, configadr, ECT_REG_SM0, sizeof(ec_smt) * 2,
-               &(context->slavelist[slave].SM[0]), EC_TIMEOUTRET3);
+            if (!context->warmstart)
+            {
+               ecx_FPWR(context->port, configadr, ECT_REG_SM0, sizeof(ec_smt) * 2,
+                  &(context->slavelist[slave].SM[0]), EC_TIMEOUTRET3);
+            }
          }
          /* some slaves need eeprom available to PDI in init->preop transition */
          ecx_eeprom2pdi(context, slave);
          /* User may override automatic state change */
-         if (context->manualstatechange == 0)
+         if ((context->manualstatechange == 0) && !context->warmstart)
          {
             /* request pre_op for slave */
             ecx_FPWRw(context->port,
@@ -643,7 +1101,11 @@ static int ecx_map_coe_soe(ecx_contextt *context, uint16 slave, int thread_n)
    uint32 Isize, Osize;
    int rval;
 
-   ecx_statecheck(context, slave, EC_STATE_PRE_OP, EC_TIMEOUTSTATE); /* check state change pre-op */
+   /* a warm attached slave stays in SAFE_OP/OP */
+   if (!context->warmstart)
+   {
+      ecx_statecheck(context, slave, EC_STATE_PRE_OP, EC_TIMEOUTSTATE); /* check state change pre-op */
+   }
 
    EC_PRINT(" >Slave %d, configadr %x, state %2.2x\n",
             slave, context->slavelist[slave].configadr, context->slavelist[slave].state);
@@ -747,7 +1209,9 @@ static int ecx_map_sm(ecx_contextt *context, uint16 slave)
    configadr = context->slavelist[slave].configadr;
 
    EC_PRINT("  SM programming\n");
-   if (!context->slavelist[slave].mbx_l && context->slavelist[slave].SM[0].StartAddr)
+   /* a warm attach only rebuilds the master side, the running slave keeps its SMs */
+   if (!context->slavelist[slave].mbx_l && context->slavelist[slave].SM[0].StartAddr &&
+       !context->warmstart)
    {
       ecx_FPWR(context->port, configadr, ECT_REG_SM0,
          sizeof(ec_smt), &(context->slavelist[slave].SM[0]), EC_TIMEOUTRET3);
@@ -756,7 +1220,8 @@ static int ecx_map_sm(ecx_contextt *context, uint16 slave)
           etohs(context->slavelist[slave].SM[0].StartAddr),
           etohl(context->slavelist[slave].SM[0].SMflags));
    }
-   if (!context->slavelist[slave].mbx_l && context->slavelist[slave].SM[1].StartAddr)
+   if (!context->slavelist[slave].mbx_l && context->slavelist[slave].SM[1].StartAddr &&
+       !context->warmstart)
    {
       ecx_FPWR(context->port, configadr, ECT_REG_SM1,
          sizeof(ec_smt), &context->slavelist[slave].SM[1], EC_TIMEOUTRET3);
@@ -782,8 +1247,11 @@ static int ecx_map_sm(ecx_contextt *context, uint16 slave)
             context->slavelist[slave].SM[nSM].SMflags =
                htoel( etohl(context->slavelist[slave].SM[nSM].SMflags) | ~EC_SMENABLEMASK);
          }
-         ecx_FPWR(context->port, configadr, (uint16)(ECT_REG_SM0 + (nSM * sizeof(ec_smt))),
-            sizeof(ec_smt), &context->slavelist[slave].SM[nSM], EC_TIMEOUTRET3);
+         if (!context->warmstart)
+         {
+            ecx_FPWR(context->port, configadr, (uint16)(ECT_REG_SM0 + (nSM * sizeof(ec_smt))),
+               sizeof(ec_smt), &context->slavelist[slave].SM[nSM], EC_TIMEOUTRET3);
+         }
          EC_PRINT("    SM%d Type:%d StartAddr:%4.4x Flags:%8.8x\n", nSM,
              context->slavelist[slave].SMtype[nSM],
              etohs(context->slavelist[slave].SM[nSM].StartAddr),
@@ -1000,9 +1468,12 @@ static void ecx_config_create_input_mappings(ecx_contextt *context, void *pIOmap
          context->slavelist[slave].FMMU[FMMUc].PhysStartBit = 0;
          context->slavelist[slave].FMMU[FMMUc].FMMUtype = 1;
          context->slavelist[slave].FMMU[FMMUc].FMMUactive = 1;
-         /* program FMMU for input */
-         ecx_FPWR(context->port, configadr, ECT_REG_FMMU0 + (sizeof(ec_fmmut) * FMMUc),
-            sizeof(ec_fmmut), &(context->slavelist[slave].FMMU[FMMUc]), EC_TIMEOUTRET3);
+         /* program FMMU for input, a warm attached slave already runs it */
+         if (!context->warmstart)
+         {
+            ecx_FPWR(context->port, configadr, ECT_REG_FMMU0 + (sizeof(ec_fmmut) * FMMUc),
+               sizeof(ec_fmmut), &(context->slavelist[slave].FMMU[FMMUc]), EC_TIMEOUTRET3);
+         }
          /* Set flag to add one for an input FMMU,
             a single ESC can only contribute once */
          AddToInputsWKC = 1;
@@ -1138,9 +1609,12 @@ static void ecx_config_create_output_mappings(ecx_contextt *context, void *pIOma
          context->slavelist[slave].FMMU[FMMUc].PhysStartBit = 0;
          context->slavelist[slave].FMMU[FMMUc].FMMUtype = 2;
          context->slavelist[slave].FMMU[FMMUc].FMMUactive = 1;
-         /* program FMMU for output */
-         ecx_FPWR(context->port, configadr, ECT_REG_FMMU0 + (sizeof(ec_fmmut) * FMMUc),
-            sizeof(ec_fmmut), &(context->slavelist[slave].FMMU[FMMUc]), EC_TIMEOUTRET3);
+         /* program FMMU for output, a warm attached slave already runs it */
+         if (!context->warmstart)
+         {
+            ecx_FPWR(context->port, configadr, ECT_REG_FMMU0 + (sizeof(ec_fmmut) * FMMUc),
+               sizeof(ec_fmmut), &(context->slavelist[slave].FMMU[FMMUc]), EC_TIMEOUTRET3);
+         }
          /* Set flag to add one for an output FMMU,
             a single ESC can only contribute once */
          AddToOutputsWKC = 1;
@@ -1175,6 +1649,82 @@ static void ecx_config_create_output_mappings(ecx_contextt *context, void *pIOma
       context->grouplist[group].outputsWKC++;
 }
 
+/** Map the SM1 (read mailbox) status register of a slave into the input area
+ * with a spare FMMU. The mailbox full bit then arrives with every process data
+ * exchange and ecx_mbxreceive does not have to poll the slave for it.
+ *
+ * @param[in]     context = context struct
+ * @param[in]     pIOmap  = pointer to IOmap
+ * @param[in]     group   = group being mapped
+ * @param[in]     slave   = slave number
+ * @param[in,out] LogAddr = next free logical address, byte aligned
+ */
+static void ecx_config_create_mbxstatus_mapping(ecx_contextt *context, void *pIOmap,
+   uint8 group, int16 slave, uint32 * LogAddr)
+{
+   ec_fmmut *fmmu;
+   uint8 FMMUc;
+   int wkc;
+
+   context->slavelist[slave].mbxstatus = NULL;
+   FMMUc = context->slavelist[slave].FMMUunused;
+   if (!context->slavelist[slave].mbx_rl || (FMMUc >= EC_MAXFMMU) ||
+       (FMMUc >= context->slavelist[slave].FMMUsupported))
+   {
+      return;
+   }
+
+   EC_PRINT(" =Slave %d, MAILBOX STATUS MAPPING FMMU %d\n", slave, FMMUc);
+   fmmu = &(context->slavelist[slave].FMMU[FMMUc]);
+   fmmu->LogStart = htoel(*LogAddr);
+   fmmu->LogLength = htoes(1);
+   fmmu->LogStartbit = 0;
+   fmmu->LogEndbit = 7;
+   fmmu->PhysStart = htoes(ECT_REG_SM1STAT);
+   fmmu->PhysStartBit = 0;
+   fmmu->FMMUtype = 1;
+   fmmu->FMMUactive = 1;
+   if (context->warmstart)
+   {
+      /* warm attach: only use the status byte if the slave still runs this FMMU */
+      ec_fmmut running;
+      wkc = ecx_FPRD(context->port, context->slavelist[slave].configadr,
+         ECT_REG_FMMU0 + (sizeof(ec_fmmut) * FMMUc), sizeof(ec_fmmut), &running, EC_TIMEOUTRET3);
+      if ((wkc > 0) && memcmp(&running, fmmu, offsetof(ec_fmmut, unused1)))
+      {
+         wkc = 0;
+      }
+   }
+   else
+   {
+      wkc = ecx_FPWR(context->port, context->slavelist[slave].configadr,
+         ECT_REG_FMMU0 + (sizeof(ec_fmmut) * FMMUc), sizeof(ec_fmmut), fmmu, EC_TIMEOUTRET3);
+   }
+   if (wkc <= 0)
+   {
+      memset(fmmu, 0x00, sizeof(ec_fmmut));
+      return;
+   }
+
+   if (group)
+   {
+      context->slavelist[slave].mbxstatus =
+         (uint8 *)(pIOmap) + *LogAddr - context->grouplist[group].logstartaddr;
+   }
+   else
+   {
+      context->slavelist[slave].mbxstatus = (uint8 *)(pIOmap) + *LogAddr;
+   }
+   context->slavelist[slave].mbxstatusgroup = group;
+   context->slavelist[slave].FMMUunused = FMMUc + 1;
+   *LogAddr += 1;
+   /* a slave with inputs already counts once for the read */
+   if (!context->slavelist[slave].Ibits)
+   {
+      context->grouplist[group].inputsWKC++;
+   }
+}
+
 static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8 group, boolean forceByteAlignment)
 {
    uint16 slave, configadr;
@@ -1191,6 +1741,7 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
       LogAddr = context->grouplist[group].logstartaddr;
       oLogAddr = LogAddr;
       BitPos = 0;
+      context->grouplist[group].overlapio = FALSE;
       context->grouplist[group].nsegments = 0;
       context->grouplist[group].outputsWKC = 0;
       context->grouplist[group].inputsWKC = 0;
@@ -1310,7 +1861,7 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
 
             ecx_eeprom2pdi(context, slave); /* set Eeprom control to PDI */
             /* User may override automatic state change */
-            if (context->manualstatechange == 0)
+            if ((context->manualstatechange == 0) && !context->warmstart)
             {
                /* request safe_op for slave */
                ecx_FPWRw(context->port,
@@ -1345,6 +1896,30 @@ static int ecx_main_config_map_group(ecx_contextt *context, void *pIOmap, uint8
             segmentsize += 1;
          }
       }
+
+      /* map mailbox status behind the inputs */
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         if (!group || (group == context->slavelist[slave].group))
+         {
+            ecx_config_create_mbxstatus_mapping(context, pIOmap, group, slave, &LogAddr);
+            diff = LogAddr - oLogAddr;
+            oLogAddr = LogAddr;
+            if ((segmentsize + diff) > (EC_MAXLRWDATA - EC_FIRSTDCDATAGRAM))
+            {
+               context->grouplist[group].IOsegment[currentsegment] = segmentsize;
+               if (currentsegment < (EC_MAXIOSEGMENTS - 1))
+               {
+                  currentsegment++;
+                  segmentsize = diff;
+               }
+            }
+            else
+            {
+               segmentsize += diff;
+            }
+         }
+      }
       context->grouplist[group].IOsegment[currentsegment] = segmentsize;
       context->grouplist[group].nsegments = currentsegment + 1;
       context->grouplist[group].inputs = (uint8 *)(pIOmap) + context->grouplist[group].Obytes;
@@ -1422,6 +1997,7 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
       siLogAddr = mLogAddr;
       soLogAddr = mLogAddr;
       BitPos = 0;
+      context->grouplist[group].overlapio = TRUE;
       context->grouplist[group].nsegments = 0;
       context->grouplist[group].outputsWKC = 0;
       context->grouplist[group].inputsWKC = 0;
@@ -1434,6 +2010,8 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
       {
          configadr = context->slavelist[slave].configadr;
          siLogAddr = soLogAddr = mLogAddr;
+         /* mailbox status is only mapped by the sequential mappers */
+         context->slavelist[slave].mbxstatus = NULL;
 
          if (!group || (group == context->slavelist[slave].group))
          {
@@ -1482,7 +2060,7 @@ int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 grou
 
             ecx_eeprom2pdi(context, slave); /* set Eeprom control to PDI */
             /* User may override automatic state change */
-            if (context->manualstatechange == 0)
+            if ((context->manualstatechange == 0) && !context->warmstart)
             {
                /* request safe_op for slave */
                ecx_FPWRw(context->port,
@@ -1671,6 +2249,14 @@ int ecx_reconfig_slave(ecx_contextt *context, uint16 slave, int timeout)
  */
 int ec_config_init(uint8 usetable)
 {
+   int wkc;
+
+   /* size ec_slave[] to the line before the scan fills it */
+   wkc = ecx_countslaves(&ecx_context);
+   if ((wkc > 0) && (ec_sizeslaves(wkc) == 0))
+   {
+      return EC_SLAVECOUNTEXCEEDED;
+   }
    return ecx_config_init(&ecx_context, usetable);
 }
 
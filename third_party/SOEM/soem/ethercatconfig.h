@@ -33,7 +33,9 @@ int ec_recover_slave(uint16 slave, int timeout);
 int ec_reconfig_slave(uint16 slave, int timeout);
 #endif
 
+int ecx_countslaves(ecx_contextt *context);
 int ecx_config_init(ecx_contextt *context, uint8 usetable);
+void ecx_config_rebase(ecx_contextt *context, void *oldIOmap, int size, void *newIOmap);
 int ecx_config_map_group(ecx_contextt *context, void *pIOmap, uint8 group);
 int ecx_config_overlap_map_group(ecx_contextt *context, void *pIOmap, uint8 group);
 int ecx_config_map_group_aligned(ecx_contextt *context, void *pIOmap, uint8 group);
@@ -272,7 +272,10 @@ boolean ecx_configdc(ecx_contextt *context)
    context->grouplist[0].hasdc = FALSE;
    ht = 0;
 
-   ecx_BWR(context->port, 0, ECT_REG_DCTIME0, sizeof(ht), &ht, EC_TIMEOUTRET);  /* latch DCrecvTimeA of all slaves */
+   if (!context->warmstart)
+   {
+      ecx_BWR(context->port, 0, ECT_REG_DCTIME0, sizeof(ht), &ht, EC_TIMEOUTRET);  /* latch DCrecvTimeA of all slaves */
+   }
    mastertime = osal_current_time();
    mastertime.sec -= 946684800UL;  /* EtherCAT uses 2000-01-01 as epoch start instead of 1970-01-01 */
    mastertime64 = (((uint64)mastertime.sec * 1000000) + (uint64)mastertime.usec) * 1000;
@@ -297,6 +300,11 @@ boolean ecx_configdc(ecx_contextt *context)
          /* this branch has DC slave so remove parenthold */
          parenthold = 0;
          prevDCslave = i;
+         /* warm start keeps running offsets and delays, only build DC chain */
+         if (context->warmstart)
+         {
+            continue;
+         }
          slaveh = context->slavelist[i].configadr;
          (void)ecx_FPRD(context->port, slaveh, ECT_REG_DCTIME0, sizeof(ht), &ht, EC_TIMEOUTRET);
          context->slavelist[i].DCrtA = etohl(ht);
@@ -24,6 +24,8 @@
 
 /** delay in us for eeprom ready loop */
 #define EC_LOCALDELAY  200
+/** max age in us of process data before a mapped mailbox status is ignored */
+#define EC_MBXSTATUSAGE 10000
 
 /** record for ethercat eeprom communications */
 PACKED_BEGIN
@@ -35,6 +37,16 @@ typedef struct PACKED
 } ec_eepromt;
 PACKED_END
 
+/** record for batched eeprom status and data read, registers 0x0502 - 0x050F */
+PACKED_BEGIN
+typedef struct PACKED
+{
+   uint16    estat;
+   uint32    addr;
+   uint64    data;
+} ec_eepromstatt;
+PACKED_END
+
 /** mailbox error structure */
 PACKED_BEGIN
 typedef struct PACKED
@@ -59,12 +71,15 @@ typedef struct PACKED
 PACKED_END
 
 #ifdef EC_VER1
+/** Master record, the whole slave list until ec_config_init() has sized it */
+static ec_slavet        ec_slavemaster;
 /** Main slave data array.
  *  Each slave found on the network gets its own record.
  *  ec_slave[0] is reserved for the master. Structure gets filled
- *  in by the configuration function ec_config().
+ *  in by the configuration function ec_config(). The array is sized
+ *  to the line by ec_sizeslaves().
  */
-ec_slavet               ec_slave[EC_MAXSLAVE];
+ec_slavet               *ec_slave = &ec_slavemaster;
 /** number of slaves found on the network */
 int                     ec_slavecount;
 /** slave group structure */
@@ -99,9 +114,9 @@ ecx_redportt            ecx_redport;
 
 ecx_contextt  ecx_context = {
     &ecx_port,          // .port          =
-    &ec_slave[0],       // .slavelist     =
+    &ec_slavemaster,    // .slavelist     =
     &ec_slavecount,     // .slavecount    =
-    EC_MAXSLAVE,        // .maxslave      =
+    1,                  // .maxslave      =
     &ec_group[0],       // .grouplist     =
     EC_MAXGROUP,        // .maxgroup      =
     &ec_esibuf[0],      // .esibuf        =
@@ -120,6 +135,9 @@ ecx_contextt  ecx_context = {
     NULL,               // .EOEhook()
     0,                  // .manualstatechange
     NULL,               // .userdata
+    NULL,               // .SIIloadhook()
+    NULL,               // .SIIstorehook()
+    0,                  // .warmstart
 };
 #endif
 
@@ -677,42 +695,119 @@ uint32 ecx_siiPDO(ecx_contextt *context, uint16 slave, ec_eepromPDOt* PDO, uint8
    return (Size);
 }
 
-#define MAX_FPRD_MULTI 64
+/** Check if datagram command returns data from the slaves */
+static boolean ecx_batchisread(uint8 com)
+{
+   switch (com)
+   {
+      case EC_CMD_NOP:
+         /* Fall-through */
+      case EC_CMD_APWR:
+         /* Fall-through */
+      case EC_CMD_FPWR:
+         /* Fall-through */
+      case EC_CMD_BWR:
+         /* Fall-through */
+      case EC_CMD_LWR:
+         return FALSE;
+      default:
+         return TRUE;
+   }
+}
 
-int ecx_FPRD_multi(ecx_contextt *context, int n, uint16 *configlst, ec_alstatust *slstatlst, int timeout)
+/** Transmit a batch of acyclic datagrams, packed in as few frames as possible,
+ * and demultiplex the replies. Read data is copied to the buffer of each
+ * datagram and the working counter of each datagram is set in its record.
+ * Datagrams of one frame are processed by the slaves in list order, register
+ * writes become effective at the end of the frame.
+ *
+ * @param[in]     context   = context struct
+ * @param[in]     n         = number of datagrams
+ * @param[in,out] dglst     = datagram list
+ * @param[in]     timeout   = Timeout per frame in us.
+ * @return sum of working counters, EC_NOFRAME if a frame was lost
+ */
+int ecx_batch(ecx_contextt *context, int n, ec_batchdgt *dglst, int timeout)
 {
-   int wkc;
-   uint8 idx;
    ecx_portt *port;
-   uint16 sldatapos[MAX_FPRD_MULTI];
-   int slcnt;
+   ec_batchdgt *dg;
+   uint16 dgpos[EC_MAXBATCH];
+   uint16 wkc16;
+   int first, cnt, i, size, wkc, total;
+   uint8 idx;
 
    port = context->port;
-   idx = ecx_getindex(port);
-   slcnt = 0;
-   ecx_setupdatagram(port, &(port->txbuf[idx]), EC_CMD_FPRD, idx,
-      *(configlst + slcnt), ECT_REG_ALSTAT, sizeof(ec_alstatust), slstatlst + slcnt);
-   sldatapos[slcnt] = EC_HEADERSIZE;
-   while(++slcnt < (n - 1))
+   total = 0;
+   first = 0;
+   while (first < n)
    {
-      sldatapos[slcnt] = ecx_adddatagram(port, &(port->txbuf[idx]), EC_CMD_FPRD, idx, TRUE,
-                            *(configlst + slcnt), ECT_REG_ALSTAT, sizeof(ec_alstatust), slstatlst + slcnt);
-   }
-   if(slcnt < n)
-   {
-      sldatapos[slcnt] = ecx_adddatagram(port, &(port->txbuf[idx]), EC_CMD_FPRD, idx, FALSE,
-                            *(configlst + slcnt), ECT_REG_ALSTAT, sizeof(ec_alstatust), slstatlst + slcnt);
-   }
-   wkc = ecx_srconfirm(port, idx, timeout);
-   if (wkc >= 0)
-   {
-      for(slcnt = 0 ; slcnt < n ; slcnt++)
+      /* number of datagrams that fit in one frame */
+      size = ETH_HEADERSIZE + EC_ELENGTHSIZE;
+      cnt = 0;
+      while ((first + cnt < n) && (cnt < EC_MAXBATCH) &&
+             ((size + EC_HEADERSIZE - EC_ELENGTHSIZE + dglst[first + cnt].length + EC_WKCSIZE) <=
+              (EC_MAXECATFRAME - 4)))
+      {
+         size += EC_HEADERSIZE - EC_ELENGTHSIZE + dglst[first + cnt].length + EC_WKCSIZE;
+         cnt++;
+      }
+      if (cnt == 0)
+      {
+         return EC_NOFRAME; /* datagram does not fit in a frame */
+      }
+      idx = ecx_getindex(port);
+      dg = &dglst[first];
+      ecx_setupdatagram(port, &(port->txbuf[idx]), dg->com, idx, dg->ADP, dg->ADO, dg->length, dg->data);
+      dgpos[0] = EC_HEADERSIZE;
+      for (i = 1; i < cnt; i++)
+      {
+         dg = &dglst[first + i];
+         dgpos[i] = ecx_adddatagram(port, &(port->txbuf[idx]), dg->com, idx, (i < (cnt - 1)),
+                                    dg->ADP, dg->ADO, dg->length, dg->data);
+      }
+      wkc = ecx_srconfirm(port, idx, timeout);
+      for (i = 0; i < cnt; i++)
+      {
+         dg = &dglst[first + i];
+         dg->wkc = 0;
+         if (wkc > EC_NOFRAME)
+         {
+            memcpy(&wkc16, &(port->rxbuf[idx][dgpos[i] + dg->length]), sizeof(wkc16));
+            dg->wkc = etohs(wkc16);
+            total += dg->wkc;
+            if (ecx_batchisread(dg->com))
+            {
+               memcpy(dg->data, &(port->rxbuf[idx][dgpos[i]]), dg->length);
+            }
+         }
+      }
+      ecx_setbufstat(port, idx, EC_BUF_EMPTY);
+      if (wkc <= EC_NOFRAME)
       {
-         memcpy(slstatlst + slcnt, &(port->rxbuf[idx][sldatapos[slcnt]]), sizeof(ec_alstatust));
+         return EC_NOFRAME;
       }
+      first += cnt;
    }
-   ecx_setbufstat(port, idx, EC_BUF_EMPTY);
-   return wkc;
+
+   return total;
+}
+
+#define MAX_FPRD_MULTI 64
+
+int ecx_FPRD_multi(ecx_contextt *context, int n, uint16 *configlst, ec_alstatust *slstatlst, int timeout)
+{
+   ec_batchdgt dg[MAX_FPRD_MULTI];
+   int slcnt;
+
+   for (slcnt = 0; slcnt < n; slcnt++)
+   {
+      dg[slcnt].com = EC_CMD_FPRD;
+      dg[slcnt].ADP = configlst[slcnt];
+      dg[slcnt].ADO = ECT_REG_ALSTAT;
+      dg[slcnt].length = sizeof(ec_alstatust);
+      dg[slcnt].data = slstatlst + slcnt;
+   }
+   return ecx_batch(context, n, dg, timeout);
 }
 
 /** Read all slave states in ec_slave.
@@ -995,6 +1090,32 @@ int ecx_mbxsend(ecx_contextt *context, uint16 slave,ec_mbxbuft *mbx, int timeout
    return wkc;
 }
 
+/** Check the mailbox status mapped into the process data.
+ * @param[in]  context    = context struct
+ * @param[in]  slave      = Slave number
+ * @return TRUE if recent process data shows an empty read mailbox, FALSE if
+ * the mailbox status is not mapped, stale or shows data available
+ */
+static boolean ecx_mbxstatusempty(ecx_contextt *context, uint16 slave)
+{
+   ec_slavet *sl = &(context->slavelist[slave]);
+   ec_timet now;
+   uint64 pdtime;
+
+   if (sl->mbxstatus == NULL)
+   {
+      return FALSE;
+   }
+   pdtime = __atomic_load_n(&(context->grouplist[sl->mbxstatusgroup].pdtime), __ATOMIC_ACQUIRE);
+   now = osal_current_time();
+   if ((pdtime == 0) ||
+       (((uint64)now.sec * 1000000 + now.usec) - pdtime > EC_MBXSTATUSAGE))
+   {
+      return FALSE;
+   }
+   return ((*(sl->mbxstatus) & 0x08) == 0);
+}
+
 /** Read OUT mailbox from slave.
  * Supports Mailbox Link Layer with repeat requests.
  * @param[in]  context    = context struct
@@ -1025,7 +1146,15 @@ int ecx_mbxreceive(ecx_contextt *context, uint16 slave, ec_mbxbuft *mbx, int tim
       do /* wait for read mailbox available */
       {
          SMstat = 0;
-         wkc = ecx_FPRD(context->port, configadr, ECT_REG_SM1STAT, sizeof(SMstat), &SMstat, EC_TIMEOUTRET);
+         /* no need to ask the slave while the cyclic data shows an empty mailbox */
+         if (ecx_mbxstatusempty(context, slave))
+         {
+            wkc = 1;
+         }
+         else
+         {
+            wkc = ecx_FPRD(context->port, configadr, ECT_REG_SM1STAT, sizeof(SMstat), &SMstat, EC_TIMEOUTRET);
+         }
          SMstat = etohs(SMstat);
          if (((SMstat & 0x08) == 0) && (timeout > EC_LOCALDELAY))
          {
@@ -1642,14 +1771,209 @@ uint32 ecx_readeeprom2(ecx_contextt *context, uint16 slave, int timeout)
    return edat;
 }
 
+/** Read EEPROM from a list of slaves bypassing cache, batched. The control
+ * writes and status polls of all slaves share frames so the EEPROM load time
+ * of the slaves overlaps. Slaves that do not answer, report an EEPROM error or
+ * time out fall back to a single ecx_readeepromFP.
+ * @param[in]  context   = context struct
+ * @param[in]  n         = number of slaves in list
+ * @param[in]  slavelst  = slave numbers
+ * @param[in]  addrlst   = (WORD) EEPROM address per slave
+ * @param[out] datalst   = EEPROM data per slave, 8 bytes if the slave supports it, otherwise 4
+ * @param[in]  timeout   = Timeout in us.
+ * @return number of slaves read in batched frames
+ */
+int ecx_readeeprom_multi(ecx_contextt *context, int n, const uint16 *slavelst, const uint16 *addrlst, uint64 *datalst, int timeout)
+{
+   ec_batchdgt dg[EC_MAXBATCH];
+   ec_eepromt ed[EC_MAXBATCH];
+   ec_eepromstatt es[EC_MAXBATCH];
+   uint8 dgmap[EC_MAXBATCH];
+   uint8 pending[EC_MAXBATCH];
+   osal_timert timer;
+   uint16 estat, clear;
+   int i, cnt, polls, nread;
+
+   if (n > EC_MAXBATCH)
+   {
+      nread = ecx_readeeprom_multi(context, EC_MAXBATCH, slavelst, addrlst, datalst, timeout);
+      return nread + ecx_readeeprom_multi(context, n - EC_MAXBATCH, slavelst + EC_MAXBATCH,
+                                          addrlst + EC_MAXBATCH, datalst + EC_MAXBATCH, timeout);
+   }
+   nread = 0;
+   for (i = 0; i < n; i++)
+   {
+      ecx_eeprom2master(context, slavelst[i]); /* set eeprom control to master */
+      datalst[i] = 0;
+      pending[i] = 1;
+   }
+
+   /* wait until eeprom of all slaves is idle, clear error bits */
+   clear = htoes(EC_ECMD_NOP);
+   osal_timer_start(&timer, timeout);
+   polls = 0;
+   do
+   {
+      if (polls++)
+      {
+         osal_usleep(EC_LOCALDELAY);
+      }
+      for (i = 0, cnt = 0; i < n; i++)
+      {
+         if (pending[i] == 1)
+         {
+            dg[cnt].com = EC_CMD_FPRD;
+            dg[cnt].ADP = context->slavelist[slavelst[i]].configadr;
+            dg[cnt].ADO = ECT_REG_EEPSTAT;
+            dg[cnt].length = sizeof(ec_eepromstatt);
+            dg[cnt].data = &es[i];
+            dgmap[cnt++] = (uint8)i;
+         }
+      }
+      ecx_batch(context, cnt, dg, EC_TIMEOUTRET);
+      for (i = 0; i < cnt; i++)
+      {
+         estat = etohs(es[dgmap[i]].estat);
+         if (dg[i].wkc && !(estat & EC_ESTAT_BUSY))
+         {
+            pending[dgmap[i]] = (estat & EC_ESTAT_EMASK) ? 3 : 2;
+         }
+      }
+      for (i = 0, cnt = 0; i < n; i++)
+      {
+         if (pending[i] == 3)
+         {
+            dg[cnt].com = EC_CMD_FPWR;
+            dg[cnt].ADP = context->slavelist[slavelst[i]].configadr;
+            dg[cnt].ADO = ECT_REG_EEPCTL;
+            dg[cnt].length = sizeof(clear);
+            dg[cnt++].data = &clear;
+            pending[i] = 2;
+         }
+      }
+      if (cnt)
+      {
+         ecx_batch(context, cnt, dg, EC_TIMEOUTRET3);
+      }
+      for (i = 0, cnt = 0; i < n; i++)
+      {
+         cnt += (pending[i] == 1);
+      }
+   }
+   while (cnt && (osal_timer_is_expired(&timer) == FALSE));
+
+   /* read command to all idle slaves in one frame */
+   for (i = 0, cnt = 0; i < n; i++)
+   {
+      if (pending[i] == 2)
+      {
+         ed[i].comm = htoes(EC_ECMD_READ);
+         ed[i].addr = htoes(addrlst[i]);
+         ed[i].d2   = 0x0000;
+         dg[cnt].com = EC_CMD_FPWR;
+         dg[cnt].ADP = context->slavelist[slavelst[i]].configadr;
+         dg[cnt].ADO = ECT_REG_EEPCTL;
+         dg[cnt].length = sizeof(ec_eepromt);
+         dg[cnt].data = &ed[i];
+         dgmap[cnt++] = (uint8)i;
+      }
+   }
+   if (cnt)
+   {
+      ecx_batch(context, cnt, dg, EC_TIMEOUTRET);
+   }
+   for (i = 0; i < cnt; i++)
+   {
+      pending[dgmap[i]] = dg[i].wkc ? 4 : 1;
+   }
+
+   /* poll status and data of all slaves together */
+   osal_timer_start(&timer, timeout);
+   while (cnt && (osal_timer_is_expired(&timer) == FALSE))
+   {
+      osal_usleep(EC_LOCALDELAY);
+      for (i = 0, cnt = 0; i < n; i++)
+      {
+         if (pending[i] == 4)
+         {
+            dg[cnt].com = EC_CMD_FPRD;
+            dg[cnt].ADP = context->slavelist[slavelst[i]].configadr;
+            dg[cnt].ADO = ECT_REG_EEPSTAT;
+            dg[cnt].length = sizeof(ec_eepromstatt);
+            dg[cnt].data = &es[i];
+            dgmap[cnt++] = (uint8)i;
+         }
+      }
+      if (cnt)
+      {
+         ecx_batch(context, cnt, dg, EC_TIMEOUTRET);
+      }
+      for (i = 0; i < cnt; i++)
+      {
+         estat = etohs(es[dgmap[i]].estat);
+         if (dg[i].wkc && !(estat & EC_ESTAT_BUSY))
+         {
+            if (estat & EC_ESTAT_NACK)
+            {
+               pending[dgmap[i]] = 1; /* retry with single read */
+            }
+            else
+            {
+               datalst[dgmap[i]] = es[dgmap[i]].data;
+               if (!(estat & EC_ESTAT_R64))
+               {
+                  datalst[dgmap[i]] &= 0xffffffff;
+               }
+               pending[dgmap[i]] = 0;
+               nread++;
+            }
+         }
+      }
+      for (i = 0, cnt = 0; i < n; i++)
+      {
+         cnt += (pending[i] == 4);
+      }
+   }
+
+   /* slaves that did not complete in the batch */
+   for (i = 0; i < n; i++)
+   {
+      if (pending[i])
+      {
+         datalst[i] = ecx_readeepromFP(context, context->slavelist[slavelst[i]].configadr,
+                                       addrlst[i], timeout);
+      }
+   }
+
+   return nread;
+}
+
+/** Define SII cache hooks. The load hook is called during ecx_config_init
+ * before the SII of a slave is parsed, the store hook after parsing.
+ *
+ * @param[in]  context        = context struct
+ * @param[in]  loadhook       = Pointer to load hook function, NULL to disable.
+ * @param[in]  storehook      = Pointer to store hook function, NULL to disable.
+ * @return 1
+ */
+int ecx_SIIdefinehook(ecx_contextt *context, void *loadhook, void *storehook)
+{
+   context->SIIloadhook = loadhook;
+   context->SIIstorehook = storehook;
+   return 1;
+}
+
 /** Push index of segmented LRD/LWR/LRW combination.
  * @param[in]  context        = context struct
  * @param[in] idx         = Used datagram index.
  * @param[in] data        = Pointer to process data segment.
  * @param[in] length      = Length of data segment in bytes.
  * @param[in] DCO         = Offset position of DC frame.
+ * @param[in] ASO         = Offset position of AL status BRD, 0 if none.
+ * @param[in] group       = group the frame belongs to.
  */
-static void ecx_pushindex(ecx_contextt *context, uint8 idx, void *data, uint16 length, uint16 DCO)
+static void ecx_pushindex(ecx_contextt *context, uint8 idx, void *data, uint16 length, uint16 DCO, uint16 ASO,
+   uint8 group)
 {
    if(context->idxstack->pushed < EC_MAXBUF)
    {
@@ -1657,6 +1981,8 @@ static void ecx_pushindex(ecx_contextt *context, uint8 idx, void *data, uint16 l
       context->idxstack->data[context->idxstack->pushed] = data;
       context->idxstack->length[context->idxstack->pushed] = length;
       context->idxstack->dcoffset[context->idxstack->pushed] = DCO;
+      context->idxstack->alstatoffset[context->idxstack->pushed] = ASO;
+      context->idxstack->group[context->idxstack->pushed] = group;
       context->idxstack->pushed++;
    }
 }
@@ -1689,6 +2015,83 @@ static void ecx_clearindex(ecx_contextt *context)  {
 
 }
 
+/** Append a BRD of AL status to a process data frame if it fits.
+ * Every slave ORs its AL status into the datagram, the working counter
+ * tells how many slaves answered.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  idx            = index of the frame
+ * @param[in]  more           = TRUE if the FPRMW datagram still follows
+ * @return Offset of the BRD data in the rx frame, 0 if the frame is full.
+ */
+static uint16 ecx_addalstat(ecx_contextt *context, uint8 group, uint8 idx, boolean more)
+{
+   int size;
+
+   size = context->port->txbuflength[idx] + EC_HEADERSIZE - EC_ELENGTHSIZE + sizeof(uint16) + EC_WKCSIZE;
+   if (more)
+   {
+      size += EC_FIRSTDCDATAGRAM;
+   }
+   if (size > (EC_MAXECATFRAME - 4))
+   {
+      return 0;
+   }
+   return ecx_adddatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_BRD, idx, more,
+                          0x0000, ECT_REG_ALSTAT, sizeof(uint16), &(context->grouplist[group].alstatus));
+}
+
+/** Send a process data frame and push it on the index stack, or when a group
+ * is being frozen keep it as a prebuilt frame and reserve its index.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @param[in]  idx            = index of the frame
+ * @param[in]  txdata         = IOmap section copied into the datagram
+ * @param[in]  rxdata         = IOmap section the returned datagram is copied to
+ * @param[in]  length         = datagram data length
+ * @param[in]  DCO            = offset of the DC time in the frame, 0 if none
+ * @param[in]  ASO            = offset of the AL status in the frame, 0 if none
+ * @param[in]  freeze         = TRUE to keep the frame instead of sending it
+ */
+static void ecx_queueframe(ecx_contextt *context, uint8 group, uint8 idx, uint8 *txdata, uint8 *rxdata,
+   uint16 length, uint16 DCO, uint16 ASO, boolean freeze)
+{
+   ec_groupt *grp;
+   ec_frozenframet *frame;
+   uint8 *outend;
+
+   if (!freeze)
+   {
+      /* send frame */
+      ecx_outframe_red(context->port, idx);
+      /* push index and data pointer on stack */
+      ecx_pushindex(context, idx, rxdata, length, DCO, ASO, group);
+      return;
+   }
+
+   grp = &(context->grouplist[group]);
+   if (grp->nfrozen >= EC_MAXFROZEN)
+   {
+      /* too many frames, ecx_freeze_processdata_group gives up and releases the others */
+      grp->nfrozen = EC_MAXFROZEN + 1;
+      ecx_setbufstat(context->port, idx, EC_BUF_EMPTY);
+      return;
+   }
+   frame = &(grp->frozen[grp->nfrozen++]);
+   frame->idx = idx;
+   frame->txdata = txdata;
+   /* only the part of the datagram that carries outputs has to be refreshed */
+   outend = grp->outputs + grp->Obytes;
+   frame->txlength = (grp->Obytes && (txdata < outend)) ?
+      (uint16)(((txdata + length) < outend) ? length : (outend - txdata)) : 0;
+   frame->rxdata = rxdata;
+   frame->length = length;
+   frame->dcoffset = DCO;
+   frame->alstatoffset = ASO;
+   context->idxstack->frozen |= (uint32)1 << idx;
+   ecx_setbufstat(context->port, idx, EC_BUF_FROZEN);
+}
+
 /** Transmit processdata to slaves.
  * Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
  * Both the input and output processdata are transmitted.
@@ -1700,9 +2103,11 @@ static void ecx_clearindex(ecx_contextt *context)  {
  * @param[in]  context        = context struct
  * @param[in]  group          = group number
  * @param[in]  use_overlap_io = flag if overlapped iomap is used
+ * @param[in]  freeze         = build the frames for ecx_freeze_processdata_group() only
  * @return >0 if processdata is transmitted.
  */
-static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean use_overlap_io)
+static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean use_overlap_io,
+   boolean freeze)
 {
    uint32 LogAdr;
    uint16 w1, w2;
@@ -1715,12 +2120,15 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
    uint16 currentsegment = 0;
    uint32 iomapinputoffset;
    uint16 DCO;
+   uint16 ASO;
+   boolean supervise;
 
    wkc = 0;
    if(context->grouplist[group].hasdc)
    {
       first = TRUE;
    }
+   supervise = context->grouplist[group].supervise;
 
    /* For overlapping IO map use the biggest */
    if(use_overlap_io == TRUE)
@@ -1769,6 +2177,12 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                w2 = HI_WORD(LogAdr);
                DCO = 0;
                ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LRD, idx, w1, w2, sublength, data);
+               ASO = 0;
+               if(supervise)
+               {
+                  ASO = ecx_addalstat(context, group, idx, first);
+                  supervise = (ASO == 0);
+               }
                if(first)
                {
                   /* FPRMW in second datagram */
@@ -1777,10 +2191,7 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                                            ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
                   first = FALSE;
                }
-               /* send frame */
-               ecx_outframe_red(context->port, idx);
-               /* push index and data pointer on stack */
-               ecx_pushindex(context, idx, data, sublength, DCO);
+               ecx_queueframe(context, group, idx, data, data, sublength, DCO, ASO, freeze);
                length -= sublength;
                LogAdr += sublength;
                data += sublength;
@@ -1807,6 +2218,12 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                w2 = HI_WORD(LogAdr);
                DCO = 0;
                ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LWR, idx, w1, w2, sublength, data);
+               ASO = 0;
+               if(supervise)
+               {
+                  ASO = ecx_addalstat(context, group, idx, first);
+                  supervise = (ASO == 0);
+               }
                if(first)
                {
                   /* FPRMW in second datagram */
@@ -1815,10 +2232,7 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                                            ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
                   first = FALSE;
                }
-               /* send frame */
-               ecx_outframe_red(context->port, idx);
-               /* push index and data pointer on stack */
-               ecx_pushindex(context, idx, data, sublength, DCO);
+               ecx_queueframe(context, group, idx, data, data, sublength, DCO, ASO, freeze);
                length -= sublength;
                LogAdr += sublength;
                data += sublength;
@@ -1848,6 +2262,12 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
             w2 = HI_WORD(LogAdr);
             DCO = 0;
             ecx_setupdatagram(context->port, &(context->port->txbuf[idx]), EC_CMD_LRW, idx, w1, w2, sublength, data);
+            ASO = 0;
+            if(supervise)
+            {
+               ASO = ecx_addalstat(context, group, idx, first);
+               supervise = (ASO == 0);
+            }
             if(first)
             {
                /* FPRMW in second datagram */
@@ -1856,14 +2276,12 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
                                         ECT_REG_DCSYSTIME, sizeof(int64), context->DCtime);
                first = FALSE;
             }
-            /* send frame */
-            ecx_outframe_red(context->port, idx);
-            /* push index and data pointer on stack.
+            /* send frame and push index and data pointer on stack.
              * the iomapinputoffset compensate for where the inputs are stored 
              * in the IOmap if we use an overlapping IOmap. If a regular IOmap
              * is used it should always be 0.
              */
-            ecx_pushindex(context, idx, (data + iomapinputoffset), sublength, DCO);      
+            ecx_queueframe(context, group, idx, data, (data + iomapinputoffset), sublength, DCO, ASO, freeze);
             length -= sublength;
             LogAdr += sublength;
             data += sublength;
@@ -1888,7 +2306,7 @@ static int ecx_main_send_processdata(ecx_contextt *context, uint8 group, boolean
 */
 int ecx_send_overlap_processdata_group(ecx_contextt *context, uint8 group)
 {
-   return ecx_main_send_processdata(context, group, TRUE);
+   return ecx_main_send_processdata(context, group, TRUE, FALSE);
 }
 
 /** Transmit processdata to slaves.
@@ -1905,13 +2323,166 @@ int ecx_send_overlap_processdata_group(ecx_contextt *context, uint8 group)
 */
 int ecx_send_processdata_group(ecx_contextt *context, uint8 group)
 {
-   return ecx_main_send_processdata(context, group, FALSE);
+   return ecx_main_send_processdata(context, group, FALSE, FALSE);
+}
+
+/** Build the cyclic frames of a group once, for a line whose topology and
+ * mapping no longer change. The frames keep their frame index for good, and
+ * ecx_send_frozen_processdata_group() then only refreshes the outputs and the
+ * working counters before handing each frame to the NIC. If the group fits in
+ * a single LRW frame, the slaves' input pointers are moved into the receive
+ * buffer of that frame. The inputs are then read in place and are not copied
+ * back into the IOmap. Call again after every remap, and
+ * ecx_unfreeze_processdata_group() before the IOmap is freed.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @return number of prebuilt frames, 0 if the group cannot be frozen.
+ */
+int ecx_freeze_processdata_group(ecx_contextt *context, uint8 group)
+{
+   ec_groupt *grp;
+   ec_frozenframet *frame;
+   uint8 *rx;
+   uint8 *start;
+   uint8 *end;
+   uint16 slave;
+
+   ecx_unfreeze_processdata_group(context, group);
+   grp = &(context->grouplist[group]);
+   ecx_main_send_processdata(context, group, grp->overlapio, TRUE);
+   if (grp->nfrozen > EC_MAXFROZEN)
+   {
+      grp->nfrozen = EC_MAXFROZEN;
+      ecx_unfreeze_processdata_group(context, group);
+      return 0;
+   }
+
+   frame = &(grp->frozen[0]);
+   if ((grp->nfrozen == 1) && grp->Ibytes &&
+       (context->port->txbuf[frame->idx][ETH_HEADERSIZE + EC_CMDOFFSET] == EC_CMD_LRW))
+   {
+      /* IOmap section of the datagram and where the same bytes arrive in the rx buffer */
+      start = frame->rxdata;
+      end = start + frame->length;
+      rx = &(context->port->rxbuf[frame->idx][EC_HEADERSIZE]);
+      memcpy(rx, start, frame->length);
+      grp->inputalias = rx - start;
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         ec_slavet *sl = &(context->slavelist[slave]);
+         if ((sl->group == group) && sl->inputs && (sl->inputs >= start) && (sl->inputs < end))
+         {
+            sl->inputs += grp->inputalias;
+            if (sl->mbxstatus && (sl->mbxstatus >= start) && (sl->mbxstatus < end))
+            {
+               sl->mbxstatus += grp->inputalias;
+            }
+         }
+      }
+      grp->inputs += grp->inputalias;
+      frame->rxdata = NULL;
+   }
+
+   return grp->nfrozen;
+}
+
+/** Release the prebuilt frames of a group and move aliased inputs back into the IOmap.
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ */
+void ecx_unfreeze_processdata_group(ecx_contextt *context, uint8 group)
+{
+   ec_groupt *grp;
+   uint8 *start;
+   uint8 *end;
+   uint16 slave;
+   int i;
+
+   grp = &(context->grouplist[group]);
+   if (grp->inputalias)
+   {
+      /* keep the last inputs, then point everything back at the IOmap */
+      start = &(context->port->rxbuf[grp->frozen[0].idx][EC_HEADERSIZE]);
+      end = start + grp->frozen[0].length;
+      memcpy(start - grp->inputalias, start, grp->frozen[0].length);
+      for (slave = 1; slave <= *(context->slavecount); slave++)
+      {
+         ec_slavet *sl = &(context->slavelist[slave]);
+         if ((sl->group == group) && sl->inputs && (sl->inputs >= start) && (sl->inputs < end))
+         {
+            sl->inputs -= grp->inputalias;
+            if (sl->mbxstatus && (sl->mbxstatus >= start) && (sl->mbxstatus < end))
+            {
+               sl->mbxstatus -= grp->inputalias;
+            }
+         }
+      }
+      grp->inputs -= grp->inputalias;
+      grp->inputalias = 0;
+   }
+   for (i = 0; i < grp->nfrozen; i++)
+   {
+      context->idxstack->frozen &= ~((uint32)1 << grp->frozen[i].idx);
+      ecx_setbufstat(context->port, grp->frozen[i].idx, EC_BUF_EMPTY);
+   }
+   grp->nfrozen = 0;
+}
+
+/** Send the prebuilt frames of a frozen group. Each frame only gets its
+ * outputs refreshed, its working counters and AL status cleared, and goes
+ * out as it was built. Receive with ecx_receive_processdata_group().
+ * @param[in]  context        = context struct
+ * @param[in]  group          = group number
+ * @return >0 if processdata is transmitted.
+ */
+int ecx_send_frozen_processdata_group(ecx_contextt *context, uint8 group)
+{
+   ec_groupt *grp;
+   ec_frozenframet *frame;
+   uint8 *buf;
+   uint16 dlength;
+   int pos;
+   int i;
+
+   grp = &(context->grouplist[group]);
+   for (i = 0; i < grp->nfrozen; i++)
+   {
+      frame = &(grp->frozen[i]);
+      buf = (uint8 *)&(context->port->txbuf[frame->idx]);
+      if (frame->txlength)
+      {
+         memcpy(&buf[ETH_HEADERSIZE + EC_HEADERSIZE], frame->txdata, frame->txlength);
+      }
+      /* working counters of all datagrams back to 0, a redundant resend may have copied them in */
+      pos = ETH_HEADERSIZE + EC_ELENGTHSIZE;
+      do
+      {
+         /* datagrams after the first have no elength, shift the header view accordingly */
+         dlength = etohs(((ec_comt *)&buf[pos - EC_ELENGTHSIZE])->dlength);
+         pos += EC_HEADERSIZE - EC_ELENGTHSIZE + (dlength & 0x07ff);
+         buf[pos] = 0;
+         buf[pos + 1] = 0;
+         pos += EC_WKCSIZE;
+      } while ((dlength & EC_DATAGRAMFOLLOWS) && (pos < context->port->txbuflength[frame->idx]));
+      if (frame->alstatoffset)
+      {
+         /* slaves OR their AL status into the BRD data */
+         memset(&buf[ETH_HEADERSIZE + frame->alstatoffset], 0, sizeof(uint16));
+      }
+      ecx_outframe_red(context->port, frame->idx);
+      ecx_pushindex(context, frame->idx, frame->rxdata, frame->length, frame->dcoffset,
+                    frame->alstatoffset, group);
+   }
+
+   return grp->nfrozen ? 1 : 0;
 }
 
 /** Receive processdata from slaves.
  * Second part from ec_send_processdata().
  * Received datagrams are recombined with the processdata with help from the stack.
  * If a datagram contains input processdata it copies it to the processdata structure.
+ * All frames sent since the last receive are collected, also those of other groups
+ * sent back to back, and the work counter is the sum over all of them.
  * @param[in]  context        = context struct
  * @param[in]  group          = group number
  * @param[in]  timeout        = Timeout in us.
@@ -1925,11 +2496,16 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
    uint16 le_wkc = 0;
    int valid_wkc = 0;
    int64 le_DCtime;
+   uint8 fgroup;
+   uint32 groupsseen = 0;
+   uint32 groupspulled = 0;
+   int path;
+   ec_timet now;
    ec_idxstackT *idxstack;
    ec_bufT *rxbuf;
 
-   /* just to prevent compiler warning for unused group */
-   wkc2 = group;
+   /* alarms and timestamps go to the group each frame was sent for */
+   (void)group;
 
    idxstack = context->idxstack;
    rxbuf = context->port->rxbuf;
@@ -1939,48 +2515,66 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
    while (pos >= 0)
    {
       idx = idxstack->idx[pos];
+      fgroup = idxstack->group[pos];
       wkc2 = ecx_waitinframe(context->port, idx, timeout);
+      /* the worst return path of its frames is the group's path this cycle */
+      path = context->port->rxpath[idx];
+      if ((fgroup < 32) && !(groupspulled & ((uint32)1 << fgroup)))
+      {
+         groupspulled |= (uint32)1 << fgroup;
+         context->grouplist[fgroup].rxpath = path;
+      }
+      else if (path > context->grouplist[fgroup].rxpath)
+      {
+         context->grouplist[fgroup].rxpath = path;
+      }
       /* check if there is input data in frame */
       if (wkc2 > EC_NOFRAME)
       {
+         if (fgroup < 32)
+         {
+            groupsseen |= (uint32)1 << fgroup;
+         }
+         /* with a DC or AL status datagram behind it the process data is not
+            the last datagram, its WKC must be read from the frame */
+         if ((idxstack->dcoffset[pos] > 0) || (idxstack->alstatoffset[pos] > 0))
+         {
+            memcpy(&le_wkc, &(rxbuf[idx][EC_HEADERSIZE + idxstack->length[pos]]), EC_WKCSIZE);
+            wkc2 = etohs(le_wkc);
+         }
          if((rxbuf[idx][EC_CMDOFFSET]==EC_CMD_LRD) || (rxbuf[idx][EC_CMDOFFSET]==EC_CMD_LRW))
          {
-            if(idxstack->dcoffset[pos] > 0)
+            /* copy input data back to process data buffer, frozen frames with
+               aliased inputs are read in place */
+            if (idxstack->data[pos])
             {
                memcpy(idxstack->data[pos], &(rxbuf[idx][EC_HEADERSIZE]), idxstack->length[pos]);
-               memcpy(&le_wkc, &(rxbuf[idx][EC_HEADERSIZE + idxstack->length[pos]]), EC_WKCSIZE);
-               wkc = etohs(le_wkc);
-               memcpy(&le_DCtime, &(rxbuf[idx][idxstack->dcoffset[pos]]), sizeof(le_DCtime));
-               *(context->DCtime) = etohll(le_DCtime);
-            }
-            else
-            {
-               /* copy input data back to process data buffer */
-               memcpy(idxstack->data[pos], &(rxbuf[idx][EC_HEADERSIZE]), idxstack->length[pos]);
-               wkc += wkc2;
             }
+            wkc += wkc2;
             valid_wkc = 1;
          }
          else if(rxbuf[idx][EC_CMDOFFSET]==EC_CMD_LWR)
          {
-            if(idxstack->dcoffset[pos] > 0)
-            {
-               memcpy(&le_wkc, &(rxbuf[idx][EC_HEADERSIZE + idxstack->length[pos]]), EC_WKCSIZE);
-               /* output WKC counts 2 times when using LRW, emulate the same for LWR */
-               wkc = etohs(le_wkc) * 2;
-               memcpy(&le_DCtime, &(rxbuf[idx][idxstack->dcoffset[pos]]), sizeof(le_DCtime));
-               *(context->DCtime) = etohll(le_DCtime);
-            }
-            else
-            {
-               /* output WKC counts 2 times when using LRW, emulate the same for LWR */
-               wkc += wkc2 * 2;
-            }
+            /* output WKC counts 2 times when using LRW, emulate the same for LWR */
+            wkc += wkc2 * 2;
             valid_wkc = 1;
          }
+         if(idxstack->dcoffset[pos] > 0)
+         {
+            memcpy(&le_DCtime, &(rxbuf[idx][idxstack->dcoffset[pos]]), sizeof(le_DCtime));
+            *(context->DCtime) = etohll(le_DCtime);
+         }
+         if(idxstack->alstatoffset[pos] > 0)
+         {
+            memcpy(&le_wkc, &(rxbuf[idx][idxstack->alstatoffset[pos]]), sizeof(uint16));
+            context->grouplist[fgroup].alstatus = etohs(le_wkc);
+            memcpy(&le_wkc, &(rxbuf[idx][idxstack->alstatoffset[pos] + sizeof(uint16)]), EC_WKCSIZE);
+            context->grouplist[fgroup].alstatuswkc = etohs(le_wkc);
+         }
       }
-      /* release buffer */
-      ecx_setbufstat(context->port, idx, EC_BUF_EMPTY);
+      /* release buffer, a frozen frame keeps its index */
+      ecx_setbufstat(context->port, idx,
+                     (idxstack->frozen & ((uint32)1 << idx)) ? EC_BUF_FROZEN : EC_BUF_EMPTY);
       /* get next index */
       pos = ecx_pullindex(context);
    }
@@ -1992,6 +2586,15 @@ int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeou
    {
       return EC_NOFRAME;
    }
+   now = osal_current_time();
+   for (fgroup = 0; (fgroup < context->maxgroup) && (fgroup < 32); fgroup++)
+   {
+      if (groupsseen & ((uint32)1 << fgroup))
+      {
+         __atomic_store_n(&(context->grouplist[fgroup].pdtime),
+                          (uint64)now.sec * 1000000 + now.usec, __ATOMIC_RELEASE);
+      }
+   }
    return wkc;
 }
 
@@ -2053,6 +2656,39 @@ int ec_init_redundant(const char *ifname, char *if2name)
    return ecx_init_redundant (&ecx_context, &ecx_redport, ifname, if2name);
 }
 
+/** Size ec_slave[] for a line of slavecount slaves plus the master record.
+ * The array only grows, so records handed out before a rescan stay valid
+ * until the next call. Not freed by ec_close(), the master record is
+ * still read after closing.
+ * @param[in]  slavecount = number of slaves on the line
+ * @return number of records in ec_slave[], 0 if out of memory
+ */
+int ec_sizeslaves(int slavecount)
+{
+   ec_slavet *list;
+   int records = slavecount + 1;
+
+   if (records <= ecx_context.maxslave)
+   {
+      return ecx_context.maxslave;
+   }
+   list = (ec_slavet *)osal_malloc(sizeof(ec_slavet) * records);
+   if (list == NULL)
+   {
+      return 0;
+   }
+   memset(list, 0x00, sizeof(ec_slavet) * records);
+   list[0] = ec_slave[0];
+   if (ec_slave != &ec_slavemaster)
+   {
+      osal_free(ec_slave);
+   }
+   ec_slave = list;
+   ecx_context.slavelist = list;
+   ecx_context.maxslave = records;
+   return records;
+}
+
 /** Close lib.
  * @see ecx_close
  */
@@ -2350,6 +2986,43 @@ uint32 ec_readeeprom2(uint16 slave, int timeout)
    return ecx_readeeprom2 (&ecx_context, slave, timeout);
 }
 
+/** Read EEPROM from a list of slaves bypassing cache, batched.
+ * @param[in]  n         = number of slaves in list
+ * @param[in]  slavelst  = slave numbers
+ * @param[in]  addrlst   = (WORD) EEPROM address per slave
+ * @param[out] datalst   = EEPROM data per slave
+ * @param[in]  timeout   = Timeout in us.
+ * @return number of slaves read in batched frames
+ * @see ecx_readeeprom_multi
+ */
+int ec_readeeprom_multi(int n, const uint16 *slavelst, const uint16 *addrlst, uint64 *datalst, int timeout)
+{
+   return ecx_readeeprom_multi(&ecx_context, n, slavelst, addrlst, datalst, timeout);
+}
+
+/** Transmit a batch of acyclic datagrams in as few frames as possible.
+ * @param[in]     n         = number of datagrams
+ * @param[in,out] dglst     = datagram list
+ * @param[in]     timeout   = Timeout per frame in us.
+ * @return sum of working counters, EC_NOFRAME if a frame was lost
+ * @see ecx_batch
+ */
+int ec_batch(int n, ec_batchdgt *dglst, int timeout)
+{
+   return ecx_batch(&ecx_context, n, dglst, timeout);
+}
+
+/** Define SII cache hooks.
+ * @param[in]  loadhook       = Pointer to load hook function.
+ * @param[in]  storehook      = Pointer to store hook function.
+ * @return 1
+ * @see ecx_SIIdefinehook
+ */
+int ec_SIIdefinehook(void *loadhook, void *storehook)
+{
+   return ecx_SIIdefinehook(&ecx_context, loadhook, storehook);
+}
+
 /** Transmit processdata to slaves.
  * Uses LRW, or LRD/LWR if LRW is not allowed (blockLRW).
  * Both the input and output processdata are transmitted.
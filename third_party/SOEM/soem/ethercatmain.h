@@ -24,9 +24,11 @@ extern "C"
 /** max. number of slaves in array */
 #define EC_MAXSLAVE       200
 /** max. number of groups */
-#define EC_MAXGROUP       2
+#define EC_MAXGROUP       8
 /** max. number of IO segments per group */
 #define EC_MAXIOSEGMENTS  64
+/** max. prebuilt frames of a frozen group */
+#define EC_MAXFROZEN      4
 /** max. mailbox size */
 #define EC_MAXMBX         1486
 /** max. eeprom PDO entries */
@@ -102,6 +104,29 @@ PACKED_END
 
 typedef struct ecx_context ecx_contextt;
 
+/** SII data of one slave as parsed by ecx_config_init, kept by an application
+ *  SII cache. Identity and checksum are filled in by SOEM before lookup.
+ */
+typedef struct ec_siicache
+{
+   uint32           man;
+   uint32           id;
+   uint32           rev;
+   uint16           crc;
+   uint8            CoEdetails;
+   uint8            FoEdetails;
+   uint8            EoEdetails;
+   uint8            SoEdetails;
+   uint8            blockLRW;
+   int16            Ebuscurrent;
+   char             name[EC_MAXNAME + 1];
+   ec_smt           SM[EC_MAXSM];
+   uint8            FMMU0func;
+   uint8            FMMU1func;
+   uint8            FMMU2func;
+   uint8            FMMU3func;
+} ec_siicachet;
+
 /** for list of ethercat slaves detected */
 typedef struct ec_slave
 {
@@ -119,6 +144,8 @@ typedef struct ec_slave
    uint32           eep_id;
    /** revision from EEprom */
    uint32           eep_rev;
+   /** checksum of EEprom configuration area */
+   uint16           eep_crc;
    /** Interface type */
    uint16           Itype;
    /** Device type */
@@ -153,6 +180,8 @@ typedef struct ec_slave
    uint8            FMMU2func;
    /** FMMU3 function */
    uint8            FMMU3func;
+   /** number of FMMUs in the ESC */
+   uint8            FMMUsupported;
    /** length of write mailbox in bytes, if no mailbox then 0 */
    uint16           mbx_l;
    /** mailbox write offset */
@@ -163,6 +192,10 @@ typedef struct ec_slave
    uint16           mbx_ro;
    /** mailbox supported protocols */
    uint16           mbx_proto;
+   /** SM1 status byte mapped in IOmap, NULL if the read mailbox is polled */
+   uint8            *mbxstatus;
+   /** group whose process data carries mbxstatus */
+   uint8            mbxstatusgroup;
    /** Counter value of mailbox link layer protocol 1..7 */
    uint8            mbx_cnt;
    /** has DC capability */
@@ -235,6 +268,24 @@ typedef struct ec_slave
    char             name[EC_MAXNAME + 1];
 } ec_slavet;
 
+/** Prebuilt process data frame of a frozen group, see ecx_freeze_processdata_group() */
+typedef struct ec_frozenframe
+{
+   /** frame index reserved for this frame */
+   uint8            idx;
+   /** outputs patched into the frame before each send */
+   uint8            *txdata;
+   uint16           txlength;
+   /** where the returned datagram is copied, NULL if the inputs alias the rx buffer */
+   uint8            *rxdata;
+   /** datagram data length */
+   uint16           length;
+   /** offset of the DC time in the rx frame, 0 if none */
+   uint16           dcoffset;
+   /** offset of the AL status BRD data in the rx frame, 0 if none */
+   uint16           alstatoffset;
+} ec_frozenframet;
+
 /** for list of ethercat slave groups */
 typedef struct ec_group
 {
@@ -268,6 +319,27 @@ typedef struct ec_group
    uint16           inputsWKC;
    /** check slave states */
    boolean          docheckstate;
+   /** time process data of this group was last received, in us. One word,
+    *  stored and loaded atomically as the mailbox reads it from another thread */
+   uint64           pdtime;
+   /** if TRUE the first process data frame carries a BRD of AL status */
+   boolean          supervise;
+   /** AL status of all slaves ORed together, from the last process data frame */
+   uint16           alstatus;
+   /** number of slaves that answered the AL status BRD */
+   uint16           alstatuswkc;
+   /** application cycles per process data exchange of this group, 0 = not cycled */
+   uint16           cycledivisor;
+   /** worst EC_RXPATH_* of the group's frames in the last process data receive */
+   int              rxpath;
+   /** mapped with ecx_config_overlap_map_group(), send with the overlap variant */
+   boolean          overlapio;
+   /** number of prebuilt cyclic frames, 0 if the group is built every cycle */
+   uint8            nfrozen;
+   /** prebuilt cyclic frames */
+   ec_frozenframet  frozen[EC_MAXFROZEN];
+   /** distance the slaves' input pointers were moved into the rx buffer, 0 if not aliased */
+   ptrdiff_t        inputalias;
    /** IO segmentation list. Datagrams must not break SM in two. */
    uint32           IOsegment[EC_MAXIOSEGMENTS];
 } ec_groupt;
@@ -322,6 +394,26 @@ typedef struct PACKED ec_mbxheader
 } ec_mbxheadert;
 PACKED_END
 
+/** max number of datagrams in one frame of an acyclic batch */
+#define EC_MAXBATCH       128
+
+/** one datagram of an acyclic batch, see ecx_batch */
+typedef struct ec_batchdg
+{
+   /** command, EC_CMD_APRD, EC_CMD_FPRD, EC_CMD_FPWR etc. */
+   uint8            com;
+   /** address position, auto increment or configured address */
+   uint16           ADP;
+   /** address offset, register address */
+   uint16           ADO;
+   /** data length in bytes */
+   uint16           length;
+   /** data to write, or buffer for data read */
+   void             *data;
+   /** working counter of this datagram, set by ecx_batch */
+   uint16           wkc;
+} ec_batchdgt;
+
 /** ALstatus and ALstatus code */
 PACKED_BEGIN
 typedef struct PACKED ec_alstatus
@@ -341,6 +433,10 @@ typedef struct ec_idxstack
    void    *data[EC_MAXBUF];
    uint16  length[EC_MAXBUF];
    uint16  dcoffset[EC_MAXBUF];
+   uint16  alstatoffset[EC_MAXBUF];
+   uint8   group[EC_MAXBUF];
+   /** frame indexes reserved by frozen groups, bit per index */
+   uint32  frozen;
 } ec_idxstackT;
 
 /** ringbuf for error storage */
@@ -429,13 +525,20 @@ struct ecx_context
    /** userdata, promotes application configuration esp. in EC_VER2 with multiple 
     * ec_context instances. Note: userdata memory is managed by application, not SOEM */
    void           *userdata;
+   /** registered SII cache lookup hook, returns 1 and fills sii when cached */
+   int            (*SIIloadhook)(ecx_contextt * context, uint16 slave, ec_siicachet * sii);
+   /** registered SII cache store hook, called with freshly parsed SII */
+   void           (*SIIstorehook)(ecx_contextt * context, uint16 slave, const ec_siicachet * sii);
+   /** flag to attach to a line that is already configured and running, slaves
+    * are not reset to INIT and no state, SM mailbox or DC offset writes are done */
+   int            warmstart;
 };
 
 #ifdef EC_VER1
 /** global struct to hold default master context */
 extern ecx_contextt  ecx_context;
 /** main slave data structure array */
-extern ec_slavet   ec_slave[EC_MAXSLAVE];
+extern ec_slavet   *ec_slave;
 /** number of slaves found by configuration function */
 extern int         ec_slavecount;
 /** slave group structure */
@@ -449,6 +552,7 @@ boolean ec_iserror(void);
 void ec_packeterror(uint16 Slave, uint16 Index, uint8 SubIdx, uint16 ErrorCode);
 int ec_init(const char * ifname);
 int ec_init_redundant(const char *ifname, char *if2name);
+int ec_sizeslaves(int slavecount);
 void ec_close(void);
 uint8 ec_siigetbyte(uint16 slave, uint16 address);
 int16 ec_siifind(uint16 slave, uint16 cat);
@@ -474,6 +578,9 @@ uint64 ec_readeepromFP(uint16 configadr, uint16 eeproma, int timeout);
 int ec_writeeepromFP(uint16 configadr, uint16 eeproma, uint16 data, int timeout);
 void ec_readeeprom1(uint16 slave, uint16 eeproma);
 uint32 ec_readeeprom2(uint16 slave, int timeout);
+int ec_readeeprom_multi(int n, const uint16 *slavelst, const uint16 *addrlst, uint64 *datalst, int timeout);
+int ec_batch(int n, ec_batchdgt *dglst, int timeout);
+int ec_SIIdefinehook(void *loadhook, void *storehook);
 int ec_send_processdata_group(uint8 group);
 int ec_send_overlap_processdata_group(uint8 group);
 int ec_receive_processdata_group(uint8 group, int timeout);
@@ -517,12 +624,18 @@ uint64 ecx_readeepromFP(ecx_contextt *context, uint16 configadr, uint16 eeproma,
 int ecx_writeeepromFP(ecx_contextt *context, uint16 configadr, uint16 eeproma, uint16 data, int timeout);
 void ecx_readeeprom1(ecx_contextt *context, uint16 slave, uint16 eeproma);
 uint32 ecx_readeeprom2(ecx_contextt *context, uint16 slave, int timeout);
+int ecx_readeeprom_multi(ecx_contextt *context, int n, const uint16 *slavelst, const uint16 *addrlst, uint64 *datalst, int timeout);
+int ecx_batch(ecx_contextt *context, int n, ec_batchdgt *dglst, int timeout);
+int ecx_SIIdefinehook(ecx_contextt *context, void *loadhook, void *storehook);
 int ecx_send_overlap_processdata_group(ecx_contextt *context, uint8 group);
 int ecx_receive_processdata_group(ecx_contextt *context, uint8 group, int timeout);
 int ecx_send_processdata(ecx_contextt *context);
 int ecx_send_overlap_processdata(ecx_contextt *context);
 int ecx_receive_processdata(ecx_contextt *context, int timeout);
 int ecx_send_processdata_group(ecx_contextt *context, uint8 group);
+int ecx_freeze_processdata_group(ecx_contextt *context, uint8 group);
+void ecx_unfreeze_processdata_group(ecx_contextt *context, uint8 group);
+int ecx_send_frozen_processdata_group(ecx_contextt *context, uint8 group);
 
 #ifdef __cplusplus
 }
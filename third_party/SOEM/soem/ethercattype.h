@@ -183,7 +183,9 @@ typedef enum
    /** Received, but not consumed */
    EC_BUF_RCVD         = 0x03,
    /** Cycle completed */
-   EC_BUF_COMPLETE     = 0x04
+   EC_BUF_COMPLETE     = 0x04,
+   /** Reserved by a frozen process data frame, never handed out by ecx_getindex */
+   EC_BUF_FROZEN       = 0x05
 } ec_bufstate;
 
 /** Ethercat data types */
@@ -292,12 +294,15 @@ enum
    /** SII category SM */
    ECT_SII_SM          = 41,
    /** SII category PDO */
-   ECT_SII_PDO         = 50
+   ECT_SII_PDO         = 50,
+   /** SII end of categories marker */
+   ECT_SII_END         = 0xffff
 };
 
 /** Item offsets in SII general section */
 enum
 {
+   ECT_SII_CRC         = 0x0007,
    ECT_SII_MANUF       = 0x0008,
    ECT_SII_ID          = 0x000a,
    ECT_SII_REV         = 0x000c,
@@ -391,6 +396,7 @@ enum
 enum
 {
    ECT_REG_TYPE        = 0x0000,
+   ECT_REG_FMMUSUP     = 0x0004,
    ECT_REG_PORTDES     = 0x0007,
    ECT_REG_ESCSUP      = 0x0008,
    ECT_REG_STADR       = 0x0010,